@@ -0,0 +1,245 @@
+// bench/BenchHarness.h
+//
+// A small self-contained benchmark runner for the suites in bench/. Micro
+// benchmarks are run with a growing iteration count until one run takes at
+// least --min-time seconds, then reported per iteration; macro workloads run
+// once and report their total time and throughput. Results print as a table,
+// or with --json[=file] in Google Benchmark's JSON format, so its
+// compare.py can diff two runs. --filter=<text> runs only the benchmarks
+// whose name contains the text, and --scale=<x> multiplies the size of the
+// macro workloads (--scale=0.1 for a quick run). Wall time is reported as
+// real_time and the process's CPU time (every thread, from
+// CLOCK_PROCESS_CPUTIME_ID) as cpu_time, so a multi-threaded benchmark can
+// show more CPU than wall time.
+
+#ifndef BENCHHARNESS_H
+#define BENCHHARNESS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Passed to a benchmark body. The time between pause() and resume() is left
+// out, for setup that should not count.
+class BenchState
+{
+private:
+    chrono::steady_clock::time_point started;
+    double cpuStarted = 0;
+    double elapsed = 0;
+    double cpuElapsed = 0;
+    bool running = false;
+
+    static double processCpuSeconds()
+    {
+        timespec now;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+        return now.tv_sec + now.tv_nsec * 1e-9;
+    }
+
+public:
+    const size_t iterations;
+    // Items processed, for items_per_second; defaults to iterations
+    size_t items;
+
+    explicit BenchState(size_t iterations) : iterations(iterations), items(iterations) {}
+
+    void resume()
+    {
+        if (running)
+            return;
+        running = true;
+        cpuStarted = processCpuSeconds();
+        started = chrono::steady_clock::now();
+    }
+
+    void pause()
+    {
+        if (!running)
+            return;
+        running = false;
+        elapsed += chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        cpuElapsed += processCpuSeconds() - cpuStarted;
+    }
+
+    double seconds()
+    {
+        pause();
+        return elapsed;
+    }
+
+    double cpuSeconds()
+    {
+        pause();
+        return cpuElapsed;
+    }
+};
+
+class BenchSuite
+{
+private:
+    struct Result
+    {
+        string name;
+        size_t iterations;
+        double nanosPerIteration;
+        double cpuNanosPerIteration;
+        double itemsPerSecond;
+    };
+
+    string program;
+    string filter;
+    string jsonPath;
+    bool json = false;
+    double minTime = 0.5;
+    double sizeScale = 1;
+    vector<Result> results;
+
+    bool selected(const string &name) const { return filter.empty() || name.find(filter) != string::npos; }
+
+    static string escape(const string &text)
+    {
+        string escaped;
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    void report(const Result &result)
+    {
+        results.push_back(result);
+        if (json)
+            return;
+        cout << left << setw(40) << result.name << right << setw(14) << fixed << setprecision(1)
+             << result.nanosPerIteration << " ns" << setw(14) << result.cpuNanosPerIteration << " ns cpu" << setw(12) << result.iterations
+             << setw(16) << setprecision(0) << result.itemsPerSecond << " items/s" << endl;
+    }
+
+    void writeJson(ostream &out) const
+    {
+        time_t now = time(nullptr);
+        char date[64];
+        strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&now));
+        out << "{\n  \"context\": {\n"
+            << "    \"date\": \"" << date << "\",\n"
+            << "    \"executable\": \"" << escape(program) << "\",\n"
+            << "    \"num_cpus\": " << thread::hardware_concurrency() << ",\n"
+#ifdef NDEBUG
+            << "    \"library_build_type\": \"release\"\n"
+#else
+            << "    \"library_build_type\": \"debug\"\n"
+#endif
+            << "  },\n  \"benchmarks\": [";
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const Result &result = results[i];
+            out << (i ? "," : "") << "\n    {\n"
+                << "      \"name\": \"" << escape(result.name) << "\",\n"
+                << "      \"run_name\": \"" << escape(result.name) << "\",\n"
+                << "      \"run_type\": \"iteration\",\n"
+                << "      \"iterations\": " << result.iterations << ",\n"
+                << "      \"real_time\": " << setprecision(3) << fixed << result.nanosPerIteration << ",\n"
+                << "      \"cpu_time\": " << result.cpuNanosPerIteration << ",\n"
+                << "      \"time_unit\": \"ns\",\n"
+                << "      \"items_per_second\": " << result.itemsPerSecond << "\n    }";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+public:
+    BenchSuite(int argc, char **argv) : program(argc > 0 ? argv[0] : "bench")
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            string arg = argv[i];
+            if (arg == "--json")
+                json = true;
+            else if (arg.rfind("--json=", 0) == 0)
+            {
+                json = true;
+                jsonPath = arg.substr(7);
+            }
+            else if (arg.rfind("--filter=", 0) == 0)
+                filter = arg.substr(9);
+            else if (arg.rfind("--min-time=", 0) == 0)
+                minTime = atof(arg.c_str() + 11);
+            else if (arg.rfind("--scale=", 0) == 0)
+                sizeScale = max(0.001, atof(arg.c_str() + 8));
+            else
+                cerr << "Ignoring unknown option " << arg << endl;
+        }
+    }
+
+    // count scaled by --scale, at least 1
+    size_t scaled(size_t count) const { return max(size_t(1), size_t(count * sizeScale)); }
+
+    void micro(const string &name, const function<void(BenchState &)> &body)
+    {
+        if (!selected(name))
+            return;
+        size_t iterations = 1;
+        while (true)
+        {
+            BenchState state(iterations);
+            state.resume();
+            body(state);
+            double seconds = state.seconds();
+            if (seconds >= minTime || iterations >= (size_t(1) << 30))
+            {
+                report({name, iterations, seconds * 1e9 / iterations, state.cpuSeconds() * 1e9 / iterations,
+                        state.items / seconds});
+                return;
+            }
+            // Aim past minTime, growing at most 10x per round like Google Benchmark
+            double scale = seconds > 0 ? minTime * 1.4 / seconds : 10;
+            iterations = size_t(iterations * min(10.0, max(2.0, scale)));
+        }
+    }
+
+    void macro(const string &name, const function<void(BenchState &)> &body)
+    {
+        if (!selected(name))
+            return;
+        BenchState state(1);
+        state.resume();
+        body(state);
+        double seconds = state.seconds();
+        report({name, 1, seconds * 1e9, state.cpuSeconds() * 1e9, state.items / seconds});
+    }
+
+    int finish()
+    {
+        if (!json)
+            return 0;
+        if (jsonPath.empty())
+        {
+            writeJson(cout);
+            return 0;
+        }
+        ofstream out(jsonPath);
+        writeJson(out);
+        if (!out)
+        {
+            cerr << "Could not write " << jsonPath << endl;
+            return 1;
+        }
+        return 0;
+    }
+};
+
+#endif
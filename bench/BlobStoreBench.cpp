@@ -0,0 +1,127 @@
+// bench/BlobStoreBench.cpp
+//
+// Content deduplication: memory used by a corpus where thousands of files
+// share a small set of payloads, and the cost of hashing on every write.
+//
+// Built by `make bench` as build/bench/BlobStoreBench.
+
+#include "../include/storage/Storage.h"
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace std;
+
+static const int CORPUS_FILES = 100000;
+static const int DISTINCT_PAYLOADS = 200;
+static const int UNIQUE_EVERY = 50;
+static const size_t PAYLOAD_BYTES = 4096;
+
+static ostream quiet(nullptr);
+
+static size_t residentBytes()
+{
+    size_t pages = 0, resident = 0;
+    ifstream("/proc/self/statm") >> pages >> resident;
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+static string payload(size_t bytes, int seed)
+{
+    string data(bytes, ' ');
+    uint64_t state = seed * 2654435761ULL + 1;
+    for (char &c : data)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        c = 'a' + (state >> 59);
+    }
+    return data;
+}
+
+static void corpus()
+{
+    size_t before = residentBytes();
+    Storage store;
+    Session session = store.openSession(quiet);
+    vector<string> payloads;
+    for (int i = 0; i < DISTINCT_PAYLOADS; i++)
+        payloads.push_back(payload(PAYLOAD_BYTES, i));
+
+    vector<string> none;
+    size_t skipped;
+    for (int made = 0, folder = 0; made < CORPUS_FILES; folder++)
+    {
+        vector<pair<string, string>> noFiles;
+        string folderId = store.insertBatch(store.getRootFolderId(), {"d" + to_string(folder)}, noFiles, skipped)[0];
+        vector<pair<string, string>> files;
+        for (int j = 0; j < 1000 && made < CORPUS_FILES; j++, made++)
+            files.emplace_back("f" + to_string(j), made % UNIQUE_EVERY == 0 ? payload(PAYLOAD_BYTES, -made) : payloads[made % DISTINCT_PAYLOADS]);
+        store.insertBatch(folderId, none, files, skipped);
+    }
+    size_t after = residentBytes();
+    BlobStats stats = store.getBlobStore().getStats();
+    cout << "Corpus: " << CORPUS_FILES << " files of " << PAYLOAD_BYTES << " bytes, " << DISTINCT_PAYLOADS
+         << " shared payloads, every " << UNIQUE_EVERY << "th file unique" << endl;
+    cout << "  logical content   " << setw(10) << stats.logicalBytes / 1024 << " KiB" << endl;
+    cout << "  stored in blobs   " << setw(10) << stats.storedBytes / 1024 << " KiB (" << stats.blobs << " blobs)" << endl;
+    cout << "  content saved     " << setw(10) << fixed << setprecision(1)
+         << 100.0 * (stats.logicalBytes - stats.storedBytes) / stats.logicalBytes << " %" << endl;
+    cout << "  process RSS grew  " << setw(10) << (after - before) / 1024 << " KiB" << endl;
+}
+
+static double nanosPer(int iterations, const function<void(int)> &body)
+{
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        body(i);
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / iterations;
+}
+
+static void writeCost()
+{
+    cout << endl
+         << "Per write" << setw(14) << "hash ns" << setw(12) << "hash GB/s" << setw(16) << "new write ns" << setw(16) << "dup write ns" << setw(10) << "hash %" << endl;
+    for (size_t bytes : {64, 1024, 16384, 262144, 1048576})
+    {
+        int iterations = max(200, int((64 << 20) / bytes));
+        string data = payload(bytes, 7);
+        volatile uint64_t sink = 0;
+        double hashNanos = nanosPer(iterations, [&](int)
+                                    { sink = sink + BlobStore::hash(data); });
+
+        Storage store;
+        Session session = store.openSession(quiet);
+        store.addFile(session, "target", store.getRootFolderId());
+        // Unique contents: every write interns a new blob
+        vector<string> variants;
+        for (int i = 0; i < 64; i++)
+        {
+            variants.push_back(data);
+            variants.back()[0] = char('A' + i);
+        }
+        double newNanos = nanosPer(iterations, [&](int i)
+                                   {
+            string next = variants[i % 64];
+            next[1] = char(i);
+            next[2] = char(i >> 8);
+            store.addContent(session, "target", move(next)); });
+        // The same contents every time: hit path, which also compares bytes
+        double dupNanos = nanosPer(iterations, [&](int)
+                                   { store.addContent(session, "target", data); });
+        cout << setw(9) << bytes << setw(14) << setprecision(0) << hashNanos << setw(12) << setprecision(2)
+             << bytes / hashNanos << setw(16) << setprecision(0) << newNanos << setw(16) << dupNanos
+             << setw(10) << setprecision(1) << 100 * hashNanos / newNanos << endl;
+    }
+}
+
+int main()
+{
+    corpus();
+    writeCost();
+    return 0;
+}
@@ -0,0 +1,102 @@
+// bench/ColdTierBench.cpp
+//
+// Memory saved by the cold content tier on a text corpus, and what it costs
+// to read cold contents back. The corpus is a host directory (default
+// /usr/include) imported into Storage; one compaction pass then compresses
+// every content of at least 4 KiB, and reads are timed for cold contents
+// (decompressed on the read), cached ones, and hot ones for comparison.
+//
+// Built by `make bench` as build/bench/ColdTierBench.
+// Run:   build/bench/ColdTierBench [host directory]
+
+#include "../include/services/ImportService.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static const size_t MIN_BYTES = 4096;
+// Sized so the sampled contents fit in the default 64 MiB read cache
+static const int SAMPLES = 2000;
+
+static ostream quiet(nullptr);
+
+static void printPercentiles(const string &name, vector<double> &micros)
+{
+    sort(micros.begin(), micros.end());
+    auto at = [&](double q)
+    { return micros[min(micros.size() - 1, size_t(q * micros.size()))]; };
+    cout << setw(22) << name << setw(10) << fixed << setprecision(2) << at(0.5) << setw(10) << at(0.99)
+         << setw(10) << micros.back() << endl;
+}
+
+static vector<double> timeReads(Storage &store, const vector<string> &ids)
+{
+    vector<double> micros;
+    Storage::ReadGuard guard(store);
+    volatile size_t sink = 0;
+    for (const string &id : ids)
+    {
+        File *file = store.getFile(id);
+        auto start = chrono::steady_clock::now();
+        sink = sink + file->getContent()->size();
+        micros.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+    }
+    return micros;
+}
+
+static void printStats(const string &when, const BlobStats &stats)
+{
+    size_t resident = stats.hotBytes + stats.packedBytes + stats.cachedBytes;
+    cout << setw(18) << when << setw(14) << stats.storedBytes / 1024 << setw(14) << resident / 1024
+         << setw(10) << setprecision(2) << double(stats.storedBytes) / resident << setw(10) << stats.coldBlobs << endl;
+}
+
+int main(int argc, char **argv)
+{
+    string corpus = argc > 1 ? argv[1] : "/usr/include";
+    Storage store;
+    Session session = store.openSession(quiet);
+    ImportService(store, session).importTree(corpus);
+
+    vector<string> large;
+    {
+        Storage::ReadGuard guard(store);
+        for (auto &entry : store.getAllFiles())
+            if (entry.second->getContent()->size() >= MIN_BYTES)
+                large.push_back(entry.first);
+    }
+    mt19937 random(7);
+    shuffle(large.begin(), large.end(), random);
+    if (large.size() > SAMPLES)
+        large.resize(SAMPLES);
+
+    cout << fixed << "Corpus " << corpus << endl;
+    cout << setw(18) << "" << setw(14) << "content KiB" << setw(14) << "resident KiB" << setw(10) << "ratio" << setw(10) << "cold" << endl;
+    printStats("before", store.getBlobStore().getStats());
+
+    vector<double> hot = timeReads(store, large);
+    auto start = chrono::steady_clock::now();
+    size_t compacted = store.compactColdContent(MIN_BYTES, 0);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    BlobStats packed = store.getBlobStore().getStats();
+    printStats("after compaction", packed);
+    cout << "Compacted " << compacted << " blobs in " << setprecision(2) << seconds << " s ("
+         << setprecision(0) << (packed.storedBytes - packed.hotBytes) / seconds / (1 << 20) << " MiB/s)" << endl
+         << endl;
+
+    cout << setw(22) << "read latency (us)" << setw(10) << "p50" << setw(10) << "p99" << setw(10) << "max" << endl;
+    printPercentiles("hot", hot);
+    vector<double> cold = timeReads(store, large);
+    printPercentiles("cold (decompress)", cold);
+    vector<double> cached = timeReads(store, large);
+    printPercentiles("cached", cached);
+    cout << endl;
+    printStats("with read cache", store.getBlobStore().getStats());
+    return 0;
+}
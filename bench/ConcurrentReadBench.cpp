@@ -0,0 +1,117 @@
+// bench/ConcurrentReadBench.cpp
+//
+// Stress test for the Storage reader-writer lock: N reader threads run a mix
+// of ls, getPath, tree and grep against one shared Storage while a single
+// writer keeps creating, writing and removing files. Reports read throughput
+// for 1 to 32 reader threads.
+//
+// Built by `make bench` as build/bench/ConcurrentReadBench.
+
+#include "../include/storage/Storage.h"
+#include "../include/services/GrepService.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static const int FOLDERS = 50;
+static const int FILES_PER_FOLDER = 50;
+static const double SECONDS_PER_RUN = 0.5;
+
+static ostream quiet(nullptr);
+
+static void populate(Storage &store, vector<string> &folderIds)
+{
+    Session session = store.openSession(quiet);
+    string root = session.getCurrentFolderId();
+    for (int d = 0; d < FOLDERS; d++)
+        store.addFolder(session, "dir" + to_string(d), root);
+    folderIds = store.getFolderIdsInFolder(root);
+    for (const string &folderId : folderIds)
+        for (int f = 0; f < FILES_PER_FOLDER; f++)
+            store.addFile(session, "file" + to_string(f) + ".txt", folderId);
+}
+
+static void readOnce(Storage &store, Session &session, GrepService &grep, const vector<string> &folderIds, unsigned &seed)
+{
+    seed = seed * 1103515245u + 12345u;
+    const string &folderId = folderIds[(seed >> 8) % folderIds.size()];
+    switch ((seed >> 4) % 16)
+    {
+    case 0:
+        grep.grep("needle");
+        break;
+    case 1:
+        store.showFolderTree(session);
+        break;
+    default:
+        if (seed & 1)
+            store.getPath(folderId);
+        else
+            store.showItemsInFolder(session, folderId);
+    }
+}
+
+static double run(Storage &store, const vector<string> &folderIds, int readers)
+{
+    atomic<bool> stop(false);
+    atomic<long long> reads(0);
+
+    thread writer([&]() {
+        Session session = store.openSession(quiet);
+        string root = session.getCurrentFolderId();
+        for (long long i = 0; !stop; i++)
+        {
+            string name = "scratch" + to_string(i % 64) + ".log";
+            store.addFile(session, name, root);
+            store.addContent(session, name, "needle " + to_string(i));
+            store.removeFile(session, name);
+        }
+    });
+
+    vector<thread> threads;
+    for (int r = 0; r < readers; r++)
+    {
+        threads.emplace_back([&, r]() {
+            Session session = store.openSession(quiet);
+            GrepService grep(store, session);
+            unsigned seed = 7919u * (r + 1);
+            long long local = 0;
+            while (!stop)
+            {
+                readOnce(store, session, grep, folderIds, seed);
+                local++;
+            }
+            reads += local;
+        });
+    }
+
+    this_thread::sleep_for(chrono::duration<double>(SECONDS_PER_RUN));
+    stop = true;
+    for (auto &t : threads)
+        t.join();
+    writer.join();
+    return reads / SECONDS_PER_RUN;
+}
+
+int main()
+{
+    Storage store;
+    vector<string> folderIds;
+    populate(store, folderIds);
+
+    cout << "Readers  Reads/sec     Scaling" << endl;
+    double base = 0;
+    for (int readers = 1; readers <= 32; readers *= 2)
+    {
+        double rate = run(store, folderIds, readers);
+        if (readers == 1)
+            base = rate;
+        cout << readers << "\t " << (long long)rate << "\t" << rate / base << "x" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+// bench/ExportBench.cpp
+//
+// Export throughput for an in-memory tree: to a host directory with 1 and N
+// writer threads, and as a streamed tar archive.
+//
+// Built by `make bench` as build/bench/ExportBench.
+// Run:   build/bench/ExportBench [scratch directory, default /tmp] [files, default 50000]
+
+#include "../include/services/ExportService.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static const int FILES_PER_FOLDER = 100;
+
+static ostream quiet(nullptr);
+
+static size_t populate(Storage &store, int fileCount)
+{
+    size_t bytes = 0;
+    vector<string> none;
+    size_t skipped;
+    for (int made = 0, folder = 0; made < fileCount; folder++)
+    {
+        vector<pair<string, string>> noFiles;
+        string folderId = store.insertBatch(store.getRootFolderId(), {"d" + to_string(folder)}, noFiles, skipped)[0];
+        vector<pair<string, string>> files;
+        for (int j = 0; j < FILES_PER_FOLDER && made < fileCount; j++, made++)
+        {
+            files.emplace_back("f" + to_string(j) + ".txt", string((made * 37) % 4000 + 100, char('a' + made % 26)));
+            bytes += files.back().second.size();
+        }
+        store.insertBatch(folderId, none, files, skipped);
+    }
+    return bytes;
+}
+
+int main(int argc, char **argv)
+{
+    string scratch = argc > 1 ? argv[1] : "/tmp";
+    int fileCount = argc > 2 ? atoi(argv[2]) : 50000;
+    Storage store;
+    size_t bytes = populate(store, fileCount);
+    Session session = store.openSession(quiet);
+    ExportService exporter(store, session);
+    cout << fileCount << " files, " << bytes / (1 << 20) << " MiB" << endl;
+    cout << setw(14) << "target" << setw(12) << "files/s" << setw(10) << "MiB/s" << setw(10) << "seconds" << endl;
+
+    int threads = max(4u, thread::hardware_concurrency() * 2);
+    vector<pair<string, int>> runs = {{"directory", 1}, {"directory", threads}, {"tar", 0}};
+    for (auto &run : runs)
+    {
+        string target = scratch + "/export_bench" + (run.first == "tar" ? ".tar" : "");
+        system(("rm -rf " + target).c_str());
+        auto start = chrono::steady_clock::now();
+        exporter.exportTree(target, run.second);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        string name = run.first == "tar" ? "tar" : "dir x" + to_string(run.second);
+        cout << setw(14) << name << setw(12) << fixed << setprecision(0) << fileCount / seconds
+             << setw(10) << setprecision(1) << bytes / seconds / (1 << 20) << setw(10) << setprecision(3) << seconds << endl;
+        system(("rm -rf " + target).c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,135 @@
+// bench/ImportBench.cpp
+//
+// Import throughput for a generated host tree. "read only" walks the tree
+// and reads every file without touching Storage, which is the ceiling set by
+// the disk (or page cache); "commands" inserts the same data one
+// createFolder/createFile/addContent call at a time, the way a REPL script
+// would; "import" runs ImportService with 1 and N threads.
+//
+// Built by `make bench` as build/bench/ImportBench.
+// Run:   build/bench/ImportBench [scratch directory, default /tmp] [files, default 50000]
+
+#include "../include/services/FileSystemService.h"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+static const int FILES_PER_FOLDER = 100;
+static const int FOLDERS_PER_LEVEL = 8;
+
+static ostream quiet(nullptr);
+
+struct HostTree
+{
+    string root;
+    vector<string> folders; // relative to root, parents first
+    vector<string> files;   // relative to root
+    size_t bytes = 0;
+};
+
+static HostTree generate(const string &scratch, int fileCount)
+{
+    HostTree tree;
+    tree.root = scratch + "/import_bench_tree";
+    system(("rm -rf " + tree.root).c_str());
+    mkdir(tree.root.c_str(), 0755);
+    vector<string> frontier = {""};
+    int made = 0;
+    while (made < fileCount)
+    {
+        vector<string> nextFrontier;
+        for (const string &parent : frontier)
+        {
+            for (int i = 0; i < FOLDERS_PER_LEVEL && made < fileCount; i++)
+            {
+                string folder = parent + "/d" + to_string(i);
+                mkdir((tree.root + folder).c_str(), 0755);
+                tree.folders.push_back(folder);
+                nextFrontier.push_back(folder);
+                for (int j = 0; j < FILES_PER_FOLDER && made < fileCount; j++, made++)
+                {
+                    string file = folder + "/f" + to_string(j) + ".txt";
+                    string content((made * 37) % 4000 + 100, char('a' + made % 26));
+                    ofstream(tree.root + file) << content;
+                    tree.files.push_back(file);
+                    tree.bytes += content.size();
+                }
+            }
+        }
+        frontier = nextFrontier;
+    }
+    return tree;
+}
+
+static double timed(const function<void()> &body)
+{
+    auto start = chrono::steady_clock::now();
+    body();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static void report(const string &name, const HostTree &tree, double seconds)
+{
+    cout << setw(18) << name << setw(12) << fixed << setprecision(0) << tree.files.size() / seconds
+         << setw(10) << setprecision(1) << tree.bytes / seconds / (1 << 20) << setw(10) << setprecision(3) << seconds << endl;
+}
+
+int main(int argc, char **argv)
+{
+    string scratch = argc > 1 ? argv[1] : "/tmp";
+    int fileCount = argc > 2 ? atoi(argv[2]) : 50000;
+    HostTree tree = generate(scratch, fileCount);
+    cout << tree.files.size() << " files, " << tree.folders.size() << " folders, " << tree.bytes / (1 << 20) << " MiB" << endl;
+    cout << setw(18) << "mode" << setw(12) << "files/s" << setw(10) << "MiB/s" << setw(10) << "seconds" << endl;
+
+    report("read only", tree, timed([&]
+                                    {
+        string content;
+        for (const string &file : tree.files)
+        {
+            int fd = open((tree.root + file).c_str(), O_RDONLY);
+            struct stat info;
+            fstat(fd, &info);
+            content.resize(info.st_size);
+            read(fd, &content[0], content.size());
+            close(fd);
+        } }));
+
+    report("commands", tree, timed([&]
+                                   {
+        FileSystemService fileSystem(quiet);
+        string root = fileSystem.getCurrentFolder();
+        fileSystem.createFolder(root, "import_bench_tree");
+        for (const string &folder : tree.folders)
+            fileSystem.createFolder(root, "import_bench_tree" + folder);
+        for (const string &file : tree.files)
+        {
+            ifstream in(tree.root + file, ios::binary);
+            string content((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+            fileSystem.createFile(root, "import_bench_tree" + file);
+            fileSystem.addContent("import_bench_tree" + file, content);
+        } }));
+
+    int threads = max(4u, thread::hardware_concurrency() * 2);
+    for (int count : {1, threads})
+        report("import x" + to_string(count), tree, timed([&]
+                                                          {
+            Storage store;
+            Session session = store.openSession(quiet);
+            ImportService importer(store, session);
+            importer.importTree(tree.root, count); }));
+
+    system(("rm -rf " + tree.root).c_str());
+    return 0;
+}
@@ -0,0 +1,245 @@
+// bench/MacroBench.cpp
+//
+// Whole workloads, each timed once end to end:
+//   macro/build_tree       mkdir and touch a tree of 1M nodes (100 files per folder)
+//   macro/rmdir_wide       rmdir of that tree from the top
+//   macro/rmdir_deep       rmdir of a 2000-level chain with a file on each level
+//   macro/cd_ls_grep_mix   random cd / ls / grep / cat commands, dispatched
+//                          through the CommandRegistry like typed input
+//   macro/rm_each_wide     rm of half the files of a 100k-file folder, one
+//                          command per file
+//   macro/rm_glob_wide     the same files removed with one rm *.log
+//   macro/find_tree/N      find -name "file1*" -ext txt over a 1M-node tree
+//                          with N threads
+//   macro/locate/prefix    locate of the one name starting with "needle" in
+//                          a 1M-node tree
+//   macro/locate/ext       locate *.log, the one file with that extension
+//   macro/mv_tree          mv of a folder holding a 1M-node tree into a
+//                          sibling folder, renaming it on the way
+//   macro/cp_tree          cp -r of a 100k-node tree whose files all have
+//                          content, which the copy shares
+// items_per_second counts nodes (or commands for the mix). --scale shrinks or
+// grows every workload; see BenchHarness.h for the other options.
+//
+// Built by `make bench` as build/bench/MacroBench.
+// Run:   build/bench/MacroBench [--json=macro.json] [--scale=0.1]
+
+#include "BenchHarness.h"
+#include "../include/commands/Commands.h"
+#include "../include/commands/CommandRegistry.h"
+#include "../include/services/FileSystemService.h"
+#include "../include/services/FindService.h"
+#include "../include/storage/Storage.h"
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static const size_t TREE_NODES = 1000000;
+static const size_t FILES_PER_FOLDER = 100;
+static const size_t FOLDERS_PER_FOLDER = 10;
+static const size_t CHAIN_DEPTH = 2000;
+static const size_t MIX_COMMANDS = 200000;
+static const size_t MIX_FOLDERS = 1000;
+static const size_t WIDE_FILES = 100000;
+static const size_t COPY_NODES = 100000;
+
+static ostream quiet(nullptr);
+
+// Breadth-first tree of about `nodes` nodes below folder `top`: each folder
+// holds FILES_PER_FOLDER files and up to FOLDERS_PER_FOLDER subfolders. Ids
+// are passed directly, so no path is resolved. Returns the folder ids.
+static vector<string> buildTree(Storage &store, Session &session, const string &top, size_t nodes)
+{
+    vector<string> folders = {top};
+    size_t created = 1;
+    for (size_t next = 0; next < folders.size() && created < nodes; next++)
+    {
+        for (size_t i = 0; i < FILES_PER_FOLDER && created < nodes; i++, created++)
+            store.addFile(session, "file" + to_string(i) + ".txt", folders[next]);
+        for (size_t i = 0; i < FOLDERS_PER_FOLDER && created < nodes; i++, created++)
+        {
+            folders.push_back(store.getNewFolderId());
+            store.addFolder(session, "dir" + to_string(i), folders[next]);
+        }
+    }
+    return folders;
+}
+
+int main(int argc, char **argv)
+{
+    BenchSuite suite(argc, argv);
+    size_t treeNodes = suite.scaled(TREE_NODES);
+
+    suite.macro("macro/build_tree", [treeNodes](BenchState &state)
+                {
+        Storage store;
+        Session session = store.openSession(quiet);
+        buildTree(store, session, store.getRootFolderId(), treeNodes);
+        state.items = treeNodes;
+        state.pause(); });
+
+    suite.macro("macro/rmdir_wide", [treeNodes](BenchState &state)
+                {
+        state.pause();
+        Storage store;
+        Session session = store.openSession(quiet);
+        string top = store.getNewFolderId();
+        store.addFolder(session, "top", store.getRootFolderId());
+        buildTree(store, session, top, treeNodes);
+        state.resume();
+        store.removeFolder(session, "top");
+        state.items = treeNodes;
+        state.pause(); });
+
+    size_t depth = suite.scaled(CHAIN_DEPTH);
+    suite.macro("macro/rmdir_deep", [depth](BenchState &state)
+                {
+        state.pause();
+        Storage store;
+        Session session = store.openSession(quiet);
+        string id = store.getRootFolderId();
+        for (size_t i = 0; i < depth; i++)
+        {
+            string child = store.getNewFolderId();
+            store.addFolder(session, "level" + to_string(i), id);
+            store.addFile(session, "notes.txt", child);
+            id = child;
+        }
+        state.resume();
+        store.removeFolder(session, "level0");
+        state.items = 2 * depth;
+        state.pause(); });
+
+    size_t commands = suite.scaled(MIX_COMMANDS);
+    size_t mixFolders = suite.scaled(MIX_FOLDERS);
+    suite.macro("macro/cd_ls_grep_mix", [commands, mixFolders](BenchState &state)
+                {
+        state.pause();
+        FileSystemService fileSystem(quiet);
+        Storage &store = fileSystem.getStorage();
+        vector<string> folders = buildTree(store, fileSystem.getSession(), store.getRootFolderId(), mixFolders * (FILES_PER_FOLDER + 1));
+        // getPath gives "BaseFolder/a/b/"; commands take "/a/b/"
+        size_t rootLength = store.getPath(store.getRootFolderId()).size();
+        vector<string> paths;
+        for (const string &id : folders)
+            paths.push_back("/" + store.getPath(id).substr(rootLength));
+        // A few lines in every tenth file of each folder
+        for (const string &path : paths)
+            for (size_t i = 0; i < FILES_PER_FOLDER; i += 10)
+                store.addContent(fileSystem.getSession(), path + "file" + to_string(i) + ".txt",
+                                 "first line\nsecond line with a needle\nthird line " + to_string(i) + "\n");
+        CommandRegistry registry;
+        registerBuiltinCommands(registry);
+        mt19937 random(42);
+        vector<string> lines;
+        lines.reserve(commands);
+        for (size_t i = 0; i < commands; i++)
+        {
+            // 40% cd, 30% ls, 20% cat, 10% grep in the current folder
+            size_t pick = random() % 10;
+            const string &path = paths[random() % paths.size()];
+            if (pick < 4)
+                lines.push_back("cd " + path);
+            else if (pick < 7)
+                lines.push_back("ls");
+            else if (pick < 9)
+                lines.push_back("cat file" + to_string(random() % FILES_PER_FOLDER / 10 * 10) + ".txt");
+            else
+                lines.push_back("grep needle");
+        }
+        state.resume();
+        for (const string &line : lines)
+            registry.execute(&fileSystem, line);
+        state.items = commands;
+        state.pause(); });
+
+    // Half the files are .log, interleaved with the .txt ones by name
+    size_t wideFiles = suite.scaled(WIDE_FILES);
+    for (bool glob : {false, true})
+        suite.macro(glob ? "macro/rm_glob_wide" : "macro/rm_each_wide", [wideFiles, glob](BenchState &state)
+                    {
+            state.pause();
+            Storage store;
+            Session session = store.openSession(quiet);
+            vector<pair<string, string>> files;
+            for (size_t i = 0; i < wideFiles; i++)
+                files.push_back({"item" + to_string(i) + (i % 2 ? ".log" : ".txt"), ""});
+            size_t skipped;
+            store.insertBatch(store.getRootFolderId(), {}, files, skipped);
+            state.resume();
+            if (glob)
+                store.removeMatchingFiles(session, "*.log");
+            else
+                for (size_t i = 1; i < wideFiles; i += 2)
+                    store.removeFile(session, "item" + to_string(i) + ".log");
+            state.items = wideFiles / 2;
+            state.pause(); });
+
+    for (int threads : {1, 4})
+        suite.macro("macro/find_tree/" + to_string(threads), [treeNodes, threads](BenchState &state)
+                    {
+            state.pause();
+            Storage store;
+            Session session = store.openSession(quiet);
+            buildTree(store, session, store.getRootFolderId(), treeNodes);
+            FindService finder(store, session);
+            FindOptions options;
+            options.namePattern = "file1*";
+            options.extension = "txt";
+            state.resume();
+            finder.find("/", options, threads);
+            state.items = treeNodes;
+            state.pause(); });
+
+    for (const char *query : {"prefix", "ext"})
+        suite.macro("macro/locate/" + string(query), [treeNodes, query](BenchState &state)
+                    {
+            state.pause();
+            Storage store;
+            Session session = store.openSession(quiet);
+            vector<string> folders = buildTree(store, session, store.getRootFolderId(), treeNodes);
+            store.addFile(session, "needle.log", folders.back());
+            state.resume();
+            store.locate(session, string(query) == "prefix" ? "needle" : "*.log");
+            state.items = treeNodes;
+            state.pause(); });
+
+    suite.macro("macro/mv_tree", [treeNodes](BenchState &state)
+                {
+        state.pause();
+        Storage store;
+        Session session = store.openSession(quiet);
+        string top = store.getNewFolderId();
+        store.addFolder(session, "top", store.getRootFolderId());
+        store.addFolder(session, "archive", store.getRootFolderId());
+        buildTree(store, session, top, treeNodes);
+        state.resume();
+        store.moveItem(session, "/top", "/archive/old");
+        state.items = treeNodes;
+        state.pause(); });
+
+    size_t copyNodes = suite.scaled(COPY_NODES);
+    suite.macro("macro/cp_tree", [copyNodes](BenchState &state)
+                {
+        state.pause();
+        Storage store;
+        Session session = store.openSession(quiet);
+        string top = store.getNewFolderId();
+        store.addFolder(session, "template", store.getRootFolderId());
+        vector<string> folders = buildTree(store, session, top, copyNodes);
+        size_t rootLength = store.getPath(store.getRootFolderId()).size();
+        for (const string &id : folders)
+        {
+            string path = "/" + store.getPath(id).substr(rootLength);
+            for (size_t i = 0; i < FILES_PER_FOLDER; i++)
+                store.addContent(session, path + "file" + to_string(i) + ".txt", "fixture " + to_string(i) + "\n");
+        }
+        state.resume();
+        store.copyItem(session, "/template", "/fixture", true);
+        state.items = copyNodes;
+        state.pause(); });
+
+    return suite.finish();
+}
@@ -0,0 +1,314 @@
+// bench/MicroBench.cpp
+//
+// Per-operation costs of the building blocks every command is made of:
+// Storage mutations and lookups, getPath at several depths, grep in its
+// variants, appending to the command history, timing an operation for its
+// latency histogram, trace spans and the allocation tracker. Each benchmark reports ns per
+// operation; see BenchHarness.h for the options (--json, --filter).
+// Setup and tearing down the Storage are not timed.
+//
+// Built by `make bench` as build/bench/MicroBench.
+// Run:   build/bench/MicroBench [--json=micro.json] [--filter=storage/]
+
+#include "BenchHarness.h"
+#include "../include/storage/Storage.h"
+#include "../include/services/GrepService.h"
+#include "../include/services/HistoryService.h"
+#include "../include/storage/Trace.h"
+#include "../include/storage/AllocationStats.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Files created in one folder before moving on to a new one, so the cost of
+// a create does not grow with the iteration count
+static const size_t PER_FOLDER = 64;
+
+static ostream quiet(nullptr);
+
+// Folders /d0/d1/.../d<depth-1> below the root; returns the deepest id
+static string makeChain(Storage &store, Session &session, int depth)
+{
+    string id = store.getRootFolderId();
+    for (int i = 0; i < depth; i++)
+    {
+        string child = store.getNewFolderId();
+        store.addFolder(session, "d" + to_string(i), id);
+        id = child;
+    }
+    return id;
+}
+
+static string chainPath(int depth)
+{
+    string path;
+    for (int i = 0; i < depth; i++)
+        path += "/d" + to_string(i);
+    return path;
+}
+
+// A folder "g" of files with `lines` lines each, one in ten mentioning "needle"
+static void makeGrepCorpus(Storage &store, Session &session, int files, int lines)
+{
+    string folder = store.getNewFolderId();
+    store.addFolder(session, "g", store.getRootFolderId());
+    string content;
+    for (int line = 0; line < lines; line++)
+        content += line % 10 == 3 ? "the Needle in the haystack " + to_string(line) + "\n"
+                                  : "plain text line " + to_string(line) + " of the file\n";
+    for (int i = 0; i < files; i++)
+    {
+        string name = "f" + to_string(i) + ".txt";
+        store.addFile(session, name, folder);
+        store.addContent(session, "/g/" + name, content + to_string(i));
+    }
+    string sub = store.getNewFolderId();
+    store.addFolder(session, "sub", folder);
+    for (int i = 0; i < files / 4; i++)
+    {
+        store.addFile(session, "s" + to_string(i), sub);
+        store.addContent(session, "/g/sub/s" + to_string(i), content);
+    }
+    session.setCurrentFolder(folder, store.getPath(folder));
+}
+
+static void storageBenchmarks(BenchSuite &suite)
+{
+    suite.micro("storage/touch", [](BenchState &state)
+                {
+        Storage store;
+        Session session = store.openSession(quiet);
+        string folder;
+        for (size_t i = 0; i < state.iterations; i++)
+        {
+            if (i % PER_FOLDER == 0)
+            {
+                state.pause();
+                folder = store.getNewFolderId();
+                store.addFolder(session, "d" + to_string(i), store.getRootFolderId());
+                state.resume();
+            }
+            store.addFile(session, "file" + to_string(i), folder);
+        }
+        state.pause(); });
+
+    suite.micro("storage/mkdir", [](BenchState &state)
+                {
+        Storage store;
+        Session session = store.openSession(quiet);
+        string folder;
+        for (size_t i = 0; i < state.iterations; i++)
+        {
+            if (i % PER_FOLDER == 0)
+            {
+                state.pause();
+                folder = store.getNewFolderId();
+                store.addFolder(session, "p" + to_string(i), store.getRootFolderId());
+                state.resume();
+            }
+            store.addFolder(session, "d" + to_string(i), folder);
+        }
+        state.pause(); });
+
+    suite.micro("storage/rm", [](BenchState &state)
+                {
+        Storage store;
+        Session session = store.openSession(quiet);
+        for (size_t i = 0; i < state.iterations; i++)
+        {
+            if (i % PER_FOLDER == 0)
+            {
+                state.pause();
+                for (size_t j = 0; j < PER_FOLDER; j++)
+                    store.addFile(session, "file" + to_string(i + j), store.getRootFolderId());
+                state.resume();
+            }
+            store.removeFile(session, "file" + to_string(i));
+        }
+        state.pause(); });
+
+    for (size_t bytes : {16, 4096})
+        suite.micro("storage/write_" + to_string(bytes) + "B", [bytes](BenchState &state)
+                    {
+            state.pause();
+            Storage store;
+            Session session = store.openSession(quiet);
+            store.addFile(session, "a.txt", store.getRootFolderId());
+            // Alternating contents, so every write changes the file
+            string contents[2] = {string(bytes, 'a'), string(bytes, 'b')};
+            state.resume();
+            for (size_t i = 0; i < state.iterations; i++)
+                store.addContent(session, "a.txt", contents[i & 1]);
+            state.pause(); });
+
+    suite.micro("storage/resolve_depth8", [](BenchState &state)
+                {
+        state.pause();
+        Storage store;
+        Session session = store.openSession(quiet);
+        store.addFile(session, "leaf.txt", makeChain(store, session, 8));
+        string path = chainPath(8) + "/leaf.txt";
+        state.resume();
+        for (size_t i = 0; i < state.iterations; i++)
+            store.resolveFile(session, path);
+        state.pause(); });
+
+    suite.micro("storage/ls_100", [](BenchState &state)
+                {
+        state.pause();
+        Storage store;
+        Session session = store.openSession(quiet);
+        for (int i = 0; i < 100; i++)
+            store.addFile(session, "file" + to_string(i), store.getRootFolderId());
+        state.resume();
+        for (size_t i = 0; i < state.iterations; i++)
+            store.showItemsInFolder(session, store.getRootFolderId());
+        state.pause(); });
+
+    suite.micro("storage/cat_4096B", [](BenchState &state)
+                {
+        state.pause();
+        Storage store;
+        Session session = store.openSession(quiet);
+        store.addFile(session, "a.txt", store.getRootFolderId());
+        store.addContent(session, "a.txt", string(4096, 'x'));
+        state.resume();
+        volatile size_t total = 0;
+        for (size_t i = 0; i < state.iterations; i++)
+        {
+            Storage::ReadGuard guard(store);
+            total = total + store.getFile(store.resolveFile(session, "a.txt"))->getContent()->size();
+        }
+        state.pause(); });
+}
+
+static void pathBenchmarks(BenchSuite &suite)
+{
+    for (int depth : {1, 16, 64})
+        suite.micro("path/getPath_depth" + to_string(depth), [depth](BenchState &state)
+                    {
+            state.pause();
+            Storage store;
+            Session session = store.openSession(quiet);
+            string folder = makeChain(store, session, depth);
+            state.resume();
+            for (size_t i = 0; i < state.iterations; i++)
+                store.getPath(folder);
+            state.pause(); });
+}
+
+static void grepBenchmarks(BenchSuite &suite)
+{
+    struct Variant
+    {
+        const char *name;
+        GrepOptions options;
+    };
+    vector<Variant> variants(4);
+    variants[0].name = "grep/plain";
+    variants[1].name = "grep/ignore_case";
+    variants[1].options.caseInsensitive = true;
+    variants[2].name = "grep/recursive";
+    variants[2].options.recursive = true;
+    variants[3].name = "grep/count_inverted";
+    variants[3].options.countOnly = true;
+    variants[3].options.invertMatch = true;
+    for (const Variant &variant : variants)
+    {
+        GrepOptions options = variant.options;
+        suite.micro(variant.name, [options](BenchState &state)
+                    {
+            state.pause();
+            Storage store;
+            Session session = store.openSession(quiet);
+            makeGrepCorpus(store, session, 100, 50);
+            GrepService grep(store, session);
+            state.resume();
+            for (size_t i = 0; i < state.iterations; i++)
+            {
+                if (options.recursive)
+                    grep.grepRecursive("needle", options);
+                else
+                    grep.grep(options.caseInsensitive ? "needle" : "Needle", options);
+            }
+            state.pause(); });
+    }
+}
+
+static void historyBenchmarks(BenchSuite &suite)
+{
+    // Past the first 1000 entries every append also drops the oldest
+    suite.micro("history/append", [](BenchState &state)
+                {
+        HistoryService history(quiet);
+        for (size_t i = 0; i < state.iterations; i++)
+            history.addEntry("touch notes.txt", "CREATE_FILE", "notes.txt", "BaseFolder/docs/"); });
+}
+
+static void statsBenchmarks(BenchSuite &suite)
+{
+    // What every FileSystemService operation pays for its latency histogram
+    suite.micro("stats/timer", [](BenchState &state)
+                {
+        OperationStats stats;
+        for (size_t i = 0; i < state.iterations; i++)
+            OperationStats::Timer timer(stats, OperationStats::LIST_ITEMS); });
+}
+
+static void traceBenchmarks(BenchSuite &suite)
+{
+    // A span while tracing is stopped is a load and a branch
+    suite.micro("trace/span_disabled", [](BenchState &state)
+                {
+        Tracer::stop();
+        for (size_t i = 0; i < state.iterations; i++)
+            TraceSpan span("bench", "span"); });
+
+    suite.micro("trace/span_enabled", [](BenchState &state)
+                {
+        Tracer::start();
+        for (size_t i = 0; i < state.iterations; i++)
+            TraceSpan span("bench", "span");
+        Tracer::stop(); });
+}
+
+static void allocationBenchmarks(BenchSuite &suite)
+{
+    // The volatile sink keeps the compiler from eliding the new/delete pair
+    static char *volatile sink;
+
+    // Untracked, operator new and delete add a load and a branch to malloc and free
+    suite.micro("alloc/new_delete", [](BenchState &state)
+                {
+        AllocationTracker::stop();
+        for (size_t i = 0; i < state.iterations; i++)
+        {
+            sink = new char[64];
+            delete[] sink;
+        } });
+
+    suite.micro("alloc/new_delete_tracked", [](BenchState &state)
+                {
+        AllocationTracker::start();
+        for (size_t i = 0; i < state.iterations; i++)
+        {
+            AllocationScope scope("bench");
+            sink = new char[64];
+            delete[] sink;
+        }
+        AllocationTracker::stop(); });
+}
+
+int main(int argc, char **argv)
+{
+    BenchSuite suite(argc, argv);
+    storageBenchmarks(suite);
+    pathBenchmarks(suite);
+    grepBenchmarks(suite);
+    historyBenchmarks(suite);
+    statsBenchmarks(suite);
+    traceBenchmarks(suite);
+    allocationBenchmarks(suite);
+    return suite.finish();
+}
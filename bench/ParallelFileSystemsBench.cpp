@@ -0,0 +1,81 @@
+// bench/ParallelFileSystemsBench.cpp
+//
+// Builds 64 independent simulated filesystems, first one after another and
+// then concurrently on all available cores, and reports the speedup. Each
+// FileSystemService owns its own Storage, so the parallel run shares no state.
+//
+// Built by `make bench` as build/bench/ParallelFileSystemsBench.
+
+#include "../include/services/FileSystemService.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static const int INSTANCES = 64;
+static const int FOLDERS = 20;
+static const int FILES_PER_FOLDER = 100;
+
+static void runWorkload(int instance)
+{
+    ostream quiet(nullptr);
+    FileSystemService fileSystem(quiet);
+    for (int d = 0; d < FOLDERS; d++)
+    {
+        string folder = "dir" + to_string(d);
+        fileSystem.createFolder(fileSystem.getCurrentFolder(), folder);
+        fileSystem.getIntoFolder(folder);
+        for (int f = 0; f < FILES_PER_FOLDER; f++)
+        {
+            string file = "file" + to_string(f) + ".txt";
+            fileSystem.createFile(fileSystem.getCurrentFolder(), file);
+            fileSystem.addContent(file, "tenant " + to_string(instance) + " line " + to_string(f));
+        }
+        fileSystem.listAllItems(fileSystem.getCurrentFolder());
+        fileSystem.getIntoFolder("..");
+    }
+    fileSystem.grepRecursive("line 9");
+}
+
+static double runSerial()
+{
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < INSTANCES; i++)
+        runWorkload(i);
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static double runParallel(unsigned threads)
+{
+    atomic<int> next(0);
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (unsigned t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&next]() {
+            for (int i = next++; i < INSTANCES; i = next++)
+                runWorkload(i);
+        });
+    }
+    for (auto &worker : workers)
+        worker.join();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+    unsigned threads = max(1u, thread::hardware_concurrency());
+    cout << "Instances: " << INSTANCES << ", nodes per instance: " << FOLDERS * (FILES_PER_FOLDER + 1) << endl;
+
+    double serial = runSerial();
+    cout << "Serial:   " << serial << " s" << endl;
+
+    double parallel = runParallel(threads);
+    cout << "Parallel: " << parallel << " s on " << threads << " threads" << endl;
+    cout << "Speedup:  " << serial / parallel << "x" << endl;
+    return 0;
+}
@@ -0,0 +1,96 @@
+// bench/PersistenceBench.cpp
+//
+// Commands per second with a journal open, for each persistence backend.
+// Every command goes through the command registry as it would from the REPL;
+// most mutate (and so append to the journal) and every SNAPSHOT_EVERY
+// commands a snapshot of the whole tree is saved. After each command the
+// journal is submitted without waiting, as the REPL and the server do. "loop"
+// is the rate seen by the command loop, "durable" also waits at the end for
+// every write to be flushed, as the REPL does on exit.
+//
+// Built by `make bench` as build/bench/PersistenceBench.
+// Run:   build/bench/PersistenceBench [directory for journal and snapshots, default /tmp]
+
+#include "../include/services/FileSystemService.h"
+#include "../include/commands/CommandRegistry.h"
+#include "../include/commands/Commands.h"
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static const int COMMANDS = 60000;
+static const int FOLDERS = 50;
+static const int SNAPSHOT_EVERY = 25000;
+
+static ostream quiet(nullptr);
+
+static void run(CommandRegistry &registry, const string &kind, const string &directory)
+{
+    string journalPath = directory + "/persistence_bench_" + kind + ".journal";
+    string snapshotPath = directory + "/persistence_bench_" + kind + ".snapshot";
+    remove(journalPath.c_str());
+
+    Storage store;
+    string backendName = "none";
+    if (kind != "none")
+    {
+        store.setIoBackend(IoBackend::create(kind));
+        store.openJournal(journalPath);
+        backendName = store.getIoBackend().getName();
+    }
+    FileSystemService fileSystem(store, quiet);
+    string content(200, 'x');
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < COMMANDS; i++)
+    {
+        string folder = "/d" + to_string((i / 4) % FOLDERS);
+        string file = folder + "/f" + to_string(i);
+        switch (i % 4)
+        {
+        case 0:
+            registry.execute(&fileSystem, i < FOLDERS * 4 ? "mkdir " + folder : "ls " + folder);
+            break;
+        case 1:
+            registry.execute(&fileSystem, "touch " + file);
+            break;
+        case 2:
+            registry.execute(&fileSystem, "write " + folder + "/f" + to_string(i - 1) + " " + content);
+            break;
+        case 3:
+            registry.execute(&fileSystem, i % 12 == 3 ? "rm " + folder + "/f" + to_string(i - 2) : "pwd");
+            break;
+        }
+        if (kind != "none" && i % SNAPSHOT_EVERY == SNAPSHOT_EVERY - 1)
+            registry.execute(&fileSystem, "save " + snapshotPath);
+        store.submitWrites();
+    }
+    auto looped = chrono::steady_clock::now();
+    store.flushWrites();
+    auto flushed = chrono::steady_clock::now();
+
+    double loopSeconds = chrono::duration<double>(looped - start).count();
+    double durableSeconds = chrono::duration<double>(flushed - start).count();
+    cout << setw(10) << kind << setw(10) << backendName
+         << setw(14) << fixed << setprecision(0) << COMMANDS / loopSeconds
+         << setw(14) << COMMANDS / durableSeconds << endl;
+    remove(journalPath.c_str());
+    remove(snapshotPath.c_str());
+}
+
+int main(int argc, char **argv)
+{
+    string directory = argc > 1 ? argv[1] : "/tmp";
+    CommandRegistry registry;
+    registerBuiltinCommands(registry);
+
+    cout << COMMANDS << " commands, snapshot every " << SNAPSHOT_EVERY << endl;
+    cout << setw(10) << "requested" << setw(10) << "backend" << setw(14) << "loop cmd/s" << setw(14) << "durable cmd/s" << endl;
+    for (const char *kind : {"none", "sync", "threads", "uring"})
+        run(registry, kind, directory);
+    return 0;
+}
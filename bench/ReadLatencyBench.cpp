@@ -0,0 +1,146 @@
+// bench/ReadLatencyBench.cpp
+//
+// Read latency percentiles for Storage's lock-free (RCU) read path while two
+// writers keep adding and removing files in the folder being read. The
+// "rcu+rwlock" row runs the same Storage with every operation also wrapped
+// in an external reader-writer mutex. It shows the cost of readers waiting
+// on writers, not the pre-RCU Storage, whose data structures are gone.
+//
+// Built by `make bench` as build/bench/ReadLatencyBench.
+
+#include "../include/storage/Storage.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static const int READERS = 4;
+static const int WRITERS = 2;
+static const int HOT_FILES = 200;
+static const int DEPTH = 8;
+static const int OPS_PER_READER = 200000;
+
+struct Workload
+{
+    string hotFolderId;
+    string deepFolderId;
+};
+
+static ostream quiet(nullptr);
+
+static Workload populate(Storage &store)
+{
+    Session session = store.openSession(quiet);
+    Workload workload;
+    workload.hotFolderId = session.getCurrentFolderId();
+    for (int f = 0; f < HOT_FILES; f++)
+        store.addFile(session, "hot" + to_string(f) + ".txt", workload.hotFolderId);
+    string parent = workload.hotFolderId;
+    for (int d = 0; d < DEPTH; d++)
+    {
+        store.addFolder(session, "level" + to_string(d), parent);
+        parent = store.getFolderIdsInFolder(parent).back();
+    }
+    workload.deepFolderId = parent;
+    return workload;
+}
+
+template <typename ReadLock, typename WriteLock>
+static vector<double> run(Storage &store, const Workload &workload, ReadLock readLock, WriteLock writeLock)
+{
+    atomic<bool> stop(false);
+    vector<thread> writers;
+    for (int w = 0; w < WRITERS; w++)
+    {
+        writers.emplace_back([&, w]() {
+            Session session = store.openSession(quiet);
+            for (long long i = 0; !stop; i++)
+            {
+                string name = "w" + to_string(w) + "_" + to_string(i % 32) + ".log";
+                {
+                    [[maybe_unused]] auto lock = writeLock();
+                    store.addFile(session, name, workload.hotFolderId);
+                }
+                {
+                    [[maybe_unused]] auto lock = writeLock();
+                    store.removeFile(session, name);
+                }
+            }
+        });
+    }
+
+    vector<vector<double>> samples(READERS);
+    vector<thread> readers;
+    for (int r = 0; r < READERS; r++)
+    {
+        readers.emplace_back([&, r]() {
+            Session session = store.openSession(quiet);
+            samples[r].reserve(OPS_PER_READER);
+            for (int i = 0; i < OPS_PER_READER; i++)
+            {
+                auto start = chrono::steady_clock::now();
+                {
+                    [[maybe_unused]] auto lock = readLock();
+                    if (i % 3 == 0)
+                        store.getPath(workload.deepFolderId);
+                    else if (i % 3 == 1)
+                        store.getFileIdByName("hot" + to_string(i % HOT_FILES) + ".txt", workload.hotFolderId);
+                    else
+                        store.showItemsInFolder(session, workload.hotFolderId);
+                }
+                samples[r].push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+            }
+        });
+    }
+    for (auto &t : readers)
+        t.join();
+    stop = true;
+    for (auto &t : writers)
+        t.join();
+
+    vector<double> all;
+    for (auto &s : samples)
+        all.insert(all.end(), s.begin(), s.end());
+    sort(all.begin(), all.end());
+    return all;
+}
+
+static void report(const string &name, const vector<double> &sorted)
+{
+    auto at = [&sorted](double q) { return sorted[min(sorted.size() - 1, size_t(q * sorted.size()))]; };
+    cout << left << setw(12) << name << right << fixed << setprecision(2)
+         << setw(10) << at(0.50) << setw(10) << at(0.90) << setw(10) << at(0.99)
+         << setw(10) << at(0.999) << setw(12) << sorted.back() << endl;
+}
+
+int main()
+{
+    cout << READERS << " readers, " << WRITERS << " writers, latencies in microseconds" << endl;
+    cout << left << setw(12) << "mode" << right << setw(10) << "p50" << setw(10) << "p90"
+         << setw(10) << "p99" << setw(10) << "p99.9" << setw(12) << "max" << endl;
+
+    {
+        Storage store;
+        Workload workload = populate(store);
+        shared_mutex mutex;
+        report("rcu+rwlock", run(store, workload,
+                                 [&mutex]() { return shared_lock<shared_mutex>(mutex); },
+                                 [&mutex]() { return unique_lock<shared_mutex>(mutex); }));
+    }
+    {
+        Storage store;
+        Workload workload = populate(store);
+        report("rcu", run(store, workload,
+                          []() { return 0; },
+                          []() { return 0; }));
+    }
+    return 0;
+}
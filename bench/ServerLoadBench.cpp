@@ -0,0 +1,127 @@
+// bench/ServerLoadBench.cpp
+//
+// Load generator for server mode. Opens 1 to 256 connections to a running
+// server (or to one started in-process when no socket is given), has every
+// connection issue a request/response loop of REPL commands in its own
+// folder, and reports ops/sec and latency percentiles per connection count.
+//
+// Usage: build/bench/ServerLoadBench [unix socket path]
+// Built by `make bench` as build/bench/ServerLoadBench.
+
+#include "../include/server/Server.h"
+#include "../include/server/Protocol.h"
+#include "../include/commands/Commands.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using namespace std;
+
+static const double SECONDS_PER_RUN = 1.0;
+
+static int connectTo(const string &path)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool request(int fd, const string &command)
+{
+    string response;
+    return Protocol::writeFrame(fd, command) && Protocol::readFrame(fd, response);
+}
+
+static void run(const string &path, int connections, int round)
+{
+    atomic<bool> stop(false);
+    vector<vector<double>> samples(connections);
+    vector<thread> clients;
+    for (int c = 0; c < connections; c++)
+    {
+        clients.emplace_back([&, c]() {
+            int fd = connectTo(path);
+            if (fd < 0)
+                return;
+            string folder = "/r" + to_string(round) + "c" + to_string(c);
+            request(fd, "mkdir " + folder);
+            request(fd, "cd " + folder);
+            static const char *const commands[] = {"ls", "pwd", "cat a.txt", "touch a.txt", "write a.txt payload", "grep payload a.txt"};
+            for (long long i = 0; !stop; i++)
+            {
+                auto start = chrono::steady_clock::now();
+                if (!request(fd, commands[i % 6]))
+                    break;
+                samples[c].push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+            }
+            close(fd);
+        });
+    }
+    this_thread::sleep_for(chrono::duration<double>(SECONDS_PER_RUN));
+    stop = true;
+    for (auto &client : clients)
+        client.join();
+
+    vector<double> all;
+    for (auto &s : samples)
+        all.insert(all.end(), s.begin(), s.end());
+    if (all.empty())
+    {
+        cout << setw(11) << connections << "  no responses" << endl;
+        return;
+    }
+    sort(all.begin(), all.end());
+    cout << setw(11) << connections << setw(14) << (long long)(all.size() / SECONDS_PER_RUN)
+         << fixed << setprecision(1) << setw(12) << all[all.size() / 2]
+         << setw(12) << all[min(all.size() - 1, all.size() * 99 / 100)] << endl;
+}
+
+int main(int argc, char **argv)
+{
+    string path = argc > 1 ? argv[1] : "/tmp/fss_bench_" + to_string(getpid()) + ".sock";
+
+    Storage store;
+    CommandRegistry registry;
+    Server *server = nullptr;
+    thread serverThread;
+    if (argc <= 1)
+    {
+        registerBuiltinCommands(registry);
+        server = new Server(store, registry);
+        if (!server->listenUnix(path))
+        {
+            cerr << "Cannot listen on " << path << endl;
+            return 1;
+        }
+        serverThread = thread([server]() { server->run(); });
+    }
+
+    cout << "Connections      Ops/sec    p50 (us)    p99 (us)" << endl;
+    int round = 0;
+    for (int connections = 1; connections <= 256; connections *= 4)
+        run(path, connections, round++);
+
+    if (server)
+    {
+        server->stop();
+        serverThread.join();
+        delete server;
+    }
+    return 0;
+}
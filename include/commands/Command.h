@@ -0,0 +1,25 @@
+// include/commands/Command.h
+
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include "./CommandParser.h"
+#include "../services/FileSystemService.h"
+
+using namespace std;
+
+// A single REPL command. Commands are registered once in a CommandRegistry
+// and looked up by name for every input line.
+class Command
+{
+public:
+    virtual string_view getName() const = 0;
+    virtual vector<string> getUsage() const = 0;
+    virtual void execute(FileSystemService *fileSystem, const CommandLine &line) = 0;
+    virtual ~Command() = default;
+};
+
+#endif
@@ -0,0 +1,37 @@
+// include/commands/CommandParser.h
+
+#ifndef COMMANDPARSER_H
+#define COMMANDPARSER_H
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include "../services/GrepService.h"
+
+using namespace std;
+
+// A tokenized input line. All views point into the caller's line buffer,
+// so a CommandLine must not outlive the string it was parsed from.
+struct CommandLine
+{
+    string_view raw;
+    string_view name;
+    vector<string_view> args;
+
+    size_t argCount() const { return args.size(); }
+    string arg(size_t index) const { return index < args.size() ? string(args[index]) : ""; }
+
+    // Everything from argument `index` to the end of the line, with the
+    // original spacing preserved (used by `write` for its content).
+    string_view rest(size_t index) const;
+};
+
+class CommandParser
+{
+public:
+    static CommandLine tokenize(string_view line);
+    static bool isFlag(string_view token);
+    static GrepOptions parseGrepFlags(string_view flags);
+};
+
+#endif
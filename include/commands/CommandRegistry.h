@@ -0,0 +1,36 @@
+// include/commands/CommandRegistry.h
+
+#ifndef COMMANDREGISTRY_H
+#define COMMANDREGISTRY_H
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include "./Command.h"
+#include "./CommandParser.h"
+#include "../services/FileSystemService.h"
+
+using namespace std;
+
+// Dispatch table for commands. Every time a command is added the table is
+// rebuilt into a collision-free (perfect) hash, so a lookup is a single hash
+// of the token plus one string comparison.
+class CommandRegistry
+{
+private:
+    vector<Command *> commands;
+    vector<Command *> slots;
+    uint32_t seed = 0;
+    static uint32_t hash(string_view token, uint32_t seed);
+    void rebuild();
+
+public:
+    void add(Command *command);
+    Command *find(string_view name) const;
+    const vector<Command *> &getCommands() const;
+    bool execute(FileSystemService *fileSystem, string_view line);
+    ~CommandRegistry();
+};
+
+#endif
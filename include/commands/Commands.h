@@ -0,0 +1,225 @@
+// include/commands/Commands.h
+
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include "./Command.h"
+#include "./CommandRegistry.h"
+
+using namespace std;
+
+class MkdirCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class RmdirCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class MvCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class CpCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class CdCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class PwdCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class LsCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class TouchCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class WriteCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class CatCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class RmCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class TreeCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class HistoryCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class GrepCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class FindCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class LocateCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class SaveCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class LoadCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class ImportCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class ExportCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class DuCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class DfCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class StatsCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class TraceCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class AllocsCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+class SlowlogCommand : public Command
+{
+public:
+    string_view getName() const override;
+    vector<string> getUsage() const override;
+    void execute(FileSystemService *fileSystem, const CommandLine &line) override;
+};
+
+// Registers every built-in command, in the order they are listed on startup.
+void registerBuiltinCommands(CommandRegistry &registry);
+
+#endif
@@ -7,6 +7,7 @@
 #include <string>
 #include <map>
 #include <iostream>
+#include "../storage/BlobStore.h"
 using namespace std;
 
 class File
@@ -14,18 +15,27 @@ class File
 private:
     string id;
     string name;
-    string content;
+    const Blob *content;
     string extension;
     string folderId;
 
 public:
     File(string id, string name, string folderId);
-    void setContent(string content);
-    string getContent();
+    // A copy shares the original's content blob
+    File(const File &other);
+    File &operator=(const File &) = delete;
+    // Takes over one reference to blob (nullptr for empty content)
+    void setContent(const Blob *blob);
+    // Content never changes once a File is published; use the result only
+    // while holding a ReadGuard on the Storage
+    BlobContent getContent();
+    const Blob *getBlob() const;
     string getFileName();
+    // Everything after the first dot of the name, without the dot
+    const string &getExtension() const;
     string getFolderId();
     string getId();
-    ~File() = default;
+    ~File();
 };
 
 #endif
\ No newline at end of file
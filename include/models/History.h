@@ -11,7 +11,6 @@ using namespace std;
 class History
 {
 private:
-    static int nextId;
     int id;
     string command;
     string operationType;
@@ -20,7 +19,7 @@ private:
     time_t timestamp;
 
 public:
-    History(string command, string operationType, string target, string currentPath);
+    History(int id, string command, string operationType, string target, string currentPath);
     
     // Getters
     int getId() const;
@@ -0,0 +1,38 @@
+// include/models/Session.h
+
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <string>
+#include <iostream>
+#include <cstdint>
+#include "../storage/DentryCache.h"
+
+using namespace std;
+
+// One client's view of a shared Storage: its own current directory, kept as
+// the folder id plus the path shown in the prompt, and the stream its command
+// output is written to, plus a cache of the name lookups it has resolved.
+// A Session must only be used by one thread at a time.
+class Session
+{
+private:
+    string currentFolderId;
+    string currentPath;
+    // The Storage's path generation when currentPath was computed
+    uint64_t pathGeneration;
+    ostream *out;
+    DentryCache dentries;
+
+public:
+    Session(string folderId, string path, ostream &out = cout);
+    string getCurrentFolderId() const;
+    string getCurrentPath() const;
+    void setCurrentFolder(string folderId, string path, uint64_t generation = 0);
+    uint64_t getPathGeneration() const;
+    ostream &getOutput() const;
+    DentryCache &getDentries();
+    ~Session() = default;
+};
+
+#endif
@@ -0,0 +1,33 @@
+// include/server/Protocol.h
+
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <string>
+#include <cstdint>
+
+using namespace std;
+
+// Wire format shared by the server and its clients. Every request and every
+// response is one frame: a 4-byte big-endian payload length followed by the
+// payload. A request payload is a single command line exactly as typed in the
+// REPL; the response payload is everything the command printed.
+class Protocol
+{
+public:
+    static const uint32_t MAX_FRAME = 16 * 1024 * 1024;
+
+    static void appendFrame(string &buffer, const string &payload);
+    // Takes one complete frame off the front of buffer, if there is one.
+    // Returns false with `error` set for a frame larger than MAX_FRAME.
+    static bool takeFrame(string &buffer, string &payload, bool &error);
+    // Size of the frame at the front of buffer, header included, once its
+    // header has arrived; 0 before that
+    static size_t frameSize(const string &buffer);
+
+    // Blocking helpers for clients
+    static bool writeFrame(int fd, const string &payload);
+    static bool readFrame(int fd, string &payload);
+};
+
+#endif
@@ -0,0 +1,85 @@
+// include/server/Server.h
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <map>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <atomic>
+#include "../storage/Storage.h"
+#include "../services/FileSystemService.h"
+#include "../commands/CommandRegistry.h"
+
+using namespace std;
+
+// Serves one shared Storage to many clients over a Unix socket and/or a
+// localhost TCP port, using the framing in Protocol. A single epoll loop
+// accepts connections and runs each complete request through the command
+// registry; every connection is its own FileSystemService, so it has its own
+// session (current directory) and history.
+//
+// Each connection's buffers are bounded. A wakeup reads at most INPUT_LIMIT
+// bytes (or up to the end of a larger frame) before running what arrived; a
+// header advertising more than Protocol::MAX_FRAME closes the connection
+// before anything more is read. A client whose unread responses reach
+// OUTPUT_HIGH_WATER is not read from, and has no more of its requests run,
+// until it catches up. A client that half-closes after sending still gets
+// every response before the connection is closed.
+//
+// Anyone who can reach the socket can run any command on the shared tree, so
+// commands that read or write host files (save, load, import, export and the
+// stats/trace/slowlog files) are refused on connections unless
+// allowHostPaths() was called.
+class Server
+{
+private:
+    static const size_t INPUT_LIMIT = 1024 * 1024;
+    static const size_t OUTPUT_HIGH_WATER = 4 * 1024 * 1024;
+
+    struct Connection
+    {
+        int fd;
+        string input;
+        string output;
+        ostringstream captured;
+        FileSystemService *fileSystem;
+        // The client has shut down its side; nothing more will be read
+        bool peerClosed = false;
+    };
+
+    Storage &store;
+    CommandRegistry &registry;
+    int epollFd;
+    vector<int> listeners;
+    map<int, Connection *> connections;
+    string unixPath;
+    atomic<bool> stopping;
+    bool hostPaths;
+
+    bool addListener(int fd);
+    void acceptClients(int listener);
+    void readFrom(Connection *connection);
+    // Runs the complete requests in input until OUTPUT_HIGH_WATER is reached
+    void serve(Connection *connection);
+    // Sends what it can and re-arms epoll for the connection's state; false
+    // if the connection was closed
+    bool flush(Connection *connection);
+    void close(Connection *connection);
+
+public:
+    Server(Storage &store, CommandRegistry &registry);
+    Server(const Server &) = delete;
+    Server &operator=(const Server &) = delete;
+    bool listenUnix(const string &path);
+    bool listenTcp(int port);
+    // Lets clients name host paths, as the REPL can
+    void allowHostPaths();
+    // Runs until stop() is called from another thread
+    void run();
+    void stop();
+    ~Server();
+};
+
+#endif
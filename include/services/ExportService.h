@@ -0,0 +1,45 @@
+// include/services/ExportService.h
+
+#ifndef EXPORTSERVICE_H
+#define EXPORTSERVICE_H
+
+#include <string>
+#include <iostream>
+#include "../storage/Storage.h"
+
+using namespace std;
+
+struct ExportStats
+{
+    size_t folders = 0;
+    size_t files = 0;
+    size_t bytes = 0;
+    size_t skipped = 0;
+    size_t errors = 0;
+};
+
+// Writes the session's current folder and everything below it to the host,
+// either into a directory or, when the target ends in ".tar", as a ustar
+// archive streamed through one large buffer. Directory exports hand files
+// to a pool of writer threads. Contents are written straight from the Files
+// in Storage: a ReadGuard held for the whole export keeps them alive, so
+// nothing is copied first. Names that could escape the target ("..", ".",
+// or containing '/') are skipped.
+class ExportService
+{
+private:
+    Storage &store;
+    Session &session;
+    ostream &out;
+
+    ExportStats exportToDirectory(const string &folderId, const string &hostPath, int threads);
+    ExportStats exportToTar(const string &folderId, const string &hostPath);
+
+public:
+    ExportService(Storage &store, Session &session);
+    // threads = 0 picks a pool size from the number of cores
+    ExportStats exportTree(const string &hostPath, int threads = 0);
+    ~ExportService() = default;
+};
+
+#endif
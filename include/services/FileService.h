@@ -14,15 +14,17 @@ using namespace std;
 class FileService
 {
 private:
-    Storage *store;
+    Storage &store;
+    Session &session;
 
 public:
     void createFile(string folderId, string fileName);
     void addContent(string fileId, string content);
     void removeFile(string filename);
+    void removeMatchingFiles(string pattern);
     string showFileContent(string fileId);
     void showFilePath(string fileId);
-    FileService();
+    FileService(Storage &store, Session &session);
     ~FileService() = default;
 };
 
@@ -11,17 +11,33 @@
 #include "./FolderService.h"
 #include "./HistoryService.h"
 #include "./GrepService.h"
+#include "./FindService.h"
+#include "./ImportService.h"
+#include "./ExportService.h"
+#include "./UsageService.h"
 #include "../storage/Storage.h"
 using namespace std;
 
 class FileSystemService
 {
 private:
-    Storage *store;
+    Storage *ownedStore;
+    Storage &store;
+    Session session;
     FileService *fileService;
     FolderService *folderService;
     HistoryService *historyService;
     GrepService *grepService;
+    FindService *findService;
+    ImportService *importService;
+    ExportService *exportService;
+    UsageService *usageService;
+    // Whether commands may name host paths (save, load, import, export and
+    // the stats/trace/slowlog files)
+    bool hostAccess;
+
+    // Reports and returns false when host paths are refused
+    bool checkHostAccess();
 
 public:
     void createFile(string folderId, string fileName);
@@ -29,11 +45,18 @@ public:
     void addContent(string fileName, string content);
     void removeFile(string fileName);
     string showFileContent(string fileId);
+    void catFile(string filePath);
+    string resolveFolder(string folderPath);
     void createFolder(string parentFolderId, string folderName);
     void removeFolder(string folderName);
     void showTree(string folderId);
     void listAllItems(string folderId);
     void getIntoFolder(string folderName);
+    // Glob patterns ("*.log", "data_??.csv", "logs/[a-f]*") in the last
+    // path component; each call is one pass over the folder's children
+    void listMatchingItems(string pattern);
+    void removeMatchingFiles(string pattern);
+    void removeMatchingFolders(string pattern);
     bool isFolderAvailable(string name);
     string currentPath();
     
@@ -47,11 +70,71 @@ public:
     void grepPattern(const string& pattern);
     void grepInFile(const string& pattern, const string& fileName);
     void grepRecursive(const string& pattern);
-    void grepWithOptions(const string& pattern, const string& options);
+    // flags is the option token as typed ("rn" for grep -rn), for history
+    void grepWithOptions(const string& pattern, const GrepOptions& options, const string& flags);
     void showGrepHelp();
+
+    // Files and folders below folderPath (the current folder if empty);
+    // arguments is the command's argument text as typed, for history
+    void findItems(string folderPath, const FindOptions &options, const string &arguments);
+    // Names anywhere in the tree, from the global name index
+    void locate(string query);
+    // mv: re-parents (and possibly renames) one file or folder
+    void moveItem(string source, string destination);
+    // cp [-r]: copies a file or folder, sharing its contents with the source
+    void copyItem(string source, string destination, bool recursive);
+
+    // Persistence: snapshot the whole tree to a host file, or replay one
+    void saveSnapshot(string hostPath);
+    void loadSnapshot(string hostPath);
+
+    // Copies a host directory tree (or file) into the current folder
+    void importTree(string hostPath);
+    // Writes the current folder's subtree to a host directory or .tar file
+    void exportTree(string hostPath);
+
+    // Subtree sizes (du) and totals for the whole store (df); arguments is
+    // du's argument text as typed, for history
+    void showDiskUsage(string folderPath, bool humanReadable, int maxDepth, const string &arguments);
+    void showFreeSpace(bool humanReadable);
+
+    // Per-operation latency; like history, these are not recorded themselves
+    void showStats();
+    // JSON to the output, or to a host file when hostPath is not empty
+    void dumpStats(string hostPath);
+    void resetStats();
+
+    // Span tracing for the whole process (see Tracer); not recorded either
+    void startTrace();
+    void stopTrace();
+    void dumpTrace(string hostPath);
+
+    // Heap allocations per command and call site (see AllocationTracker)
+    void startAllocationProfile();
+    void stopAllocationProfile();
+    void showAllocations(size_t topSites);
+    void resetAllocations();
+
+    // Commands slower than a threshold (see SlowCommandLog); 0 ms turns it off
+    void showSlowCommands();
+    void setSlowCommandThreshold(double milliseconds);
+    // Appends slow commands to a host file; an empty path stops appending
+    void setSlowCommandFile(string hostPath);
+    void clearSlowCommands();
+    
+    // Server sessions are denied host paths unless the server allows them
+    void setHostAccess(bool allowed);
+
+    Storage &getStorage();
+    Session &getSession();
+    ostream &getOutput();
     
-    FileSystemService();
-    ~FileSystemService() = default;
+    // A service either owns a private Storage or is one client of a shared one
+    FileSystemService(ostream &out = cout);
+    FileSystemService(Storage &sharedStore, ostream &out = cout);
+    FileSystemService(const FileSystemService &) = delete;
+    FileSystemService &operator=(const FileSystemService &) = delete;
+    ~FileSystemService();
 };
 
 #endif
\ No newline at end of file
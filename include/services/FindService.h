@@ -0,0 +1,47 @@
+// include/services/FindService.h
+
+#ifndef FINDSERVICE_H
+#define FINDSERVICE_H
+
+#include <string>
+#include <cstdint>
+#include <iostream>
+#include "../storage/Storage.h"
+
+using namespace std;
+
+// Predicates of one find; every one that is set must hold
+struct FindOptions
+{
+    string namePattern = ""; // glob on the whole name
+    string extension = "";   // files whose extension is this or ends in "." + this
+    char type = 0;           // 'f' files only, 'd' folders only, 0 both
+    bool hasSize = false;    // files of size below (-1), equal to (0) or above (+1) sizeBytes
+    int sizeCompare = 0;
+    uint64_t sizeBytes = 0;
+    int maxDepth = -1;       // < 0 for no limit; 1 is the folder's own children
+};
+
+// Finds files and folders below a folder by name, extension, size and depth.
+// Folders are searched by a pool of threads that take them from a shared
+// queue, each inside its own ReadGuard. A folder's matches are printed as
+// soon as it has been searched, in name order, so results stream in while
+// the walk goes on; the order between folders depends on the threads.
+// Names come from each folder's name index and extensions from the File, so
+// no full name is built unless it is printed.
+class FindService
+{
+private:
+    Storage &store;
+    Session &session;
+    ostream &out;
+
+public:
+    FindService(Storage &store, Session &session);
+    // threads = 0 picks a pool size from the number of cores. Returns the
+    // number of matches.
+    size_t find(const string &folderPath, const FindOptions &options, int threads = 0);
+    ~FindService() = default;
+};
+
+#endif
@@ -13,17 +13,20 @@ using namespace std;
 class FolderService
 {
 private:
-    Storage *store;
+    Storage &store;
+    Session &session;
 
 public:
     void createFolder(string parentFolderId, string folderName);
     void removeFolder(string folderName);
+    void removeMatchingFolders(string pattern);
     void showTree(string folderId);
     void listAllItems(string folderId);
+    void listMatchingItems(string pattern);
     string getCurrentFolder();
     void showFolderPath(string folderId);
     void getIntoFolder(string folderName);
-    FolderService();
+    FolderService(Storage &store, Session &session);
     ~FolderService() = default;
 };
 
@@ -34,7 +34,9 @@ struct GrepOptions {
 class GrepService
 {
 private:
-    Storage *store;
+    Storage &store;
+    Session &session;
+    ostream &out;
     vector<string> splitLines(const string& content);
     bool matchesPattern(const string& line, const string& pattern, bool caseInsensitive, bool invertMatch);
     void searchInFile(const string& fileId, const string& pattern, const GrepOptions& options, vector<GrepResult>& results);
@@ -42,7 +44,7 @@ private:
     void displayResults(const vector<GrepResult>& results, const GrepOptions& options);
 
 public:
-    GrepService();
+    GrepService(Storage &store, Session &session);
     void grep(const string& pattern, const GrepOptions& options = GrepOptions());
     void grepInFile(const string& pattern, const string& fileName, const GrepOptions& options = GrepOptions());
     void grepRecursive(const string& pattern, const GrepOptions& options = GrepOptions());
@@ -5,6 +5,7 @@
 
 #include <vector>
 #include <string>
+#include <iostream>
 #include "../models/History.h"
 
 using namespace std;
@@ -14,9 +15,11 @@ class HistoryService
 private:
     vector<History*> historyEntries;
     static const int MAX_HISTORY_SIZE = 1000;
+    int nextId;
+    ostream &out;
 
 public:
-    HistoryService();
+    HistoryService(ostream &out = cout);
     
     // Core history operations
     void addEntry(string command, string operationType, string target, string currentPath);
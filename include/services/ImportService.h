@@ -0,0 +1,40 @@
+// include/services/ImportService.h
+
+#ifndef IMPORTSERVICE_H
+#define IMPORTSERVICE_H
+
+#include <string>
+#include <iostream>
+#include "../storage/Storage.h"
+
+using namespace std;
+
+struct ImportStats
+{
+    size_t folders = 0;
+    size_t files = 0;
+    size_t bytes = 0;
+    size_t skipped = 0;
+    size_t errors = 0;
+};
+
+// Copies a directory tree from the host into the session's current folder.
+// Directories are walked by a pool of threads; each one reads a directory's
+// files in full (large ones through mmap) and inserts the whole directory
+// with a single Storage::insertBatch call, so nothing is printed per node.
+// Symlinks and special files are skipped; existing names are left alone.
+class ImportService
+{
+private:
+    Storage &store;
+    Session &session;
+    ostream &out;
+
+public:
+    ImportService(Storage &store, Session &session);
+    // threads = 0 picks a pool size from the number of cores
+    ImportStats importTree(const string &hostPath, int threads = 0);
+    ~ImportService() = default;
+};
+
+#endif
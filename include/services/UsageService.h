@@ -0,0 +1,36 @@
+// include/services/UsageService.h
+
+#ifndef USAGESERVICE_H
+#define USAGESERVICE_H
+
+#include <string>
+#include <cstdint>
+#include <iostream>
+#include "../storage/Storage.h"
+
+using namespace std;
+
+// du and df over the totals Storage keeps per folder. Each folder's line
+// costs one O(1) lookup, so `du -d 1` on a large tree reads only the folders
+// it prints, and df reads only the root and the BlobStore's counters.
+class UsageService
+{
+private:
+    Storage &store;
+    Session &session;
+    ostream &out;
+
+    void showFolder(const string &folderId, const string &path, int depth, int maxDepth, bool humanReadable);
+
+public:
+    UsageService(Storage &store, Session &session);
+    // One line per folder, subfolders before their parent; maxDepth < 0
+    // lists every level, 0 only the folder itself
+    void showDiskUsage(const string &folderPath, bool humanReadable, int maxDepth);
+    void showFreeSpace(bool humanReadable);
+    // Bytes, or 1.5K / 12M / 3.0G style with humanReadable
+    static string formatSize(uint64_t bytes, bool humanReadable);
+    ~UsageService() = default;
+};
+
+#endif
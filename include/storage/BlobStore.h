@@ -0,0 +1,135 @@
+// include/storage/BlobStore.h
+
+#ifndef BLOBSTORE_H
+#define BLOBSTORE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include "./Epoch.h"
+
+using namespace std;
+
+class BlobStore;
+
+// One distinct file content, shared by every File whose content is
+// byte-for-byte the same. The content never changes, but where it lives
+// does: plain holds it while the blob is hot, and once it has gone cold
+// only the compressed form (packed) stays resident, with copy holding a
+// decompressed copy while it is in the read cache.
+struct Blob
+{
+    uint64_t hash;
+    size_t size;
+    size_t refs;
+    BlobStore *store;
+    atomic<const string *> plain;
+    const string *packed;
+    // Guarded by the store's lock
+    shared_ptr<const string> copy;
+    atomic<uint64_t> lastUse;
+    bool incompressible;
+    list<Blob *>::iterator cacheEntry;
+    uint64_t cachedAt;
+    bool cached;
+};
+
+// The content of a blob as read. For a hot blob it points at the blob's own
+// string, valid while the ReadGuard is held; for a cold one it shares the
+// decompressed copy, which stays alive until the last handle is dropped
+// even if the read cache evicts it meanwhile. Hold it only as long as the
+// content is needed, so a long walk keeps one cold copy at a time.
+class BlobContent
+{
+private:
+    const string *data;
+    shared_ptr<const string> owner;
+
+public:
+    explicit BlobContent(const string *data, shared_ptr<const string> owner = nullptr)
+        : data(data), owner(move(owner)) {}
+    const string &operator*() const { return *data; }
+    const string *operator->() const { return data; }
+};
+
+struct BlobStats
+{
+    size_t blobs = 0;
+    size_t storedBytes = 0;  // sum of distinct contents
+    size_t logicalBytes = 0; // sum over every reference, i.e. without sharing
+    size_t coldBlobs = 0;
+    size_t hotBytes = 0;    // uncompressed contents of hot blobs
+    size_t packedBytes = 0; // compressed contents of cold blobs
+    size_t cachedBytes = 0; // decompressed copies in the read cache
+};
+
+// Content-addressed store of file contents: hash -> refcounted Blob.
+// intern() returns the existing Blob when an identical content is already
+// stored, so duplicate payloads are kept once. Contents with equal hashes
+// are compared in full, so a collision never shares different data.
+// Thread-safe; hashing happens before the lock is taken.
+//
+// Cold tier: compactCold() compresses blobs that are large enough and have
+// not been read for a number of passes. Reading a cold blob decompresses it
+// into a cache of bounded size; cached copies that are read again get a
+// second chance before eviction. Hot reads take no lock; cold reads take it
+// to share the cached copy, and an evicted copy is freed as soon as no
+// BlobContent holds it, so the limit holds under long ReadGuards too. A hot
+// blob's original string, which readers may still hold when the blob goes
+// cold, is not freed here but queued until drainRetired() hands it to the
+// owning Storage's EpochManager.
+class BlobStore
+{
+private:
+    unordered_map<uint64_t, vector<Blob *>> buckets;
+    BlobStats stats;
+    list<Blob *> cache;
+    size_t cacheLimit;
+    atomic<uint64_t> tick;
+    vector<const string *> retiring;
+    atomic<bool> hasRetiring;
+    mutable mutex lock;
+    mutex compacting;
+
+    bool sameContent(const Blob *blob, const string &data) const;
+    void evictLocked();
+    void freeLocked(Blob *blob);
+
+public:
+    BlobStore();
+    BlobStore(const BlobStore &) = delete;
+    BlobStore &operator=(const BlobStore &) = delete;
+
+    // Returns a Blob holding data with one reference owned by the caller;
+    // empty content is represented by nullptr
+    const Blob *intern(string data);
+    const Blob *retain(const Blob *blob);
+    void release(const Blob *blob);
+    // The content of blob, decompressing it if it is cold. The caller must
+    // hold a ReadGuard (or the writer lock) on the Storage that owns this
+    // store while it uses the result.
+    BlobContent read(const Blob *blob);
+
+    // Compresses blobs of at least minBytes not read during the last
+    // idlePasses calls; returns how many went cold
+    size_t compactCold(size_t minBytes, uint64_t idlePasses);
+    void setCacheLimit(size_t bytes);
+    // Called by Storage writers to retire queued strings; callers serialise
+    // this with their other retire() calls
+    void drainRetired(EpochManager &epochs);
+
+    BlobStats getStats() const;
+    ~BlobStore();
+
+    // XXH64 with seed 0
+    static uint64_t hash(string_view data);
+};
+
+#endif
@@ -0,0 +1,302 @@
+// include/storage/ChildList.h
+
+#ifndef CHILDLIST_H
+#define CHILDLIST_H
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// An immutable sorted sequence. Up to MAX_CHUNK elements are kept inline
+// and copied whole, like a plain vector; a longer list is split into shared
+// chunks of at most MAX_CHUNK elements. inserted() and erased() copy the one
+// chunk they change and the array of chunk pointers; every other chunk is
+// shared with the list it was derived from, so a single change to a list of
+// n elements copies about MAX_CHUNK elements and n / MAX_CHUNK pointers
+// rather than all n.
+template <typename T>
+class ChunkedList
+{
+public:
+    static const size_t MAX_CHUNK = 256;
+
+private:
+    typedef vector<T> Chunk;
+    Chunk small;
+    vector<shared_ptr<const Chunk>> chunks;
+    size_t count = 0;
+
+    size_t chunkCount() const { return chunks.empty() ? (small.empty() ? 0 : 1) : chunks.size(); }
+    const Chunk &chunkAt(size_t index) const { return chunks.empty() ? small : *chunks[index]; }
+
+    // The first chunk whose last element is not less than key
+    template <typename Key, typename Less>
+    size_t firstChunk(const Key &key, Less less) const
+    {
+        size_t first = 0, last = chunkCount();
+        while (first < last)
+        {
+            size_t middle = first + (last - first) / 2;
+            if (less(chunkAt(middle).back(), key))
+                first = middle + 1;
+            else
+                last = middle;
+        }
+        return first;
+    }
+
+    static Chunk insertedInto(const Chunk &chunk, const T &value)
+    {
+        auto pos = lower_bound(chunk.begin(), chunk.end(), value);
+        Chunk changed;
+        changed.reserve(chunk.size() + 1);
+        changed.insert(changed.end(), chunk.begin(), pos);
+        changed.push_back(value);
+        changed.insert(changed.end(), pos, chunk.end());
+        return changed;
+    }
+
+    static shared_ptr<const Chunk> share(typename Chunk::iterator first, typename Chunk::iterator last)
+    {
+        return make_shared<const Chunk>(make_move_iterator(first), make_move_iterator(last));
+    }
+
+public:
+    class const_iterator
+    {
+    private:
+        const ChunkedList *list;
+        size_t chunk, offset;
+
+    public:
+        typedef forward_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        const_iterator(const ChunkedList *list, size_t chunk, size_t offset) : list(list), chunk(chunk), offset(offset) {}
+        const T &operator*() const { return list->chunkAt(chunk)[offset]; }
+        const T *operator->() const { return &list->chunkAt(chunk)[offset]; }
+        const_iterator &operator++()
+        {
+            if (++offset == list->chunkAt(chunk).size())
+            {
+                chunk++;
+                offset = 0;
+            }
+            return *this;
+        }
+        bool operator==(const const_iterator &other) const { return chunk == other.chunk && offset == other.offset; }
+        bool operator!=(const const_iterator &other) const { return !(*this == other); }
+    };
+
+    ChunkedList() = default;
+
+    // Takes values already sorted
+    explicit ChunkedList(vector<T> sorted) : count(sorted.size())
+    {
+        if (sorted.size() <= MAX_CHUNK)
+        {
+            small = move(sorted);
+            return;
+        }
+        // Chunks start half full so the next inserts do not split them
+        for (size_t start = 0; start < sorted.size(); start += MAX_CHUNK / 2)
+            chunks.push_back(share(sorted.begin() + start, sorted.begin() + min(sorted.size(), start + MAX_CHUNK / 2)));
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const_iterator begin() const { return const_iterator(this, 0, 0); }
+    const_iterator end() const { return const_iterator(this, chunkCount(), 0); }
+
+    // The first element for which less(element, key) is false
+    template <typename Key, typename Less>
+    const_iterator lowerBound(const Key &key, Less less) const
+    {
+        size_t found = firstChunk(key, less);
+        if (found == chunkCount())
+            return end();
+        const Chunk &chunk = chunkAt(found);
+        size_t offset = partition_point(chunk.begin(), chunk.end(), [&](const T &element) { return less(element, key); }) -
+                        chunk.begin();
+        return const_iterator(this, found, offset);
+    }
+
+    bool contains(const T &value) const
+    {
+        auto found = lowerBound(value, [](const T &element, const T &key) { return element < key; });
+        return found != end() && !(value < *found);
+    }
+
+    ChunkedList inserted(const T &value) const
+    {
+        ChunkedList next;
+        next.count = count + 1;
+        if (chunks.empty())
+        {
+            Chunk changed = insertedInto(small, value);
+            if (changed.size() <= MAX_CHUNK)
+                next.small = move(changed);
+            else
+            {
+                next.chunks.push_back(share(changed.begin(), changed.begin() + changed.size() / 2));
+                next.chunks.push_back(share(changed.begin() + changed.size() / 2, changed.end()));
+            }
+            return next;
+        }
+        // The chunk value belongs in, or the last one if it sorts after all
+        size_t at = min(firstChunk(value, [](const T &element, const T &key) { return element < key; }), chunks.size() - 1);
+        Chunk changed = insertedInto(*chunks[at], value);
+        next.chunks.reserve(chunks.size() + 1);
+        next.chunks.insert(next.chunks.end(), chunks.begin(), chunks.begin() + at);
+        if (changed.size() <= MAX_CHUNK)
+            next.chunks.push_back(make_shared<const Chunk>(move(changed)));
+        else
+        {
+            next.chunks.push_back(share(changed.begin(), changed.begin() + changed.size() / 2));
+            next.chunks.push_back(share(changed.begin() + changed.size() / 2, changed.end()));
+        }
+        next.chunks.insert(next.chunks.end(), chunks.begin() + at + 1, chunks.end());
+        return next;
+    }
+
+    // removed must be sorted; elements not in the list are ignored. Chunks
+    // that lose nothing are shared, and what is left of a changed chunk is
+    // merged into the one before it while both fit in half a chunk.
+    ChunkedList erased(const vector<T> &removed) const
+    {
+        ChunkedList next;
+        if (chunks.empty())
+        {
+            next.small.reserve(small.size());
+            for (const T &element : small)
+                if (!binary_search(removed.begin(), removed.end(), element))
+                    next.small.push_back(element);
+            next.count = next.small.size();
+            return next;
+        }
+        next.chunks.reserve(chunks.size());
+        for (const shared_ptr<const Chunk> &chunk : chunks)
+        {
+            auto first = lower_bound(removed.begin(), removed.end(), chunk->front());
+            if (first == removed.end() || chunk->back() < *first)
+            {
+                next.chunks.push_back(chunk);
+                next.count += chunk->size();
+                continue;
+            }
+            Chunk kept;
+            kept.reserve(chunk->size());
+            for (const T &element : *chunk)
+                if (!binary_search(first, removed.end(), element))
+                    kept.push_back(element);
+            next.count += kept.size();
+            if (kept.empty())
+                continue;
+            if (!next.chunks.empty() && next.chunks.back()->size() + kept.size() <= MAX_CHUNK / 2)
+            {
+                Chunk merged = *next.chunks.back();
+                merged.insert(merged.end(), make_move_iterator(kept.begin()), make_move_iterator(kept.end()));
+                next.chunks.back() = make_shared<const Chunk>(move(merged));
+            }
+            else
+                next.chunks.push_back(make_shared<const Chunk>(move(kept)));
+        }
+        return next;
+    }
+};
+
+// Immutable snapshot of the ids directly inside one folder, kept sorted.
+// Writers never edit a published ChildList; they build a new one with
+// with()/without() and swap it in, so readers can iterate without locking.
+// Both orders are ChunkedLists, so building the next version of a large
+// folder shares all but one chunk of each with the current one.
+// Storage stamps each published list with a new version, which is what
+// dentry cache entries are validated against.
+//
+// byName holds the same children ordered by name, so a name or a name
+// prefix is found by binary search instead of a scan of every child.
+struct ChildList
+{
+    // Ordered by name, then id: a file and a folder may share a name
+    struct Named
+    {
+        string name;
+        string id;
+
+        bool operator<(const Named &other) const { return name != other.name ? name < other.name : id < other.id; }
+    };
+
+    ChunkedList<string> ids;
+    ChunkedList<Named> byName;
+    uint64_t version = 0;
+
+    ChildList() = default;
+
+    // Any order
+    explicit ChildList(vector<Named> children)
+    {
+        vector<string> sortedIds;
+        sortedIds.reserve(children.size());
+        for (const Named &child : children)
+            sortedIds.push_back(child.id);
+        sort(sortedIds.begin(), sortedIds.end());
+        sort(children.begin(), children.end());
+        ids = ChunkedList<string>(move(sortedIds));
+        byName = ChunkedList<Named>(move(children));
+    }
+
+    bool contains(const string &id) const { return ids.contains(id); }
+
+    // The children named exactly name, or starting with prefix, in name order
+    ChunkedList<Named>::const_iterator named(string_view name) const
+    {
+        return byName.lowerBound(name, [](const Named &child, string_view key) { return string_view(child.name) < key; });
+    }
+
+    pair<ChunkedList<Named>::const_iterator, ChunkedList<Named>::const_iterator> withPrefix(string_view prefix) const
+    {
+        auto first = named(prefix);
+        auto last = first;
+        while (last != byName.end() && string_view(last->name).substr(0, prefix.size()) == prefix)
+            ++last;
+        return {first, last};
+    }
+
+    ChildList *with(const string &id, const string &name) const
+    {
+        ChildList *next = new ChildList();
+        next->ids = ids.inserted(id);
+        next->byName = byName.inserted({name, id});
+        return next;
+    }
+
+    ChildList *without(const Named &child) const
+    {
+        return without(vector<Named>{child});
+    }
+
+    ChildList *without(vector<Named> removed) const
+    {
+        vector<string> removedIds;
+        removedIds.reserve(removed.size());
+        for (const Named &child : removed)
+            removedIds.push_back(child.id);
+        sort(removedIds.begin(), removedIds.end());
+        sort(removed.begin(), removed.end());
+        ChildList *next = new ChildList();
+        next->ids = ids.erased(removedIds);
+        next->byName = byName.erased(removed);
+        return next;
+    }
+};
+
+#endif
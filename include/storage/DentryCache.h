@@ -0,0 +1,55 @@
+// include/storage/DentryCache.h
+
+#ifndef DENTRYCACHE_H
+#define DENTRYCACHE_H
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// Per-session cache of name lookups: (parent folder, name) -> the folder and
+// file with that name, or a negative entry when neither exists. Each entry
+// remembers the version of the parent's ChildList it was filled from and is
+// only trusted while that version is still the published one, so writers
+// never have to invalidate anything. The cache is direct-mapped with a fixed
+// number of slots; a colliding key simply replaces the old entry.
+class DentryCache
+{
+public:
+    static const size_t NONE = SIZE_MAX;
+
+    struct Entry
+    {
+        size_t parent = NONE;
+        uint64_t version = 0;
+        string name;
+        size_t folder = NONE;
+        size_t file = NONE;
+    };
+
+private:
+    static const size_t SLOTS = 1024;
+    vector<Entry> entries;
+    size_t hits;
+    size_t misses;
+
+public:
+    DentryCache();
+
+    // The slot a key maps to. Check matches() before trusting it.
+    Entry &slotFor(size_t parent, string_view name);
+    static bool matches(const Entry &entry, size_t parent, uint64_t version, string_view name);
+
+    void recordHit() { hits++; }
+    void recordMiss() { misses++; }
+    size_t getHits() const { return hits; }
+    size_t getMisses() const { return misses; }
+    void clear();
+    ~DentryCache() = default;
+};
+
+#endif
@@ -0,0 +1,78 @@
+// include/storage/Epoch.h
+
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// Epoch-based reclamation for Storage's read path. Readers enter a Guard,
+// which publishes the current epoch in a slot, and never take a lock.
+// Writers swap in new versions of shared objects and retire the old ones;
+// a retired object is freed only once every reader that could have seen
+// it has left its critical section.
+class EpochManager
+{
+private:
+    static const int SLOTS = 128;
+    static const size_t RECLAIM_THRESHOLD = 64;
+
+    struct alignas(64) Slot
+    {
+        atomic<uint64_t> epoch{0};
+    };
+
+    struct Retired
+    {
+        void *object;
+        void (*deleter)(void *);
+        uint64_t epoch;
+    };
+
+    atomic<uint64_t> globalEpoch{1};
+    mutable Slot slots[SLOTS];
+    vector<Retired> retired;
+
+    int enter() const;
+    void leave(int slot) const;
+    uint64_t oldestActiveEpoch() const;
+    void reclaim(uint64_t oldest);
+
+public:
+    // Read-side critical section. Nested guards on the same manager in one
+    // thread are free and share the outer guard's slot.
+    class Guard
+    {
+    private:
+        const EpochManager *manager;
+        int slot;
+
+    public:
+        explicit Guard(const EpochManager &manager);
+        Guard(const Guard &) = delete;
+        Guard &operator=(const Guard &) = delete;
+        ~Guard();
+    };
+
+    // Writer side; callers must serialise retire() and collect() themselves.
+    // Nothing is freed until collect() runs, so a writer may keep using an
+    // object it has just retired.
+    template <typename T>
+    void retire(const T *object)
+    {
+        if (object)
+            retireRaw(const_cast<T *>(object), [](void *p) { delete static_cast<T *>(p); });
+    }
+    void retireRaw(void *object, void (*deleter)(void *));
+    void collect();
+
+    EpochManager() = default;
+    EpochManager(const EpochManager &) = delete;
+    EpochManager &operator=(const EpochManager &) = delete;
+    ~EpochManager();
+};
+
+#endif
@@ -0,0 +1,32 @@
+// include/storage/FolderUsage.h
+
+#ifndef FOLDERUSAGE_H
+#define FOLDERUSAGE_H
+
+#include <atomic>
+#include <cstdint>
+
+using namespace std;
+
+// Totals for everything below one folder: content bytes (as written, before
+// deduplication or compression), files, and subfolders, not counting the
+// folder itself. Storage adjusts the counters of a folder and all of its
+// ancestors on every mutation while holding the writer lock, so reading
+// them is O(1). Readers load them without locking; a reader racing a writer
+// may see one folder's totals updated before its parent's.
+struct FolderUsage
+{
+    atomic<uint64_t> bytes{0};
+    atomic<uint64_t> files{0};
+    atomic<uint64_t> folders{0};
+};
+
+// A plain copy of one folder's FolderUsage
+struct UsageTotals
+{
+    uint64_t bytes = 0;
+    uint64_t files = 0;
+    uint64_t folders = 0;
+};
+
+#endif
@@ -0,0 +1,62 @@
+// include/storage/GlobPattern.h
+
+#ifndef GLOBPATTERN_H
+#define GLOBPATTERN_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <bitset>
+
+using namespace std;
+
+// A shell-style glob compiled once and matched against many names:
+//   *        any run of characters, including none
+//   ?        exactly one character
+//   [a-f_]   one character from a set; [!a-f] or [^a-f] negates it
+//   \x       the character x itself
+// A '[' without a closing ']' is taken literally. Names are matched as
+// bytes. Before the full match, a name is checked against the pattern's
+// fixed length bounds and literal prefix and suffix, which rejects most
+// non-matching names in a few comparisons.
+class GlobPattern
+{
+private:
+    enum Kind
+    {
+        LITERAL,
+        ANY,
+        STAR,
+        SET
+    };
+
+    struct Token
+    {
+        Kind kind;
+        string literal;
+        size_t set;
+    };
+
+    vector<Token> tokens;
+    vector<bitset<256>> sets;
+    string prefix;
+    string suffix;
+    size_t minLength = 0;
+    bool hasStar = false;
+
+    bool matchesToken(const Token &token, string_view name, size_t at) const;
+
+public:
+    explicit GlobPattern(string_view pattern);
+
+    // True if the text has an unescaped *, ? or [...]
+    static bool isGlob(string_view text);
+
+    bool matches(string_view name) const;
+    // The literal characters every match starts with
+    const string &literalPrefix() const { return prefix; }
+    // The literal characters every match ends with (empty without a star)
+    const string &literalSuffix() const { return suffix; }
+};
+
+#endif
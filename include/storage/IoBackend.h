@@ -0,0 +1,134 @@
+// include/storage/IoBackend.h
+
+#ifndef IOBACKEND_H
+#define IOBACKEND_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+using namespace std;
+
+// Where Storage's persistence writes (journal appends, snapshots) go.
+// write() may return before the data reaches the file; flush() waits until
+// everything written so far has. Implementations are thread-safe.
+class IoBackend
+{
+public:
+    virtual string getName() const = 0;
+    virtual void write(int fd, uint64_t offset, string data) = 0;
+    virtual void flush() = 0;
+    virtual ~IoBackend() = default;
+
+    // "sync", "threads" or "uring"; "uring" falls back to "threads" when the
+    // kernel (or a sandbox) does not allow io_uring
+    static IoBackend *create(const string &kind);
+};
+
+// pwrite() on the calling thread
+class SyncIoBackend : public IoBackend
+{
+public:
+    string getName() const override;
+    void write(int fd, uint64_t offset, string data) override;
+    void flush() override;
+};
+
+// Queues writes for a small pool of threads that pwrite() them
+class ThreadPoolIoBackend : public IoBackend
+{
+private:
+    struct Job
+    {
+        int fd;
+        uint64_t offset;
+        string data;
+    };
+
+    vector<thread> workers;
+    deque<Job> jobs;
+    size_t inFlight;
+    bool stopping;
+    mutex lock;
+    condition_variable hasWork;
+    condition_variable idle;
+
+    void work();
+
+public:
+    explicit ThreadPoolIoBackend(int threads = 2);
+    string getName() const override;
+    void write(int fd, uint64_t offset, string data) override;
+    void flush() override;
+    ~ThreadPoolIoBackend();
+};
+
+// Submits writes through an io_uring, driven with the raw syscalls so no
+// liburing is needed. write() queues and submits without waiting; finished
+// writes are reaped on later calls, and buffers are kept until then.
+//
+// The constructor probes the ring for IORING_OP_WRITE (kernels before 5.6
+// set up a ring but reject it); isReady() is false without it. A write the
+// kernel still rejects with EINVAL is finished with pwrite(). If
+// io_uring_enter itself fails, the error is reported, everything pending is
+// written with pwrite() and the backend stays on pwrite() from then on.
+class UringIoBackend : public IoBackend
+{
+private:
+    static const unsigned ENTRIES = 256;
+
+    struct Pending
+    {
+        int fd;
+        uint64_t offset;
+        string data;
+        size_t done;
+    };
+
+    int ringFd;
+    void *sqRing;
+    void *cqRing;
+    void *sqeMemory;
+    size_t sqRingSize;
+    size_t cqRingSize;
+    size_t sqeSize;
+    unsigned *sqHead;
+    unsigned *sqTail;
+    unsigned *sqMask;
+    unsigned *sqArray;
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned *cqMask;
+    void *cqes;
+    unsigned queued;
+    unsigned submitted;
+    uint64_t nextTag;
+    map<uint64_t, Pending> pending;
+    // Set once io_uring_enter has failed. Writes the kernel may still be
+    // reading are moved, node and buffer, to abandoned until the ring is
+    // closed.
+    bool failed;
+    map<uint64_t, Pending> abandoned;
+    mutex lock;
+
+    void queue(uint64_t tag);
+    // False (after falling back to pwrite) if io_uring_enter failed
+    bool submit(unsigned waitFor);
+    void reap();
+    void fail(int error);
+
+public:
+    UringIoBackend();
+    bool isReady() const;
+    string getName() const override;
+    void write(int fd, uint64_t offset, string data) override;
+    void flush() override;
+    ~UringIoBackend();
+};
+
+#endif
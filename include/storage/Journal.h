@@ -0,0 +1,96 @@
+// include/storage/Journal.h
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include "./IoBackend.h"
+
+using namespace std;
+
+class Storage;
+struct ChildList;
+class Folder;
+class File;
+
+// Every folder's ChildList and every folder and file of a Storage as they
+// were at one instant, indexed like its tables. Taking one only copies
+// pointers; they stay valid while a ReadGuard entered before the cut is held.
+struct TreeCut
+{
+    size_t root = 0;
+    vector<const ChildList *> children;
+    vector<Folder *> folders;
+    vector<File *> files;
+};
+
+// Append-only log of Storage mutations, written through an IoBackend.
+// Snapshots use the same record format: one create record per folder and
+// file, plus a write record per non-empty file, in pre-order. Each record is
+// a 4-byte big-endian length followed by the op, the absolute path, a NUL
+// and (for writes) the content, or for moves and copies the new path, so
+// replaying a snapshot and then the journal taken after it rebuilds the
+// tree exactly. A torn record at the end of a file is ignored by replay, and
+// cut off when the journal is opened for appending.
+//
+// Appends are grouped: records collect in a buffer that is handed to the
+// backend once it holds BATCH_BYTES, or on flush(), so the backend sees a
+// few large writes rather than one per command.
+class Journal
+{
+private:
+    static const size_t BATCH_BYTES = 64 * 1024;
+
+    IoBackend *backend;
+    string path;
+    int fd;
+    uint64_t offset;
+    string batch;
+    mutex lock;
+
+    void submitBatch();
+
+public:
+    static const char CREATE_FOLDER = 'D';
+    static const char CREATE_FILE = 'F';
+    static const char WRITE = 'W';
+    static const char REMOVE_FILE = 'R';
+    static const char REMOVE_FOLDER = 'X';
+    // The new absolute path (of the moved node or the copy) is carried as the
+    // record's content
+    static const char MOVE_FILE = 'M';
+    static const char MOVE_FOLDER = 'V';
+    static const char COPY_FILE = 'C';
+    static const char COPY_FOLDER = 'K';
+
+    Journal(IoBackend &backend, const string &path);
+    Journal(const Journal &) = delete;
+    Journal &operator=(const Journal &) = delete;
+    bool isOpen() const;
+    void setBackend(IoBackend &backend);
+    void append(char op, const string &path, const string &content = "");
+    // Hands any buffered records to the backend; flush() also waits for them
+    void submit();
+    void flush();
+    // The position after every record appended so far; taken with a TreeCut
+    // under the writer lock, so the records before it are the ones the cut
+    // covers
+    uint64_t mark();
+    // Once a snapshot of the cut taken at mark is durable: replaces the log
+    // with a new file holding only the records after mark. False (keeping
+    // the whole log) if that file cannot be written.
+    bool dropBefore(uint64_t mark);
+    ~Journal();
+
+    static void encode(string &buffer, char op, const string &path, const string &content = "");
+    // Writes every folder and file in cut to path and waits until it is
+    // durable; needs no lock, only the cut's ReadGuard
+    static bool writeSnapshot(const TreeCut &cut, IoBackend &backend, const string &path, size_t &records);
+    // Applies a snapshot or journal to store; returns false if it cannot be read
+    static bool replay(Storage &store, const string &path, size_t &records);
+};
+
+#endif
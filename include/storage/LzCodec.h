@@ -0,0 +1,24 @@
+// include/storage/LzCodec.h
+
+#ifndef LZCODEC_H
+#define LZCODEC_H
+
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// Small LZ77 codec for the cold content tier, in the style of LZ4: a
+// sequence is a token (literal length, match length), the literals and a
+// 16-bit back-reference offset; lengths of 15 or more continue in 255-valued
+// bytes. Compression follows hash chains to find long matches, which is slow
+// but runs off the read path; decompression is a tight copy loop.
+class LzCodec
+{
+public:
+    static string compress(string_view input);
+    // Returns false if packed is corrupt or does not expand to size bytes
+    static bool decompress(string_view packed, size_t size, string &output);
+};
+
+#endif
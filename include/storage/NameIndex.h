@@ -0,0 +1,165 @@
+// include/storage/NameIndex.h
+
+#ifndef NAMEINDEX_H
+#define NAMEINDEX_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+#include <cstdint>
+#include "./Epoch.h"
+
+using namespace std;
+
+// Every file and folder name in a Storage, for locate. Each distinct name
+// has a posting list of the nodes that carry it, and each distinct
+// extension (as File splits it, after the first dot) one of the files and
+// folders that have it. The distinct names and extensions are kept in copy-on-write
+// B+trees, so a name prefix is a range found by one descent.
+//
+// Readers never lock. A published tree node is never modified: a writer
+// builds new nodes, publishes the new root and then retires the old ones
+// to the EpochManager. New names are first appended to a small pending
+// batch, which readers sort and merge into what they read from the tree,
+// and are added to the tree a batch at a time, so a tree node is copied
+// once per batch rather than once per name. A name whose last node is removed keeps its
+// empty posting list until empty lists outnumber the rest and the tree is
+// rebuilt without them.
+//
+// A posting list only grows in place, by writing the new slot before
+// publishing its size, and is copied when full. Removing a node clears its
+// slot, found through a position kept per node, and the list is compacted
+// once cleared slots outnumber live ones. A reader may still see a slot
+// just before it is cleared, so it checks each node against the Storage
+// before using it. Adding or removing a node under a name that is already
+// indexed costs a hash lookup and one slot.
+class NameIndex
+{
+public:
+    // The nodes under one name or extension: 'F' or 'f' and the table
+    // index, packed as index * 2 + (file ? 1 : 0), or CLEARED
+    struct Slots
+    {
+        static const uint64_t CLEARED = ~uint64_t(0);
+
+        size_t capacity;
+        atomic<size_t> size;
+        atomic<uint64_t> *keys;
+
+        explicit Slots(size_t capacity) : capacity(capacity), size(0), keys(new atomic<uint64_t>[capacity]) {}
+        Slots(const Slots &) = delete;
+        Slots &operator=(const Slots &) = delete;
+        ~Slots() { delete[] keys; }
+    };
+
+    struct Posting
+    {
+        const string key;
+        atomic<Slots *> slots;
+        // Writer only
+        size_t live = 0;
+        size_t cleared = 0;
+
+        explicit Posting(const string &key) : key(key), slots(new Slots(4)) {}
+        Posting(const Posting &) = delete;
+        Posting &operator=(const Posting &) = delete;
+        ~Posting() { delete slots.load(memory_order_relaxed); }
+    };
+
+    // Return false to stop the walk
+    typedef function<bool(const Posting &)> PostingVisitor;
+    typedef function<bool(char kind, size_t index)> NodeVisitor;
+
+private:
+    static const size_t NODE_CAPACITY = 64;
+    static const size_t PENDING_CAPACITY = 64;
+
+    // In a leaf, postings holds the sorted postings; in an inner node,
+    // postings[i] is the first posting below children[i]. Either way
+    // postings[0] is the smallest of the subtree.
+    struct Node
+    {
+        bool leaf;
+        vector<const Posting *> postings;
+        vector<const Node *> children;
+    };
+
+    // New postings not yet in the tree, in the order they were added
+    struct Pending
+    {
+        atomic<size_t> size{0};
+        const Posting *postings[PENDING_CAPACITY];
+    };
+
+    struct Tree
+    {
+        atomic<const Node *> root{nullptr};
+        atomic<Pending *> pending{nullptr};
+        // Writer only: the postings by key, each indexed node's slot in its
+        // posting list by packed node, and how many postings are empty
+        unordered_map<string_view, Posting *> byKey;
+        vector<uint32_t> positions;
+        size_t empty = 0;
+    };
+
+    EpochManager &epochs;
+    Tree names;
+    Tree extensions;
+    atomic<size_t> count{0};
+
+    // Adds the sorted postings [first, last) below node (nullptr for an
+    // empty tree). Returns the nodes that replace it, more than one if it
+    // had to split; the nodes it replaces are added to replaced.
+    vector<const Node *> merge(const Node *node, const Posting *const *first, const Posting *const *last,
+                               vector<const Node *> &replaced);
+    // Splits sorted postings or children into nodes of at most NODE_CAPACITY
+    static void fill(bool leaf, const vector<const Posting *> &postings, const vector<const Node *> &children,
+                     vector<const Node *> &out);
+    // Stacks inner nodes over one level of the tree until one root is left
+    static const Node *join(vector<const Node *> level);
+    void addPending(Tree &tree, const Posting *posting);
+    void mergePending(Tree &tree, Pending *pending);
+    void rebuild(Tree &tree);
+    void compact(Tree &tree, Posting &posting);
+    void addTo(Tree &tree, const string &key, uint64_t node);
+    void removeFrom(Tree &tree, const string &key, uint64_t node);
+    // The tree and its pending batch in key order, from the first key at or
+    // after from
+    static bool scan(const Tree &tree, string_view from, const PostingVisitor &visit);
+    static bool scan(const Node *node, string_view from, const PostingVisitor &visit);
+    static void collectNodes(const Node *node, vector<const Node *> &out);
+
+public:
+    explicit NameIndex(EpochManager &epochs);
+    NameIndex(const NameIndex &) = delete;
+    NameIndex &operator=(const NameIndex &) = delete;
+
+    // What File::getExtension gives for a file named name, so folders are
+    // indexed by extension the same way as files
+    static string extensionOf(const string &name);
+    // Whether extension is suffix or ends in "." + suffix, so "gz" matches
+    // both gz and tar.gz
+    static bool extensionMatches(const string &extension, string_view suffix);
+
+    // Writer side, serialised by the caller. kind is 'F' or 'f'.
+    void add(const string &name, char kind, size_t index, const string &extension);
+    void remove(const string &name, char kind, size_t index, const string &extension);
+    size_t size() const { return count.load(memory_order_relaxed); }
+
+    // Reader side, inside an epoch guard.
+    // The distinct names starting with prefix, in order
+    void forEachName(string_view prefix, const PostingVisitor &visit) const;
+    // The distinct extensions equal to suffix or ending in "." + suffix
+    // ("gz" gives both gz and tar.gz). Such extensions are not contiguous in
+    // key order, so every distinct extension in the index is scanned.
+    void forEachExtension(string_view suffix, const PostingVisitor &visit) const;
+    // The nodes of a posting list, which may include removed ones
+    static bool forEachNode(const Posting &posting, const NodeVisitor &visit);
+
+    ~NameIndex();
+};
+
+#endif
@@ -0,0 +1,78 @@
+// include/storage/NodeTable.h
+
+#ifndef NODETABLE_H
+#define NODETABLE_H
+
+#include <atomic>
+#include <cstddef>
+
+using namespace std;
+
+// Append-only table of node pointers indexed by the numeric part of a node
+// id ("F12" -> 12). Storage is allocated in segments that double in size and
+// never move, so readers can index the table while a writer adds entries.
+// Only one thread may call set() at a time.
+template <typename T>
+class NodeTable
+{
+private:
+    static const size_t FIRST_SEGMENT = 1024;
+    static const int SEGMENTS = 40;
+    mutable atomic<atomic<T *> *> segments[SEGMENTS];
+    atomic<size_t> count{0};
+
+    static int segmentOf(size_t index, size_t &offset)
+    {
+        size_t slot = index / FIRST_SEGMENT + 1;
+        int segment = 63 - __builtin_clzll(slot);
+        offset = index - FIRST_SEGMENT * ((size_t(1) << segment) - 1);
+        return segment;
+    }
+
+public:
+    NodeTable()
+    {
+        for (auto &segment : segments)
+            segment.store(nullptr, memory_order_relaxed);
+    }
+    NodeTable(const NodeTable &) = delete;
+    NodeTable &operator=(const NodeTable &) = delete;
+
+    T *get(size_t index) const
+    {
+        if (index >= count.load(memory_order_acquire))
+            return nullptr;
+        size_t offset;
+        atomic<T *> *segment = segments[segmentOf(index, offset)].load(memory_order_acquire);
+        return segment ? segment[offset].load(memory_order_acquire) : nullptr;
+    }
+
+    void set(size_t index, T *node)
+    {
+        size_t offset;
+        int s = segmentOf(index, offset);
+        atomic<T *> *segment = segments[s].load(memory_order_relaxed);
+        if (!segment)
+        {
+            size_t length = FIRST_SEGMENT << s;
+            segment = new atomic<T *>[length];
+            for (size_t i = 0; i < length; i++)
+                segment[i].store(nullptr, memory_order_relaxed);
+            segments[s].store(segment, memory_order_release);
+        }
+        segment[offset].store(node, memory_order_release);
+        if (index >= count.load(memory_order_relaxed))
+            count.store(index + 1, memory_order_release);
+    }
+
+    // One past the highest index ever set
+    size_t size() const { return count.load(memory_order_acquire); }
+
+    ~NodeTable()
+    {
+        for (auto &segment : segments)
+            delete[] segment.load(memory_order_relaxed);
+    }
+};
+
+#endif
@@ -0,0 +1,148 @@
+// include/storage/OperationStats.h
+
+#ifndef OPERATIONSTATS_H
+#define OPERATIONSTATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include "PerfCounters.h"
+
+using namespace std;
+
+// Latency histogram in the style of HdrHistogram: each power of two is split
+// into SUB_BUCKETS linear buckets, so any recorded value is off by at most
+// 1/SUB_BUCKETS (about 3%) from the value reported for its bucket, from 1 ns
+// up to MAX_NANOS. Recording is a few relaxed atomic adds and never blocks;
+// readers may see a count that is a moment ahead of the buckets.
+class LatencyHistogram
+{
+public:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    // Values above about 18 minutes are recorded as 18 minutes
+    static constexpr int MAX_BITS = 40;
+    static constexpr uint64_t MAX_NANOS = (uint64_t(1) << MAX_BITS) - 1;
+    static constexpr int BUCKETS = (MAX_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+private:
+    atomic<uint64_t> counts[BUCKETS];
+    atomic<uint64_t> count{0};
+    atomic<uint64_t> sum{0};
+    atomic<uint64_t> maximum{0};
+
+public:
+    LatencyHistogram();
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    static int bucketOf(uint64_t nanos);
+    // Largest value that lands in the bucket
+    static uint64_t bucketLimit(int bucket);
+
+    void record(uint64_t nanos);
+    uint64_t getCount() const;
+    uint64_t getSum() const;
+    uint64_t getMax() const;
+    uint64_t getBucketCount(int bucket) const;
+    // Smallest bucket limit at or below which a fraction q of the values lie
+    uint64_t percentile(double q) const;
+    void reset();
+};
+
+// Call counts and latency histograms for every FileSystemService operation,
+// one per History operation type. A Storage owns one, so all sessions on a
+// shared tree (every server connection, say) add to the same figures.
+// Histograms are allocated on the first call of their operation.
+//
+// While PerfCounters are enabled each call also adds its counter deltas to
+// per-operation sums, from which writeTable derives IPC and misses per
+// thousand instructions.
+class OperationStats
+{
+public:
+    enum Operation
+    {
+        CREATE_FILE,
+        WRITE_FILE,
+        READ_FILE,
+        REMOVE_FILE,
+        CREATE_FOLDER,
+        REMOVE_FOLDER,
+        CHANGE_DIR,
+        LIST_ITEMS,
+        SHOW_TREE,
+        GREP,
+        GREP_FILE,
+        GREP_RECURSIVE,
+        GREP_OPTIONS,
+        GREP_HELP,
+        FIND,
+        LOCATE,
+        MOVE,
+        COPY,
+        SAVE_SNAPSHOT,
+        LOAD_SNAPSHOT,
+        IMPORT,
+        EXPORT,
+        DISK_USAGE,
+        FREE_SPACE,
+        OPERATION_COUNT
+    };
+
+    // Times the enclosing scope and records it under one operation
+    class Timer
+    {
+    private:
+        OperationStats &stats;
+        Operation operation;
+        // Declared in this order so the counters are read before the clock
+        PerfCounters::Sample counters;
+        bool counting;
+        chrono::steady_clock::time_point started;
+
+    public:
+        Timer(OperationStats &stats, Operation operation);
+        Timer(const Timer &) = delete;
+        Timer &operator=(const Timer &) = delete;
+        ~Timer();
+    };
+
+    // Counter totals for one operation over the calls that were sampled
+    struct CounterSums
+    {
+        atomic<uint64_t> calls{0};
+        atomic<uint64_t> values[PerfCounters::COUNTER_COUNT];
+
+        CounterSums();
+    };
+
+private:
+    atomic<LatencyHistogram *> histograms[OPERATION_COUNT];
+    atomic<CounterSums *> counterSums[OPERATION_COUNT];
+
+public:
+    OperationStats();
+    OperationStats(const OperationStats &) = delete;
+    OperationStats &operator=(const OperationStats &) = delete;
+    ~OperationStats();
+
+    // The History operation type, e.g. "CREATE_FILE"
+    static const char *getName(Operation operation);
+    void record(Operation operation, uint64_t nanos);
+    void recordCounters(Operation operation, const PerfCounters::Sample &start, const PerfCounters::Sample &end);
+    // Null until the operation has been called
+    const LatencyHistogram *getHistogram(Operation operation) const;
+    // Null until the operation has been called with counters enabled
+    const CounterSums *getCounterSums(Operation operation) const;
+    void reset();
+
+    // One row per operation called so far, latencies in microseconds, then
+    // a counter table if any calls were sampled
+    void writeTable(ostream &out) const;
+    // Counts, percentiles and every non-empty bucket, latencies in ns
+    void writeJson(ostream &out) const;
+};
+
+#endif
@@ -0,0 +1,56 @@
+// include/storage/PerfCounters.h
+
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// Hardware (and a few software) performance counters read through Linux
+// perf_event_open, for attributing cycles and misses to the operations in
+// OperationStats. Counters are per thread and count user space only: each
+// thread that reads them opens its own group on first use, and one read()
+// returns the whole group. Counters the kernel or the machine does not
+// provide (no PMU in most VMs, perf_event_paranoid above 2) are left out
+// and reported as unavailable.
+class PerfCounters
+{
+public:
+    enum Counter
+    {
+        CYCLES,
+        INSTRUCTIONS,
+        CACHE_MISSES,
+        BRANCH_MISSES,
+        TASK_CLOCK,
+        PAGE_FAULTS,
+        COUNTER_COUNT
+    };
+
+    // Counter values at one moment, scaled up if the kernel had to
+    // multiplex the group
+    struct Sample
+    {
+        uint64_t values[COUNTER_COUNT] = {};
+    };
+
+private:
+    static atomic<bool> enabled;
+    static atomic<uint32_t> available;
+
+public:
+    // Opens the counters on the calling thread and turns sampling on if at
+    // least one of them works; otherwise returns false with the reason
+    static bool enable(string &error);
+    static void disable();
+    static bool isEnabled() { return enabled.load(memory_order_relaxed); }
+    static bool isAvailable(Counter counter) { return available.load(memory_order_relaxed) & (1u << counter); }
+    static const char *getName(Counter counter);
+    // Current values for the calling thread; false if it has no counters
+    static bool read(Sample &sample);
+};
+
+#endif
@@ -0,0 +1,119 @@
+// include/storage/SlowCommandLog.h
+
+#ifndef SLOWCOMMANDLOG_H
+#define SLOWCOMMANDLOG_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Commands slower than a threshold, kept in a ring of the last CAPACITY
+// and optionally appended to a host file as JSON lines. A Storage owns one,
+// so in server mode it covers every connection.
+//
+// While a command runs, its thread counts the nodes it touches (path
+// components looked up, children scanned, nodes walked by tree, rmdir,
+// grep and du) and the time spent in a few phases. Those counters are plain
+// thread-local adds; the phase clocks are only read while the log is on. A
+// command under the threshold costs two clock reads and allocates nothing;
+// only slow commands are copied into the ring.
+class SlowCommandLog
+{
+public:
+    static const size_t CAPACITY = 128;
+
+    enum Phase
+    {
+        PARSE,
+        RESOLVE,
+        LOCK_WAIT,
+        HISTORY,
+        PHASE_COUNT
+    };
+
+    struct Entry
+    {
+        time_t time;
+        uint64_t nanos;
+        string command;
+        string currentPath;
+        uint64_t nodes;
+        uint64_t phases[PHASE_COUNT];
+    };
+
+    // The running command's counters, per thread
+    struct Probe
+    {
+        bool active;
+        uint64_t nodes;
+        uint64_t phases[PHASE_COUNT];
+    };
+    inline static thread_local Probe probe{};
+
+    static uint64_t now()
+    {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    static void touch(uint64_t nodes) { probe.nodes += nodes; }
+
+    // Adds the enclosing scope's time to one phase of the running command
+    class PhaseTimer
+    {
+    private:
+        Phase phase;
+        uint64_t start;
+
+    public:
+        explicit PhaseTimer(Phase phase) : phase(phase), start(probe.active ? now() : 0) {}
+        PhaseTimer(const PhaseTimer &) = delete;
+        PhaseTimer &operator=(const PhaseTimer &) = delete;
+        ~PhaseTimer()
+        {
+            if (start)
+                probe.phases[phase] += now() - start;
+        }
+    };
+
+private:
+    atomic<uint64_t> thresholdNanos{0};
+    mutable mutex lock;
+    vector<Entry> entries;
+    uint64_t written = 0;
+    ofstream file;
+    string filePath;
+
+public:
+    SlowCommandLog() = default;
+    SlowCommandLog(const SlowCommandLog &) = delete;
+    SlowCommandLog &operator=(const SlowCommandLog &) = delete;
+
+    static const char *getName(Phase phase);
+
+    // 0 turns the log off
+    void setThreshold(uint64_t nanos) { thresholdNanos.store(nanos, memory_order_relaxed); }
+    uint64_t getThreshold() const { return thresholdNanos.load(memory_order_relaxed); }
+    // Appends every later entry to hostPath; an empty path stops appending
+    bool setFile(const string &hostPath);
+
+    // Starts timing a command on this thread; returns 0 if the log is off
+    uint64_t begin();
+    // Stops timing; returns the latency if it reached the threshold, else 0
+    uint64_t end(uint64_t started);
+    // Keeps the command that just ended, with the counters of its thread
+    void record(string_view command, const string &currentPath, uint64_t nanos);
+
+    void clear();
+    // Oldest first
+    void write(ostream &out) const;
+};
+
+#endif
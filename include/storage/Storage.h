@@ -6,45 +6,222 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <string_view>
 #include <iostream>
-#include "../models/FileSystem.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "../models/Session.h"
 #include "../models/File.h"
 #include "../models/Folder.h"
+#include "./BlobStore.h"
+#include "./ChildList.h"
+#include "./DentryCache.h"
+#include "./Epoch.h"
+#include "./FolderUsage.h"
+#include "./GlobPattern.h"
+#include "./IoBackend.h"
+#include "./Journal.h"
+#include "./NameIndex.h"
+#include "./NodeTable.h"
+#include "./OperationStats.h"
+#include "./SlowCommandLog.h"
 
 using namespace std;
 
+// Storage is safe to share between threads. Readers (ls, tree, grep, getPath)
+// never take a lock: folders, files and each folder's ChildList are published
+// through atomic pointers and are never modified once visible. Writers
+// (touch, write, mkdir, rm) are serialised by a mutex, build new versions
+// and retire the old ones to an EpochManager, which frees them once no reader
+// can still see them. Pointers returned by getFile/getFolder are only valid
+// while the caller holds a ReadGuard.
+//
+// Storage has no current directory of its own. Every cwd-relative operation
+// takes the caller's Session, which also supplies the output stream. Names
+// passed to those operations may be paths: absolute ("/a/b", where "/" is the
+// root folder) or relative to the session's folder, with "." and "..".
+// Each component is resolved through the session's DentryCache.
+//
+// With a journal open, every successful mutation is appended to it by
+// absolute path while the writer lock is held, so the journal order is the
+// order the changes were applied in. Journal and snapshot writes go through
+// the Storage's IoBackend (synchronous until setIoBackend is called).
+//
+// Every name is also kept in a NameIndex covering the whole tree, so
+// locate finds a name without visiting folders.
+//
+// Moving a file or folder publishes a copy of that one node with its new
+// parent and name and swaps the two parents' ChildLists; nothing below a
+// moved folder is touched. Dentry cache entries are checked against the
+// ChildList version, so only lookups in the two parents go stale. A
+// session's cached path is recomputed once a folder has moved or been
+// removed since it was taken (pathGeneration).
+//
+// Copying builds new nodes and ChildLists for the copy, but a copied file
+// shares its content Blob with the source; a later write to either one
+// gives it a Blob of its own.
+//
+// Every folder carries a FolderUsage with the totals of its subtree, kept up
+// to date by the writers, so du and df never walk the tree.
 class Storage
 {
 private:
-    map<string, map<string, int>> tree;
-    FileSystem *fileSystem;
-    map<string, Folder *> folders;
-    map<string, File *> files;
-    Storage();
-    static Storage* instance;
+    // Declared first so it outlives every File that references it
+    mutable BlobStore blobs;
+    NodeTable<const ChildList> tree;
+    NodeTable<Folder> folders;
+    NodeTable<File> files;
+    NodeTable<FolderUsage> usage;
+    static const size_t ROOT_INDEX = 1;
+    size_t nextFolderIndex;
+    size_t nextFileIndex;
+    uint64_t nextVersion;
+    mutable EpochManager epochs;
+    // Every name below the root, for locate; declared after epochs so it
+    // is freed first
+    NameIndex names;
+    // Bumped whenever a folder moves, so cached session paths are refreshed
+    atomic<uint64_t> pathGeneration;
+    mutable mutex writeMutex;
+    // One save at a time, so journal marks are dropped in order
+    mutex snapshotMutex;
+    IoBackend *ioBackend;
+    Journal *journal;
+    thread compactor;
+    mutex compactorMutex;
+    condition_variable compactorWake;
+    bool compactorStopping;
+    OperationStats operationStats;
+    SlowCommandLog slowCommandLog;
+
+    // Lookups; callers must already hold a guard
+    static bool parseId(const string &id, char kind, size_t &index);
+    Folder *findFolder(const string &id) const;
+    File *findFile(const string &id) const;
+    const ChildList *findChildren(const string &folderId) const;
+
+    // Writer-only helpers that swap in a new version and retire the old one
+    void publishChildren(const string &folderId, ChildList *children);
+
+    // Path resolution on table indices; callers must already hold a guard
+    size_t currentFolderIndex(Session &session) const;
+    bool lookupChild(Session &session, size_t folderIndex, string_view name, char kind, size_t &child) const;
+    bool resolveFolderIndex(Session &session, size_t baseIndex, string_view path, size_t &folderIndex) const;
+    bool resolveParentIndex(Session &session, size_t baseIndex, string_view path, size_t &folderIndex, string &leaf) const;
+
+    // Adds the deltas to folderIndex and each of its ancestors; writer only
+    void addUsage(size_t folderIndex, int64_t bytes, int64_t files, int64_t folders);
+    static uint64_t contentSize(const File *file);
+
+    // "/a/b/leaf" for leaf inside folder folderIndex; callers hold a guard
+    string absolutePath(size_t folderIndex, const string &leaf) const;
+
+    // Moves the file ('f') or folder ('F') at index from folder parent to
+    // folder target under name; writer only. False (with a message) if the
+    // name is taken or a folder would end up below itself.
+    bool moveNode(Session &session, char kind, size_t index, size_t parent, size_t target, const string &name);
+    // True if folderIndex is ancestor or lies below it
+    bool isWithin(size_t folderIndex, size_t ancestor) const;
+
+    // cp: copies the file or folder at index (inside parent) into target
+    // under name, linking the finished copy in one publish; writer only.
+    // False (with a message) if the name is taken or a folder would be
+    // copied into itself.
+    bool copyNode(Session &session, char kind, size_t index, size_t parent, size_t target, const string &name);
+    // New nodes for a file, or a folder and everything below it, sharing
+    // every content blob with the source; return the copy.
+    File *cloneFile(const File *file, const string &name, const string &folderId);
+    size_t cloneFolder(size_t source, const string &name, const string &parentId);
+
+    // Children of folderIndex of the given kind ('F', 'f', or 0 for both)
+    // whose names match glob, in name order; callers hold a guard
+    vector<ChildList::Named> matchChildren(size_t folderIndex, const GlobPattern &glob, char kind) const;
 
 public:
-    static Storage* getInstance();
-    void addContent(string fileName, string content);
+    // Read-side critical section: keeps every node and ChildList observed
+    // inside it alive. Costs no lock and may be nested freely.
+    class ReadGuard
+    {
+    private:
+        EpochManager::Guard epoch;
+
+    public:
+        explicit ReadGuard(const Storage &store);
+    };
+
+    // Serialises writers. Reentrant per thread, so a write operation can call
+    // other Storage methods; retired versions are collected on release.
+    class WriteGuard
+    {
+    private:
+        const Storage *locked;
+
+    public:
+        explicit WriteGuard(const Storage &store);
+        WriteGuard(const WriteGuard &) = delete;
+        WriteGuard &operator=(const WriteGuard &) = delete;
+        ~WriteGuard();
+    };
+
+    Storage();
+    Storage(const Storage &) = delete;
+    Storage &operator=(const Storage &) = delete;
+    string getRootFolderId();
+    Session openSession(ostream &out = cout);
+    string resolveFolder(Session &session, string path);
+    string resolveFile(Session &session, string path);
+    void addContent(Session &session, string fileName, string content);
     string getNewFileId();
     string getNewFolderId();
-    void addFile(string name, string folderId);
-    void addFolder(string name, string parentFodlerId);
+    void addFile(Session &session, string name, string folderId);
+    void addFolder(Session &session, string name, string parentFodlerId);
     Folder *getFolder(string id);
     File *getFile(string id);
-    void showFolderPath(string id);
-    void showFilePath(string id);
-    void showItemsInFolder(string folderId);
-    void getIntoFolder(string name);
-    bool validateFolder(string folderName);
-    void removeFile(string fileName);
-    bool validateFile(string fileName);
-    void removeFolder(string folderName);
+    // The folder's children, or nullptr; valid while the caller holds a ReadGuard
+    const ChildList *getChildren(const string &folderId);
+    void showFolderPath(Session &session, string id);
+    void showFilePath(Session &session, string id);
+    void showItemsInFolder(Session &session, string folderId);
+    void getIntoFolder(Session &session, string name);
+    bool validateFolder(Session &session, string folderName);
+    void removeFile(Session &session, string fileName);
+    bool validateFile(Session &session, string fileName);
+    void removeFolder(Session &session, string folderName);
+    // mv: moves the folder (or, if there is none, the file) at source into
+    // the folder destination names, or to the path destination if no such
+    // folder exists. Costs the same whatever the size of a moved subtree.
+    void moveItem(Session &session, string source, string destination);
+    // Moves the file ('f') or folder ('F') at source to exactly the path
+    // destination; what the journal replays
+    void renameItem(Session &session, char kind, string source, string destination);
+    // cp: copies the file at source, or with recursive the folder, to
+    // destination as mv would move it. Contents are shared with the source
+    // rather than copied, so the cost is one new node per file and folder.
+    void copyItem(Session &session, string source, string destination, bool recursive);
+    // Copies the file ('f') or folder ('F') at source to exactly the path
+    // destination; what the journal replays
+    void duplicateItem(Session &session, char kind, string source, string destination);
+    // The session's current path, recomputed if a folder has moved since it
+    // was cached
+    string currentPath(Session &session);
+
+    // Glob patterns in the last path component ("logs/*.log"): every
+    // matching child is handled in one pass over the folder's name index,
+    // and a removal publishes the folder's ChildList once. Return how many
+    // children matched.
+    size_t showMatchingItems(Session &session, string pattern);
+    size_t removeMatchingFiles(Session &session, string pattern);
+    size_t removeMatchingFolders(Session &session, string pattern);
+    // Every file and folder whose name starts with query, or matches it if
+    // it is a glob, from the global name index rather than a walk. Prints
+    // absolute paths and returns how many matched.
+    size_t locate(Session &session, string query);
     string getPath(string id);
-    void removeDFS(string id);
-    void showFolderTree();
-    void showDFS(string folderId, string symbols);
-    string getCurrentFolderId();
+    void removeDFS(Session &session, string id);
+    void showFolderTree(Session &session);
+    void showDFS(Session &session, string folderId, string symbols);
     
     // Grep support methods
     vector<string> getFileIdsInFolder(string folderId);
@@ -52,8 +229,47 @@ public:
     string getFileIdByName(string fileName, string folderId);
     map<string, File*> getAllFiles();
     map<string, Folder*> getAllFolders();
-    
-    ~Storage() = default;
+
+    // Latency of the FileSystemService operations run against this tree
+    OperationStats &getOperationStats();
+    // Commands slower than its threshold, for every session on this tree
+    SlowCommandLog &getSlowCommandLog();
+
+    // Subtree totals of a folder, read in O(1); false if it does not exist
+    bool getUsage(const string &folderId, UsageTotals &totals);
+
+    // File contents, deduplicated: identical contents share one Blob
+    BlobStore &getBlobStore();
+    // Cold tier: once a second, a background thread compresses contents of
+    // at least minBytes that have not been read for idleSeconds; reads of
+    // cold contents are served from a cache of up to cacheBytes
+    void enableColdTier(size_t minBytes, unsigned idleSeconds, size_t cacheBytes);
+    // One compaction pass; idlePasses counts earlier passes
+    size_t compactColdContent(size_t minBytes, uint64_t idlePasses);
+
+    // Bulk insert for import: adds the named folders and the files (name,
+    // content) directly inside folderId under one writer lock, publishing the
+    // folder's ChildList once and printing nothing. Names that already exist
+    // are kept; for folders their existing id is returned so imports merge.
+    // Contents are moved out of files. Returns the folder ids in folderNames
+    // order and counts skipped files.
+    vector<string> insertBatch(string folderId, const vector<string> &folderNames,
+                               vector<pair<string, string>> &files, size_t &skippedFiles);
+
+    // Persistence
+    void setIoBackend(IoBackend *backend);
+    IoBackend &getIoBackend();
+    bool openJournal(const string &path);
+    // Writers wait only while a TreeCut is taken; the snapshot is then
+    // written, and waited for, outside the writer lock, and the journal
+    // keeps only the records after the cut
+    void saveSnapshot(Session &session, const string &path);
+    void restore(Session &session, const string &path);
+    // Submit buffered journal records without waiting / wait for all writes
+    void submitWrites();
+    void flushWrites();
+
+    ~Storage();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,64 @@
+// include/storage/Trace.h
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+using namespace std;
+
+// Process-wide span tracing, exported as Chrome trace JSON (chrome://tracing,
+// ui.perfetto.dev). Each thread records into its own ring buffer of
+// BUFFER_EVENTS spans, allocated the first time it records; when the ring is
+// full the oldest spans are overwritten. Buffers of exited threads are kept
+// for export and reused by new threads.
+//
+// While tracing is stopped a TraceSpan costs one relaxed load and a branch.
+// Categories and names are stored as pointers, so they must be string
+// literals (or otherwise live as long as the process).
+class Tracer
+{
+private:
+    static atomic<bool> enabled;
+
+public:
+    static const size_t BUFFER_EVENTS = 1 << 16;
+
+    static bool isEnabled() { return enabled.load(memory_order_relaxed); }
+    static uint64_t now()
+    {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Clears every buffer and starts recording
+    static void start();
+    static void stop();
+    static void record(const char *category, const char *name, uint64_t start, uint64_t end);
+    // Writes the recorded spans, oldest first per thread; returns how many
+    static size_t writeChromeJson(ostream &out);
+};
+
+// Records the enclosing scope as one complete ("X") event
+class TraceSpan
+{
+private:
+    const char *category;
+    const char *name;
+    uint64_t start;
+
+public:
+    TraceSpan(const char *category, const char *name)
+        : category(category), name(name), start(Tracer::isEnabled() ? Tracer::now() : 0) {}
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+    ~TraceSpan()
+    {
+        if (start)
+            Tracer::record(category, name, start, Tracer::now());
+    }
+};
+
+#endif
@@ -1,159 +1,219 @@
 // main.cpp
 
 #include "./include/services/FileSystemService.h"
+#include "./include/commands/CommandRegistry.h"
+#include "./include/commands/Commands.h"
+#include "./include/server/Server.h"
+#include "./include/storage/Trace.h"
+#include "./include/storage/PerfCounters.h"
+#include "./include/storage/AllocationStats.h"
 #include <string>
+#include <vector>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
 
 using namespace std;
 
-int main()
+static Server *runningServer = nullptr;
+
+static void stopServer(int)
 {
+    if (runningServer)
+        runningServer->stop();
+}
 
-    FileSystemService *fileSystem = new FileSystemService();
-    cout << "     Available commands are: " << endl;
-    cout << "     mkdir <Folder Name>" << endl;
-    cout << "     rmdir <Folder Name>" << endl;
-    cout << "     cd <Change Current Directory>" << endl;
-    cout << "     pwd" << endl;
-    cout << "     ls" << endl;
-    cout << "     touch <File Name>" << endl;
-    cout << "     write <File Name> <Content>" << endl;
-    cout << "     rm <File Name>" << endl;
-    cout << "     tree" << endl;
-    cout << "     history [number]" << endl;
-    cout << "     history clear" << endl;
-    cout << "     grep <pattern> [filename]" << endl;
-    cout << "     grep -[options] <pattern>" << endl;
-    cout << "     grep --help" << endl;
-    while (true)
+// Persistence: --io picks the write backend, each --restore replays a
+// snapshot or journal in order, then --journal records every later change
+static bool preparePersistence(Storage &store, const string &io, const vector<string> &restores, const string &journalPath)
+{
+    if (io != "sync" && io != "threads" && io != "uring")
     {
-        string currentPath = fileSystem->currentPath();
-        cout << currentPath << ">  ";
-        string command;
-        cin >> command;
-        cout << endl;
-        if (command == "mkdir")
-        {
-            string folderName;
-            cin >> folderName;
-            fileSystem->createFolder(fileSystem->getCurrentFolder(), folderName);
-        }
-        else if (command == "rmdir")
-        {
-            string folderName;
-            cin >> folderName;
-            fileSystem->removeFolder(folderName);
-        }
-        else if (command == "cd")
-        {
-            string folderName;
-            cin >> folderName;
-            fileSystem->getIntoFolder(folderName);
-        }
-        else if (command == "pwd")
-        {
-            cout << fileSystem->currentPath() << endl;
-        }
-        else if (command == "ls")
-        {
-            fileSystem->listAllItems(fileSystem->getCurrentFolder());
-        }
-        else if (command == "touch")
-        {
-            string fileName;
-            cin >> fileName;
-            fileSystem->createFile(fileSystem->getCurrentFolder(), fileName);
-        }
-        else if (command == "write")
-        {
-            string fileName;
-            cin >> fileName;
-            string content;
-            getline(cin, content);
-            fileSystem->addContent(fileName, content);
-        }
-        else if (command == "rm")
-        {
-            string fileName;
-            cin >> fileName;
-            fileSystem->removeFile(fileName);
-        }
-        else if (command == "tree")
-        {
-            fileSystem->showTree(fileSystem->getCurrentFolder());
-        }
-        else if (command == "history")
+        cerr << "Unknown I/O backend " << io << endl;
+        return false;
+    }
+    store.setIoBackend(IoBackend::create(io));
+    Session session = store.openSession(cerr);
+    for (const string &path : restores)
+        store.restore(session, path);
+    if (!journalPath.empty() && !store.openJournal(journalPath))
+    {
+        cerr << "Cannot open journal " << journalPath << endl;
+        return false;
+    }
+    return true;
+}
+
+// --trace <file>: spans from the whole run, written when it ends
+static void writeTrace(const string &tracePath)
+{
+    if (tracePath.empty())
+        return;
+    ofstream out(tracePath);
+    size_t spans = Tracer::writeChromeJson(out);
+    if (!out)
+        cerr << "Cannot write trace " << tracePath << endl;
+    else
+        cerr << spans << " spans written to " << tracePath << endl;
+}
+
+// --alloc-profile: allocations of the whole run, reported when it ends
+static void writeAllocations(bool allocProfile)
+{
+    if (!allocProfile)
+        return;
+    AllocationTracker::stop();
+    AllocationTracker::writeReport(cerr, 20);
+}
+
+// Server mode: --serve-unix <socket path> and/or --serve-tcp <port>;
+// --serve-host-paths lets clients run commands that touch host files
+static int serve(Storage &store, CommandRegistry &registry, const string &unixPath, int tcpPort, bool hostPaths)
+{
+    Server server(store, registry);
+    if (hostPaths)
+        server.allowHostPaths();
+    if (!unixPath.empty())
+    {
+        if (!server.listenUnix(unixPath))
         {
-            string arg;
-            if (cin.peek() != '\n')
-            {
-                cin >> arg;
-                if (arg == "clear")
-                {
-                    fileSystem->clearHistory();
-                }
-                else
-                {
-                    try
-                    {
-                        int count = stoi(arg);
-                        fileSystem->showHistory(count);
-                    }
-                    catch (...)
-                    {
-                        cout << "Invalid number format. Usage: history [number] or history clear" << endl;
-                    }
-                }
-            }
-            else
-            {
-                fileSystem->showHistory();
-            }
+            cerr << "Cannot listen on " << unixPath << endl;
+            return 1;
         }
-        else if (command == "grep")
+        cout << "Listening on unix:" << unixPath << endl;
+    }
+    if (tcpPort > 0)
+    {
+        if (!server.listenTcp(tcpPort))
         {
-            string arg;
-            if (cin.peek() != '\n')
-            {
-                cin >> arg;
-                if (arg == "--help")
-                {
-                    fileSystem->showGrepHelp();
-                }
-                else if (arg.length() > 1 && arg[0] == '-' && arg[1] != '-')
-                {
-                    // Options provided (e.g., -ir, -c)
-                    string options = arg.substr(1);
-                    string pattern;
-                    cin >> pattern;
-                    fileSystem->grepWithOptions(pattern, options);
-                }
-                else
-                {
-                    // Pattern provided, check if filename follows
-                    string pattern = arg;
-                    string fileName;
-                    if (cin.peek() != '\n')
-                    {
-                        cin >> fileName;
-                        fileSystem->grepInFile(pattern, fileName);
-                    }
-                    else
-                    {
-                        fileSystem->grepPattern(pattern);
-                    }
-                }
-            }
-            else
-            {
-                cout << "Usage: grep <pattern> [filename] or grep --help" << endl;
-            }
+            cerr << "Cannot listen on 127.0.0.1:" << tcpPort << endl;
+            return 1;
         }
+        cout << "Listening on 127.0.0.1:" << tcpPort << endl;
+    }
+    runningServer = &server;
+    signal(SIGINT, stopServer);
+    signal(SIGTERM, stopServer);
+    server.run();
+    runningServer = nullptr;
+    store.flushWrites();
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    CommandRegistry registry;
+    registerBuiltinCommands(registry);
+
+    string unixPath;
+    int tcpPort = 0;
+    bool hostPaths = false;
+    string io = "uring";
+    string journalPath;
+    vector<string> restores;
+    int coldAfter = 0;
+    string tracePath;
+    bool perfCounters = false;
+    bool allocProfile = false;
+    double slowMillis = 0;
+    string slowLogPath;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--serve-unix" && i + 1 < argc)
+            unixPath = argv[++i];
+        else if (arg == "--serve-tcp" && i + 1 < argc)
+            tcpPort = atoi(argv[++i]);
+        else if (arg == "--serve-host-paths")
+            hostPaths = true;
+        else if (arg == "--io" && i + 1 < argc)
+            io = argv[++i];
+        else if (arg == "--journal" && i + 1 < argc)
+            journalPath = argv[++i];
+        else if (arg == "--restore" && i + 1 < argc)
+            restores.push_back(argv[++i]);
+        else if (arg == "--cold-after" && i + 1 < argc)
+            coldAfter = atoi(argv[++i]);
+        else if (arg == "--trace" && i + 1 < argc)
+            tracePath = argv[++i];
+        else if (arg == "--perf-counters")
+            perfCounters = true;
+        else if (arg == "--alloc-profile")
+            allocProfile = true;
+        else if (arg == "--slow-log" && i + 1 < argc)
+            slowMillis = atof(argv[++i]);
+        else if (arg == "--slow-log-file" && i + 1 < argc)
+            slowLogPath = argv[++i];
         else
         {
-            cout << "Wrong command!" << endl;
+            cerr << "Usage: " << argv[0] << " [--serve-unix <socket path>] [--serve-tcp <port>] [--serve-host-paths]"
+                 << " [--io sync|threads|uring] [--restore <file>]... [--journal <file>]"
+                 << " [--cold-after <seconds>] [--trace <file>] [--perf-counters]"
+                 << " [--alloc-profile] [--slow-log <milliseconds>] [--slow-log-file <file>]" << endl;
+            return 1;
         }
+    }
+
+    if (!tracePath.empty())
+        Tracer::start();
+    if (allocProfile)
+        AllocationTracker::start();
+    // Per-operation cycles and misses in stats; runs without them if the
+    // machine or the kernel settings do not allow it
+    if (perfCounters)
+    {
+        string error;
+        if (!PerfCounters::enable(error))
+            cerr << "Performance counters unavailable: " << error << endl;
+        else if (!error.empty())
+            cerr << "Performance counters " << error << endl;
+    }
+    Storage store;
+    if (!preparePersistence(store, io, restores, journalPath))
+        return 1;
+    // Commands over slowMillis, kept in memory and optionally appended to a file
+    if (slowMillis > 0)
+        store.getSlowCommandLog().setThreshold(uint64_t(slowMillis * 1e6));
+    if (!slowLogPath.empty() && !store.getSlowCommandLog().setFile(slowLogPath))
+    {
+        cerr << "Cannot open slow command log " << slowLogPath << endl;
+        return 1;
+    }
+    // Compress contents of 4 KiB or more once unread for coldAfter seconds
+    if (coldAfter > 0)
+        store.enableColdTier(4096, coldAfter, 64 << 20);
+    if (!unixPath.empty() || tcpPort > 0)
+    {
+        int status = serve(store, registry, unixPath, tcpPort, hostPaths);
+        writeTrace(tracePath);
+        writeAllocations(allocProfile);
+        return status;
+    }
+
+    FileSystemService *fileSystem = new FileSystemService(store);
+    cout << "     Available commands are: " << endl;
+    for (Command *command : registry.getCommands())
+        for (const string &usage : command->getUsage())
+            cout << "     " << usage << endl;
+
+    string line;
+    while (true)
+    {
+        string currentPath = fileSystem->currentPath();
+        cout << currentPath << ">  ";
+        if (!getline(cin, line))
+            break;
+        cout << endl;
+        registry.execute(fileSystem, line);
+        // Hand the command's journal records to the backend without waiting
+        // for them; the loop only waits at exit (and save waits for its own)
+        store.submitWrites();
         cout << endl;
     }
 
+    store.flushWrites();
+    delete fileSystem;
+    writeTrace(tracePath);
+    writeAllocations(allocProfile);
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,66 @@
+// src/commands/CommandParser.cpp
+
+#include "../../include/commands/CommandParser.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+string_view CommandLine::rest(size_t index) const
+{
+    if (index >= args.size())
+        return string_view();
+    size_t offset = args[index].data() - raw.data();
+    string_view tail = raw.substr(offset);
+    while (!tail.empty() && isSpace(tail.back()))
+        tail.remove_suffix(1);
+    return tail;
+}
+
+CommandLine CommandParser::tokenize(string_view line)
+{
+    CommandLine command;
+    command.raw = line;
+    size_t i = 0;
+    while (i < line.size())
+    {
+        while (i < line.size() && isSpace(line[i]))
+            i++;
+        size_t start = i;
+        while (i < line.size() && !isSpace(line[i]))
+            i++;
+        if (i > start)
+        {
+            if (command.name.empty())
+                command.name = line.substr(start, i - start);
+            else
+                command.args.push_back(line.substr(start, i - start));
+        }
+    }
+    return command;
+}
+
+bool CommandParser::isFlag(string_view token)
+{
+    return token.size() > 1 && token[0] == '-' && token[1] != '-';
+}
+
+GrepOptions CommandParser::parseGrepFlags(string_view flags)
+{
+    GrepOptions options;
+    for (char c : flags)
+    {
+        switch (c)
+        {
+        case 'i': options.caseInsensitive = true; break;
+        case 'r': options.recursive = true; break;
+        case 'c': options.countOnly = true; break;
+        case 'v': options.invertMatch = true; break;
+        case 'n': options.showLineNumbers = true; break;
+        }
+    }
+    return options;
+}
@@ -0,0 +1,124 @@
+// src/commands/CommandRegistry.cpp
+
+#include "../../include/commands/CommandRegistry.h"
+#include "../../include/storage/Trace.h"
+#include "../../include/storage/AllocationStats.h"
+#include "../../include/storage/SlowCommandLog.h"
+#include <vector>
+#include <string>
+#include <string_view>
+#include <iostream>
+
+using namespace std;
+
+uint32_t CommandRegistry::hash(string_view token, uint32_t seed)
+{
+    // FNV-1a with the seed mixed into the offset basis
+    uint32_t h = 2166136261u ^ (seed * 16777619u);
+    for (char c : token)
+    {
+        h ^= static_cast<unsigned char>(c);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void CommandRegistry::rebuild()
+{
+    size_t size = 4;
+    while (size < commands.size() * 2)
+        size <<= 1;
+    while (true)
+    {
+        for (uint32_t s = 0; s < 1024; s++)
+        {
+            vector<Command *> table(size, nullptr);
+            bool collision = false;
+            for (Command *command : commands)
+            {
+                Command *&slot = table[hash(command->getName(), s) & (size - 1)];
+                if (slot)
+                {
+                    collision = true;
+                    break;
+                }
+                slot = command;
+            }
+            if (!collision)
+            {
+                slots.swap(table);
+                seed = s;
+                return;
+            }
+        }
+        size <<= 1;
+    }
+}
+
+void CommandRegistry::add(Command *command)
+{
+    if (find(command->getName()))
+    {
+        cout << "     Command already registered: " << command->getName() << endl;
+        delete command;
+        return;
+    }
+    commands.push_back(command);
+    rebuild();
+}
+
+Command *CommandRegistry::find(string_view name) const
+{
+    if (slots.empty())
+        return nullptr;
+    Command *command = slots[hash(name, seed) & (slots.size() - 1)];
+    if (command && command->getName() == name)
+        return command;
+    return nullptr;
+}
+
+const vector<Command *> &CommandRegistry::getCommands() const { return commands; }
+
+bool CommandRegistry::execute(FileSystemService *fileSystem, string_view line)
+{
+    // Nothing is copied unless the command turns out to be slow
+    SlowCommandLog &slowLog = fileSystem->getStorage().getSlowCommandLog();
+    uint64_t started = slowLog.begin();
+    CommandLine command;
+    {
+        SlowCommandLog::PhaseTimer parsing(SlowCommandLog::PARSE);
+        command = CommandParser::tokenize(line);
+    }
+    if (command.name.empty())
+    {
+        if (started)
+            slowLog.end(started);
+        return true;
+    }
+    Command *handler = find(command.name);
+    if (!handler)
+    {
+        fileSystem->getOutput() << "Wrong command!" << endl;
+        if (started)
+            slowLog.end(started);
+        return false;
+    }
+    {
+        // Command names are string literals, so the span can keep the pointer
+        TraceSpan span("command", handler->getName().data());
+        AllocationScope scope(handler->getName().data());
+        handler->execute(fileSystem, command);
+    }
+    if (started)
+        if (uint64_t elapsed = slowLog.end(started))
+            slowLog.record(line, fileSystem->currentPath(), elapsed);
+    return true;
+}
+
+CommandRegistry::~CommandRegistry()
+{
+    for (Command *command : commands)
+        delete command;
+    commands.clear();
+    slots.clear();
+}
@@ -0,0 +1,487 @@
+// src/commands/Commands.cpp
+
+#include "../../include/commands/Commands.h"
+#include "../../include/commands/CommandParser.h"
+#include "../../include/services/FileSystemService.h"
+#include "../../include/storage/GlobPattern.h"
+#include <vector>
+#include <string>
+#include <string_view>
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+using namespace std;
+
+// Prints the command's usage line number `form` when fewer than count
+// arguments were given, so the message always matches getUsage()
+static bool requireArgs(const Command &command, FileSystemService *fileSystem, const CommandLine &line, size_t count,
+                        size_t form = 0)
+{
+    if (line.argCount() >= count)
+        return true;
+    fileSystem->getOutput() << "Usage: " << command.getUsage()[form] << endl;
+    return false;
+}
+
+string_view MkdirCommand::getName() const { return "mkdir"; }
+vector<string> MkdirCommand::getUsage() const { return {"mkdir <Folder Path>"}; }
+void MkdirCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    if (requireArgs(*this, fileSystem, line, 1))
+        fileSystem->createFolder(fileSystem->getCurrentFolder(), line.arg(0));
+}
+
+string_view RmdirCommand::getName() const { return "rmdir"; }
+vector<string> RmdirCommand::getUsage() const { return {"rmdir <Folder Path | Pattern>"}; }
+void RmdirCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    if (!requireArgs(*this, fileSystem, line, 1))
+        return;
+    if (GlobPattern::isGlob(line.args[0]))
+        fileSystem->removeMatchingFolders(line.arg(0));
+    else
+        fileSystem->removeFolder(line.arg(0));
+}
+
+string_view MvCommand::getName() const { return "mv"; }
+vector<string> MvCommand::getUsage() const { return {"mv <Source Path> <Destination Path>"}; }
+void MvCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    if (requireArgs(*this, fileSystem, line, 2))
+        fileSystem->moveItem(line.arg(0), line.arg(1));
+}
+
+string_view CpCommand::getName() const { return "cp"; }
+vector<string> CpCommand::getUsage() const { return {"cp [-r] <Source Path> <Destination Path>"}; }
+void CpCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    bool recursive = false, valid = true;
+    vector<string> paths;
+    for (size_t i = 0; i < line.argCount(); i++)
+    {
+        string_view arg = line.args[i];
+        if (arg == "-r" || arg == "-R")
+            recursive = true;
+        else if (CommandParser::isFlag(arg))
+            valid = false;
+        else
+            paths.push_back(string(arg));
+    }
+    if (!valid || paths.size() != 2)
+    {
+        fileSystem->getOutput() << "Usage: " << getUsage()[0] << endl;
+        return;
+    }
+    fileSystem->copyItem(paths[0], paths[1], recursive);
+}
+
+string_view CdCommand::getName() const { return "cd"; }
+vector<string> CdCommand::getUsage() const { return {"cd <Folder Path>  (absolute /a/b or relative ../a)"}; }
+void CdCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    if (requireArgs(*this, fileSystem, line, 1))
+        fileSystem->getIntoFolder(line.arg(0));
+}
+
+string_view PwdCommand::getName() const { return "pwd"; }
+vector<string> PwdCommand::getUsage() const { return {"pwd"}; }
+void PwdCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    fileSystem->getOutput() << fileSystem->currentPath() << endl;
+}
+
+string_view LsCommand::getName() const { return "ls"; }
+vector<string> LsCommand::getUsage() const { return {"ls [Folder Path | Pattern]"}; }
+void LsCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    if (line.argCount() > 0 && GlobPattern::isGlob(line.args[0]))
+        fileSystem->listMatchingItems(line.arg(0));
+    else if (line.argCount() > 0)
+        fileSystem->listAllItems(fileSystem->resolveFolder(line.arg(0)));
+    else
+        fileSystem->listAllItems(fileSystem->getCurrentFolder());
+}
+
+string_view TouchCommand::getName() const { return "touch"; }
+vector<string> TouchCommand::getUsage() const { return {"touch <File Path>"}; }
+void TouchCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    if (requireArgs(*this, fileSystem, line, 1))
+        fileSystem->createFile(fileSystem->getCurrentFolder(), line.arg(0));
+}
+
+string_view WriteCommand::getName() const { return "write"; }
+vector<string> WriteCommand::getUsage() const { return {"write <File Path> <Content>"}; }
+void WriteCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    if (requireArgs(*this, fileSystem, line, 1))
+        fileSystem->addContent(line.arg(0), string(line.rest(1)));
+}
+
+string_view CatCommand::getName() const { return "cat"; }
+vector<string> CatCommand::getUsage() const { return {"cat <File Path>"}; }
+void CatCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    if (requireArgs(*this, fileSystem, line, 1))
+        fileSystem->catFile(line.arg(0));
+}
+
+string_view RmCommand::getName() const { return "rm"; }
+vector<string> RmCommand::getUsage() const { return {"rm <File Path | Pattern>"}; }
+void RmCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    if (!requireArgs(*this, fileSystem, line, 1))
+        return;
+    if (GlobPattern::isGlob(line.args[0]))
+        fileSystem->removeMatchingFiles(line.arg(0));
+    else
+        fileSystem->removeFile(line.arg(0));
+}
+
+string_view TreeCommand::getName() const { return "tree"; }
+vector<string> TreeCommand::getUsage() const { return {"tree"}; }
+void TreeCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    fileSystem->showTree(fileSystem->getCurrentFolder());
+}
+
+string_view HistoryCommand::getName() const { return "history"; }
+vector<string> HistoryCommand::getUsage() const { return {"history [number]", "history clear"}; }
+void HistoryCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    if (line.argCount() == 0)
+    {
+        fileSystem->showHistory();
+        return;
+    }
+    string arg = line.arg(0);
+    if (arg == "clear")
+    {
+        fileSystem->clearHistory();
+        return;
+    }
+    try
+    {
+        int count = stoi(arg);
+        fileSystem->showHistory(count);
+    }
+    catch (...)
+    {
+        fileSystem->getOutput() << "Invalid number format. Usage: history [number] or history clear" << endl;
+    }
+}
+
+string_view GrepCommand::getName() const { return "grep"; }
+vector<string> GrepCommand::getUsage() const
+{
+    return {"grep <pattern> [filename]", "grep -[options] <pattern>", "grep --help"};
+}
+void GrepCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    if (line.argCount() == 0)
+    {
+        fileSystem->getOutput() << "Usage: grep <pattern> [filename] or grep --help" << endl;
+        return;
+    }
+    string_view first = line.args[0];
+    if (first == "--help")
+    {
+        fileSystem->showGrepHelp();
+    }
+    else if (CommandParser::isFlag(first))
+    {
+        // Options provided (e.g., -ir, -c)
+        if (requireArgs(*this, fileSystem, line, 2, 1))
+            fileSystem->grepWithOptions(line.arg(1), CommandParser::parseGrepFlags(first.substr(1)), string(first.substr(1)));
+    }
+    else if (line.argCount() > 1)
+    {
+        fileSystem->grepInFile(line.arg(0), line.arg(1));
+    }
+    else
+    {
+        fileSystem->grepPattern(line.arg(0));
+    }
+}
+
+// "[+|-]N[k|M|G]": above, below or exactly N bytes, in units of 1024
+static bool parseSize(string_view text, FindOptions &options)
+{
+    options.hasSize = true;
+    options.sizeCompare = 0;
+    if (!text.empty() && (text[0] == '+' || text[0] == '-'))
+    {
+        options.sizeCompare = text[0] == '+' ? 1 : -1;
+        text.remove_prefix(1);
+    }
+    uint64_t unit = 1;
+    if (!text.empty() && strchr("kKMG", text.back()))
+    {
+        unit = text.back() == 'G' ? 1 << 30 : text.back() == 'M' ? 1 << 20 : 1 << 10;
+        text.remove_suffix(1);
+    }
+    if (text.empty() || text.size() > 15 || text.find_first_not_of("0123456789") != string_view::npos)
+        return false;
+    uint64_t value = stoull(string(text));
+    if (value > UINT64_MAX / unit)
+        return false;
+    options.sizeBytes = value * unit;
+    return true;
+}
+
+string_view FindCommand::getName() const { return "find"; }
+vector<string> FindCommand::getUsage() const
+{
+    return {"find [Folder Path] [-name pattern] [-ext extension] [-type f|d] [-size [+|-]N[k|M|G]] [-maxdepth N]"};
+}
+void FindCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    FindOptions options;
+    string folderPath;
+    for (size_t i = 0; i < line.argCount(); i++)
+    {
+        string_view arg = line.args[i];
+        bool hasValue = i + 1 < line.argCount();
+        bool valid = true;
+        if (arg == "-name" && hasValue)
+            options.namePattern = line.arg(++i);
+        else if (arg == "-ext" && hasValue)
+        {
+            string_view extension = line.args[++i];
+            options.extension = string(extension.substr(extension[0] == '.' ? 1 : 0));
+            valid = !options.extension.empty();
+        }
+        else if (arg == "-type" && hasValue)
+        {
+            string_view type = line.args[++i];
+            options.type = type == "f" ? 'f' : type == "d" ? 'd' : 0;
+            valid = options.type != 0;
+        }
+        else if (arg == "-size" && hasValue)
+            valid = parseSize(line.args[++i], options);
+        else if (arg == "-maxdepth" && hasValue)
+        {
+            try
+            {
+                options.maxDepth = stoi(line.arg(++i));
+            }
+            catch (...)
+            {
+                options.maxDepth = -1;
+            }
+            valid = options.maxDepth >= 0;
+        }
+        else if (!CommandParser::isFlag(arg) && folderPath.empty())
+            folderPath = string(arg);
+        else
+            valid = false;
+        if (!valid)
+        {
+            fileSystem->getOutput() << "Usage: " << getUsage()[0] << endl;
+            return;
+        }
+    }
+    fileSystem->findItems(folderPath, options, string(line.rest(0)));
+}
+
+string_view LocateCommand::getName() const { return "locate"; }
+vector<string> LocateCommand::getUsage() const { return {"locate <Name Prefix | Pattern>"}; }
+void LocateCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    if (requireArgs(*this, fileSystem, line, 1))
+        fileSystem->locate(line.arg(0));
+}
+
+string_view SaveCommand::getName() const { return "save"; }
+vector<string> SaveCommand::getUsage() const { return {"save <Host File Path>"}; }
+void SaveCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    if (requireArgs(*this, fileSystem, line, 1))
+        fileSystem->saveSnapshot(string(line.rest(0)));
+}
+
+string_view LoadCommand::getName() const { return "load"; }
+vector<string> LoadCommand::getUsage() const { return {"load <Host File Path>"}; }
+void LoadCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    if (requireArgs(*this, fileSystem, line, 1))
+        fileSystem->loadSnapshot(string(line.rest(0)));
+}
+
+string_view ImportCommand::getName() const { return "import"; }
+vector<string> ImportCommand::getUsage() const { return {"import <Host Path>"}; }
+void ImportCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    if (requireArgs(*this, fileSystem, line, 1))
+        fileSystem->importTree(string(line.rest(0)));
+}
+
+string_view ExportCommand::getName() const { return "export"; }
+vector<string> ExportCommand::getUsage() const { return {"export <Host Directory | Host File.tar>"}; }
+void ExportCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    if (requireArgs(*this, fileSystem, line, 1))
+        fileSystem->exportTree(string(line.rest(0)));
+}
+
+string_view DuCommand::getName() const { return "du"; }
+vector<string> DuCommand::getUsage() const { return {"du [-h] [-d depth] [Folder Path]"}; }
+void DuCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    bool humanReadable = false;
+    int maxDepth = -1;
+    string folderPath;
+    for (size_t i = 0; i < line.argCount(); i++)
+    {
+        string_view arg = line.args[i];
+        if (arg == "-h")
+            humanReadable = true;
+        else if (arg == "-d" && i + 1 < line.argCount())
+        {
+            try
+            {
+                maxDepth = stoi(line.arg(++i));
+            }
+            catch (...)
+            {
+                maxDepth = -2;
+            }
+            if (maxDepth < 0)
+            {
+                fileSystem->getOutput() << "Invalid depth. Usage: du [-h] [-d depth] [Folder Path]" << endl;
+                return;
+            }
+        }
+        else if (!CommandParser::isFlag(arg) && folderPath.empty())
+            folderPath = string(arg);
+        else
+        {
+            fileSystem->getOutput() << "Usage: du [-h] [-d depth] [Folder Path]" << endl;
+            return;
+        }
+    }
+    fileSystem->showDiskUsage(folderPath, humanReadable, maxDepth, string(line.rest(0)));
+}
+
+string_view DfCommand::getName() const { return "df"; }
+vector<string> DfCommand::getUsage() const { return {"df [-h]"}; }
+void DfCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    fileSystem->showFreeSpace(line.argCount() > 0 && line.args[0] == "-h");
+}
+
+string_view StatsCommand::getName() const { return "stats"; }
+vector<string> StatsCommand::getUsage() const { return {"stats", "stats --json [Host File Path]", "stats reset"}; }
+void StatsCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    if (line.argCount() == 0)
+        fileSystem->showStats();
+    else if (line.args[0] == "--json")
+        fileSystem->dumpStats(string(line.rest(1)));
+    else if (line.args[0] == "reset")
+        fileSystem->resetStats();
+    else
+        fileSystem->getOutput() << "Usage: stats, stats --json [Host File Path] or stats reset" << endl;
+}
+
+string_view TraceCommand::getName() const { return "trace"; }
+vector<string> TraceCommand::getUsage() const { return {"trace start | stop", "trace dump <Host File Path>"}; }
+void TraceCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    string action = line.arg(0);
+    if (action == "start")
+        fileSystem->startTrace();
+    else if (action == "stop")
+        fileSystem->stopTrace();
+    else if (action == "dump" && line.argCount() > 1)
+        fileSystem->dumpTrace(string(line.rest(1)));
+    else
+        fileSystem->getOutput() << "Usage: trace start, trace stop or trace dump <Host File Path>" << endl;
+}
+
+string_view AllocsCommand::getName() const { return "allocs"; }
+vector<string> AllocsCommand::getUsage() const { return {"allocs start | stop | reset", "allocs [number of call sites]"}; }
+void AllocsCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    string action = line.arg(0);
+    if (action == "start")
+        fileSystem->startAllocationProfile();
+    else if (action == "stop")
+        fileSystem->stopAllocationProfile();
+    else if (action == "reset")
+        fileSystem->resetAllocations();
+    else if (line.argCount() == 0)
+        fileSystem->showAllocations(10);
+    else
+    {
+        try
+        {
+            fileSystem->showAllocations(size_t(max(0, stoi(action))));
+        }
+        catch (...)
+        {
+            fileSystem->getOutput() << "Usage: allocs start, allocs stop, allocs reset or allocs [number of call sites]" << endl;
+        }
+    }
+}
+
+string_view SlowlogCommand::getName() const { return "slowlog"; }
+vector<string> SlowlogCommand::getUsage() const
+{
+    return {"slowlog [clear]", "slowlog threshold <milliseconds>", "slowlog file <Host File Path> | off"};
+}
+void SlowlogCommand::execute(FileSystemService *fileSystem, const CommandLine &line)
+{
+    string action = line.arg(0);
+    if (line.argCount() == 0)
+        fileSystem->showSlowCommands();
+    else if (action == "clear")
+        fileSystem->clearSlowCommands();
+    else if (action == "file" && line.argCount() > 1)
+        fileSystem->setSlowCommandFile(line.arg(1) == "off" ? "" : string(line.rest(1)));
+    else if (action == "threshold" && line.argCount() > 1)
+    {
+        try
+        {
+            fileSystem->setSlowCommandThreshold(max(0.0, stod(line.arg(1))));
+        }
+        catch (...)
+        {
+            fileSystem->getOutput() << "Invalid number format. Usage: slowlog threshold <milliseconds>" << endl;
+        }
+    }
+    else
+        fileSystem->getOutput() << "Usage: slowlog, slowlog clear, slowlog threshold <milliseconds> or slowlog file <Host File Path> | off" << endl;
+}
+
+void registerBuiltinCommands(CommandRegistry &registry)
+{
+    registry.add(new MkdirCommand());
+    registry.add(new RmdirCommand());
+    registry.add(new MvCommand());
+    registry.add(new CpCommand());
+    registry.add(new CdCommand());
+    registry.add(new PwdCommand());
+    registry.add(new LsCommand());
+    registry.add(new TouchCommand());
+    registry.add(new WriteCommand());
+    registry.add(new CatCommand());
+    registry.add(new RmCommand());
+    registry.add(new TreeCommand());
+    registry.add(new HistoryCommand());
+    registry.add(new GrepCommand());
+    registry.add(new FindCommand());
+    registry.add(new LocateCommand());
+    registry.add(new SaveCommand());
+    registry.add(new LoadCommand());
+    registry.add(new ImportCommand());
+    registry.add(new ExportCommand());
+    registry.add(new DuCommand());
+    registry.add(new DfCommand());
+    registry.add(new StatsCommand());
+    registry.add(new TraceCommand());
+    registry.add(new AllocsCommand());
+    registry.add(new SlowlogCommand());
+}
@@ -7,28 +7,48 @@
 #include "../../include/models/File.h"
 using namespace std;
 
-File::File(string id, string fileName, string folderId) : id(id), folderId(folderId)
+File::File(string id, string fileName, string folderId) : id(id), content(nullptr), folderId(folderId)
 {
-    string n;
-    int ind;
-    for (int i = 0; i < fileName.size(); i++)
-        if (fileName[i] == '.')
-        {
-            ind = i;
-            break;
-        }
-    n = fileName.substr(0, ind);
-    string ex = fileName.substr(ind + 1, n.size() - ind - 1);
-    name = n;
-    extension = ex;
+    // Split at the first dot unless it ends the name, so getFileName()
+    // always gives back exactly what was passed in
+    size_t dot = fileName.find('.');
+    if (dot == string::npos || dot + 1 == fileName.size())
+        dot = fileName.size();
+    name = fileName.substr(0, dot);
+    extension = dot < fileName.size() ? fileName.substr(dot + 1) : "";
 }
 
-void File::setContent(string content) { this->content = content; }
+File::File(const File &other)
+    : id(other.id), name(other.name), content(other.content ? other.content->store->retain(other.content) : nullptr),
+      extension(other.extension), folderId(other.folderId)
+{
+}
+
+void File::setContent(const Blob *blob)
+{
+    if (content)
+        content->store->release(content);
+    content = blob;
+}
+
+BlobContent File::getContent()
+{
+    static const string empty;
+    return content ? content->store->read(content) : BlobContent(&empty);
+}
+
+const Blob *File::getBlob() const { return content; }
 
-string File::getContent() { return content; }
+File::~File()
+{
+    if (content)
+        content->store->release(content);
+}
 
 string File::getId() { return id; }
 
-string File::getFileName() { return name + "." + extension; }
+string File::getFileName() { return extension.empty() ? name : name + "." + extension; }
+
+const string &File::getExtension() const { return extension; }
 
 string File::getFolderId() { return folderId; }
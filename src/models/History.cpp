@@ -6,10 +6,8 @@
 
 using namespace std;
 
-int History::nextId = 1;
-
-History::History(string command, string operationType, string target, string currentPath)
-    : id(nextId++), command(command), operationType(operationType), target(target), 
+History::History(int id, string command, string operationType, string target, string currentPath)
+    : id(id), command(command), operationType(operationType), target(target), 
       currentPath(currentPath), timestamp(time(nullptr))
 {
 }
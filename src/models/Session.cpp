@@ -0,0 +1,25 @@
+// src/models/Session.cpp
+
+#include "../../include/models/Session.h"
+#include <string>
+#include <iostream>
+using namespace std;
+
+Session::Session(string folderId, string path, ostream &out) : currentFolderId(folderId), currentPath(path), pathGeneration(0), out(&out) {}
+
+string Session::getCurrentFolderId() const { return currentFolderId; }
+
+string Session::getCurrentPath() const { return currentPath; }
+
+void Session::setCurrentFolder(string folderId, string path, uint64_t generation)
+{
+    currentFolderId = folderId;
+    currentPath = path;
+    pathGeneration = generation;
+}
+
+uint64_t Session::getPathGeneration() const { return pathGeneration; }
+
+ostream &Session::getOutput() const { return *out; }
+
+DentryCache &Session::getDentries() { return dentries; }
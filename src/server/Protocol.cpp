@@ -0,0 +1,93 @@
+// src/server/Protocol.cpp
+
+#include "../../include/server/Protocol.h"
+#include <string>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+
+using namespace std;
+
+void Protocol::appendFrame(string &buffer, const string &payload)
+{
+    uint32_t length = payload.size();
+    char header[4] = {char(length >> 24), char(length >> 16), char(length >> 8), char(length)};
+    buffer.append(header, 4);
+    buffer.append(payload);
+}
+
+size_t Protocol::frameSize(const string &buffer)
+{
+    if (buffer.size() < 4)
+        return 0;
+    const unsigned char *header = reinterpret_cast<const unsigned char *>(buffer.data());
+    return 4 + ((size_t(header[0]) << 24) | (size_t(header[1]) << 16) | (size_t(header[2]) << 8) | header[3]);
+}
+
+bool Protocol::takeFrame(string &buffer, string &payload, bool &error)
+{
+    error = false;
+    if (buffer.size() < 4)
+        return false;
+    const unsigned char *header = reinterpret_cast<const unsigned char *>(buffer.data());
+    uint32_t length = (uint32_t(header[0]) << 24) | (uint32_t(header[1]) << 16) | (uint32_t(header[2]) << 8) | header[3];
+    if (length > MAX_FRAME)
+    {
+        error = true;
+        return false;
+    }
+    if (buffer.size() < 4 + size_t(length))
+        return false;
+    payload.assign(buffer, 4, length);
+    buffer.erase(0, 4 + size_t(length));
+    return true;
+}
+
+static bool writeAll(int fd, const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = send(fd, data, size, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return false;
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+static bool readAll(int fd, char *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t got = recv(fd, data, size, 0);
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got <= 0)
+            return false;
+        data += got;
+        size -= got;
+    }
+    return true;
+}
+
+bool Protocol::writeFrame(int fd, const string &payload)
+{
+    string frame;
+    appendFrame(frame, payload);
+    return writeAll(fd, frame.data(), frame.size());
+}
+
+bool Protocol::readFrame(int fd, string &payload)
+{
+    unsigned char header[4];
+    if (!readAll(fd, reinterpret_cast<char *>(header), 4))
+        return false;
+    uint32_t length = (uint32_t(header[0]) << 24) | (uint32_t(header[1]) << 16) | (uint32_t(header[2]) << 8) | header[3];
+    if (length > MAX_FRAME)
+        return false;
+    payload.resize(length);
+    return length == 0 || readAll(fd, &payload[0], length);
+}
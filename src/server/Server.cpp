@@ -0,0 +1,264 @@
+// src/server/Server.cpp
+
+#include "../../include/server/Server.h"
+#include "../../include/server/Protocol.h"
+#include <map>
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <iostream>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+using namespace std;
+
+static bool setNonBlocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+Server::Server(Storage &store, CommandRegistry &registry)
+    : store(store), registry(registry), epollFd(epoll_create1(0)), stopping(false), hostPaths(false)
+{
+}
+
+bool Server::addListener(int fd)
+{
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (listen(fd, SOMAXCONN) != 0 || !setNonBlocking(fd) || epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    listeners.push_back(fd);
+    return true;
+}
+
+bool Server::listenUnix(const string &path)
+{
+    sockaddr_un address = {};
+    if (path.size() >= sizeof(address.sun_path))
+        return false;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return false;
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    unixPath = path;
+    return addListener(fd);
+}
+
+bool Server::listenTcp(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return false;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    return addListener(fd);
+}
+
+void Server::allowHostPaths()
+{
+    hostPaths = true;
+}
+
+void Server::acceptClients(int listener)
+{
+    while (true)
+    {
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0)
+            return;
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        setNonBlocking(fd);
+        Connection *connection = new Connection();
+        connection->fd = fd;
+        connection->fileSystem = new FileSystemService(store, connection->captured);
+        connection->fileSystem->setHostAccess(hostPaths);
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+        connections[fd] = connection;
+    }
+}
+
+void Server::readFrom(Connection *connection)
+{
+    char buffer[64 * 1024];
+    // Bounded per wakeup: epoll is level-triggered, so whatever is left in
+    // the socket is reported again. A header advertising more than MAX_FRAME
+    // closes the connection before anything more is buffered.
+    while (true)
+    {
+        size_t frame = Protocol::frameSize(connection->input);
+        if (frame > size_t(4) + Protocol::MAX_FRAME)
+        {
+            close(connection);
+            return;
+        }
+        if (connection->input.size() >= max(size_t(INPUT_LIMIT), frame))
+            break;
+        ssize_t got = recv(connection->fd, buffer, sizeof(buffer), 0);
+        if (got > 0)
+        {
+            connection->input.append(buffer, got);
+            continue;
+        }
+        if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got == 0)
+        {
+            // A half-close: requests already received are still answered
+            connection->peerClosed = true;
+            break;
+        }
+        close(connection);
+        return;
+    }
+    serve(connection);
+}
+
+void Server::serve(Connection *connection)
+{
+    // Answer complete requests, in order, while the client keeps reading
+    string request;
+    bool error = false;
+    while (connection->output.size() < OUTPUT_HIGH_WATER && Protocol::takeFrame(connection->input, request, error))
+    {
+        connection->captured.str("");
+        connection->captured.clear();
+        registry.execute(connection->fileSystem, request);
+        Protocol::appendFrame(connection->output, connection->captured.str());
+    }
+    if (error)
+    {
+        close(connection);
+        return;
+    }
+    flush(connection);
+}
+
+bool Server::flush(Connection *connection)
+{
+    while (!connection->output.empty())
+    {
+        ssize_t written = send(connection->fd, connection->output.data(), connection->output.size(), MSG_NOSIGNAL);
+        if (written > 0)
+        {
+            connection->output.erase(0, written);
+            continue;
+        }
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        close(connection);
+        return false;
+    }
+    size_t frame = Protocol::frameSize(connection->input);
+    bool requestWaiting = frame && connection->input.size() >= frame;
+    if (connection->peerClosed && connection->output.empty() && !requestWaiting)
+    {
+        close(connection);
+        return false;
+    }
+    // Read only while the client keeps up with its responses, and ask for
+    // EPOLLOUT only while a response is still pending
+    epoll_event event = {};
+    if (!connection->peerClosed && connection->output.size() < OUTPUT_HIGH_WATER)
+        event.events |= EPOLLIN;
+    if (!connection->output.empty())
+        event.events |= EPOLLOUT;
+    event.data.fd = connection->fd;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, connection->fd, &event);
+    return true;
+}
+
+void Server::close(Connection *connection)
+{
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, connection->fd, nullptr);
+    ::close(connection->fd);
+    connections.erase(connection->fd);
+    delete connection->fileSystem;
+    delete connection;
+}
+
+void Server::run()
+{
+    epoll_event events[256];
+    while (!stopping)
+    {
+        int ready = epoll_wait(epollFd, events, 256, 100);
+        for (int i = 0; i < ready; i++)
+        {
+            int fd = events[i].data.fd;
+            bool isListener = false;
+            for (int listener : listeners)
+                isListener = isListener || listener == fd;
+            if (isListener)
+            {
+                acceptClients(fd);
+                continue;
+            }
+            auto it = connections.find(fd);
+            if (it == connections.end())
+                continue;
+            Connection *connection = it->second;
+            if (events[i].events & (EPOLLERR | EPOLLHUP))
+                close(connection);
+            else if (events[i].events & EPOLLIN)
+                readFrom(connection);
+            else if (events[i].events & EPOLLOUT)
+            {
+                // Requests held back while the output was full run once it drains
+                if (flush(connection) && connection->output.size() < OUTPUT_HIGH_WATER && !connection->input.empty())
+                    serve(connection);
+            }
+        }
+        // Group commit: everything this wakeup journaled goes out together
+        store.submitWrites();
+    }
+}
+
+void Server::stop() { stopping = true; }
+
+Server::~Server()
+{
+    while (!connections.empty())
+        close(connections.begin()->second);
+    for (int listener : listeners)
+        ::close(listener);
+    if (!unixPath.empty())
+        unlink(unixPath.c_str());
+    ::close(epollFd);
+}
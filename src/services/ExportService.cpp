@@ -0,0 +1,332 @@
+// src/services/ExportService.cpp
+
+#include "../../include/services/ExportService.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// Most files waiting for a writer thread before the traversal pauses
+static const size_t MAX_QUEUED = 4096;
+// Tar output is collected into writes of this size; larger contents are
+// written directly
+static const size_t TAR_BUFFER = 1 << 20;
+static const size_t TAR_BLOCK = 512;
+
+static bool writeFully(int fd, const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = write(fd, data, size);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return false;
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+static bool isSafeName(const string &name)
+{
+    return !name.empty() && name != "." && name != ".." && name.find('/') == string::npos && name.find('\0') == string::npos;
+}
+
+// Pre-order walk below folderId; paths are relative to it and start with '/'.
+// The caller holds a ReadGuard.
+static void walk(Storage &store, const string &folderId, const string &path, ExportStats &stats,
+                 const function<void(const string &)> &onFolder, const function<void(const string &, File *)> &onFile)
+{
+    for (const string &id : store.getFileIdsInFolder(folderId))
+    {
+        File *file = store.getFile(id);
+        if (!file)
+            continue;
+        string name = file->getFileName();
+        if (!isSafeName(name))
+        {
+            stats.skipped++;
+            continue;
+        }
+        onFile(path + "/" + name, file);
+    }
+    for (const string &id : store.getFolderIdsInFolder(folderId))
+    {
+        Folder *folder = store.getFolder(id);
+        if (!folder)
+            continue;
+        string name = folder->getName();
+        if (!isSafeName(name))
+        {
+            stats.skipped++;
+            continue;
+        }
+        onFolder(path + "/" + name);
+        walk(store, id, path + "/" + name, stats, onFolder, onFile);
+    }
+}
+
+// Files waiting to be written, shared with the writer threads
+struct WriterPool
+{
+    deque<pair<string, File *>> jobs;
+    bool done = false;
+    mutex lock;
+    condition_variable hasWork;
+    condition_variable hasRoom;
+    ExportStats totals;
+};
+
+static void writeFiles(WriterPool &pool)
+{
+    ExportStats local;
+    unique_lock<mutex> held(pool.lock);
+    while (true)
+    {
+        pool.hasWork.wait(held, [&pool]
+                          { return pool.done || !pool.jobs.empty(); });
+        if (pool.jobs.empty())
+            break;
+        pair<string, File *> job = move(pool.jobs.front());
+        pool.jobs.pop_front();
+        held.unlock();
+        pool.hasRoom.notify_one();
+
+        BlobContent content = job.second->getContent();
+        int fd = open(job.first.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW, 0644);
+        if (fd >= 0 && writeFully(fd, content->data(), content->size()))
+        {
+            local.files++;
+            local.bytes += content->size();
+        }
+        else
+            local.errors++;
+        if (fd >= 0)
+            close(fd);
+        held.lock();
+    }
+    pool.totals.files += local.files;
+    pool.totals.bytes += local.bytes;
+    pool.totals.errors += local.errors;
+}
+
+ExportStats ExportService::exportToDirectory(const string &folderId, const string &hostPath, int threads)
+{
+    ExportStats stats;
+    if (mkdir(hostPath.c_str(), 0755) != 0 && errno != EEXIST)
+    {
+        out << "     " << "Cannot create " << hostPath << endl;
+        stats.errors++;
+        return stats;
+    }
+    WriterPool pool;
+    if (threads <= 0)
+        threads = clamp<int>(thread::hardware_concurrency() * 2, 4, 32);
+    vector<thread> writers;
+    for (int i = 0; i < threads; i++)
+        writers.emplace_back(writeFiles, ref(pool));
+
+    walk(
+        store, folderId, "", stats,
+        [&](const string &path)
+        {
+            if (mkdir((hostPath + path).c_str(), 0755) == 0 || errno == EEXIST)
+                stats.folders++;
+            else
+                stats.errors++;
+        },
+        [&](const string &path, File *file)
+        {
+            unique_lock<mutex> held(pool.lock);
+            pool.hasRoom.wait(held, [&pool]
+                              { return pool.jobs.size() < MAX_QUEUED; });
+            pool.jobs.emplace_back(hostPath + path, file);
+            held.unlock();
+            pool.hasWork.notify_one();
+        });
+
+    {
+        lock_guard<mutex> held(pool.lock);
+        pool.done = true;
+    }
+    pool.hasWork.notify_all();
+    for (thread &writer : writers)
+        writer.join();
+    stats.files = pool.totals.files;
+    stats.bytes = pool.totals.bytes;
+    stats.errors += pool.totals.errors;
+    return stats;
+}
+
+// Streams a ustar archive through one buffer; contents at least as large as
+// the buffer bypass it
+class TarWriter
+{
+private:
+    int fd;
+    string buffer;
+    long mtime;
+
+    void octal(char *field, size_t width, uint64_t value)
+    {
+        snprintf(field, width, "%0*llo", int(width - 1), (unsigned long long)value);
+    }
+
+    void header(const string &name, const string &prefix, char type, uint64_t size)
+    {
+        char block[TAR_BLOCK];
+        memset(block, 0, sizeof(block));
+        memcpy(block, name.data(), min<size_t>(name.size(), 100));
+        octal(block + 100, 8, type == '5' ? 0755 : 0644);
+        octal(block + 108, 8, 0);
+        octal(block + 116, 8, 0);
+        octal(block + 124, 12, size);
+        octal(block + 136, 12, mtime);
+        memset(block + 148, ' ', 8);
+        block[156] = type;
+        memcpy(block + 257, "ustar", 6);
+        memcpy(block + 263, "00", 2);
+        memcpy(block + 345, prefix.data(), min<size_t>(prefix.size(), 155));
+        unsigned sum = 0;
+        for (unsigned char byte : block)
+            sum += byte;
+        snprintf(block + 148, 8, "%06o", sum);
+        append(block, sizeof(block));
+    }
+
+    void pad(uint64_t size)
+    {
+        static const char zeros[TAR_BLOCK] = {};
+        if (size % TAR_BLOCK)
+            append(zeros, TAR_BLOCK - size % TAR_BLOCK);
+    }
+
+public:
+    bool failed;
+
+    explicit TarWriter(int fd) : fd(fd), mtime(time(nullptr)), failed(false)
+    {
+        buffer.reserve(TAR_BUFFER);
+    }
+
+    void append(const char *data, size_t size)
+    {
+        if (buffer.size() + size > TAR_BUFFER)
+            flush();
+        if (size >= TAR_BUFFER)
+            failed = failed || !writeFully(fd, data, size);
+        else
+            buffer.append(data, size);
+    }
+
+    void flush()
+    {
+        failed = failed || !writeFully(fd, buffer.data(), buffer.size());
+        buffer.clear();
+    }
+
+    // path is relative to the archive root; directories end in '/'
+    void entry(const string &path, char type, uint64_t size)
+    {
+        if (path.size() <= 100)
+        {
+            header(path, "", type, size);
+            return;
+        }
+        for (size_t split = path.find('/'); split != string::npos; split = path.find('/', split + 1))
+            if (split <= 155 && path.size() - split - 1 <= 100 && split + 1 < path.size())
+            {
+                header(path.substr(split + 1), path.substr(0, split), type, size);
+                return;
+            }
+        // Too long for ustar: a GNU long-name record carries the full path
+        header("././@LongLink", "", 'L', path.size() + 1);
+        append(path.c_str(), path.size() + 1);
+        pad(path.size() + 1);
+        header(path.substr(0, 100), "", type, size);
+    }
+
+    void file(const string &path, const string &content)
+    {
+        entry(path, '0', content.size());
+        append(content.data(), content.size());
+        pad(content.size());
+    }
+
+    void finish()
+    {
+        static const char zeros[2 * TAR_BLOCK] = {};
+        append(zeros, sizeof(zeros));
+        flush();
+    }
+};
+
+ExportStats ExportService::exportToTar(const string &folderId, const string &hostPath)
+{
+    ExportStats stats;
+    int fd = open(hostPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        out << "     " << "Cannot create " << hostPath << endl;
+        stats.errors++;
+        return stats;
+    }
+    TarWriter tar(fd);
+    walk(
+        store, folderId, "", stats,
+        [&](const string &path)
+        {
+            tar.entry(path.substr(1) + "/", '5', 0);
+            stats.folders++;
+        },
+        [&](const string &path, File *file)
+        {
+            BlobContent content = file->getContent();
+            tar.file(path.substr(1), *content);
+            stats.files++;
+            stats.bytes += content->size();
+        });
+    tar.finish();
+    if (close(fd) != 0 || tar.failed)
+        stats.errors++;
+    return stats;
+}
+
+ExportService::ExportService(Storage &store, Session &session) : store(store), session(session), out(session.getOutput()) {}
+
+ExportStats ExportService::exportTree(const string &hostPath, int threads)
+{
+    Storage::ReadGuard guard(store);
+    string folderId = store.resolveFolder(session, ".");
+    if (folderId.empty())
+    {
+        out << "     " << "No such folder " << session.getCurrentPath() << endl;
+        return ExportStats();
+    }
+
+    auto start = chrono::steady_clock::now();
+    bool tar = hostPath.size() > 4 && hostPath.compare(hostPath.size() - 4, 4, ".tar") == 0;
+    ExportStats stats = tar ? exportToTar(folderId, hostPath) : exportToDirectory(folderId, hostPath, threads);
+
+    double millis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    out << "     " << "Exported " << stats.folders << " folders and " << stats.files << " files ("
+        << stats.bytes << " bytes) to " << hostPath << " in " << (long)millis << " ms" << endl;
+    if (stats.skipped > 0 || stats.errors > 0)
+        out << "     " << stats.skipped << " entries skipped, " << stats.errors << " could not be written" << endl;
+    return stats;
+}
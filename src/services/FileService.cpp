@@ -9,14 +9,21 @@
 #include <stack>
 using namespace std;
 
-void FileService::createFile(string folderId, string fileName) { Storage::getInstance()->addFile(fileName, folderId); }
+void FileService::createFile(string folderId, string fileName) { store.addFile(session, fileName, folderId); }
 
-void FileService::addContent(string fileName, string content) { Storage::getInstance()->addContent(fileName, content); }
+void FileService::addContent(string fileName, string content) { store.addContent(session, fileName, content); }
 
-void FileService::removeFile(string filename) { Storage::getInstance()->removeFile(filename); }
+void FileService::removeFile(string filename) { store.removeFile(session, filename); }
 
-string FileService::showFileContent(string fileId) { return Storage::getInstance()->getFile(fileId)->getContent(); }
+void FileService::removeMatchingFiles(string pattern) { store.removeMatchingFiles(session, pattern); }
 
-void FileService::showFilePath(string fileId) { return Storage::getInstance()->showFilePath(fileId); }
+string FileService::showFileContent(string fileId)
+{
+    Storage::ReadGuard guard(store);
+    File *file = store.getFile(fileId);
+    return file ? *file->getContent() : "";
+}
 
-FileService::FileService() {}
+void FileService::showFilePath(string fileId) { return store.showFilePath(session, fileId); }
+
+FileService::FileService(Storage &store, Session &session) : store(store), session(session) {}
@@ -6,16 +6,20 @@
 #include "../../include/services/FolderService.h"
 #include "../../include/services/HistoryService.h"
 #include "../../include/services/GrepService.h"
+#include "../../include/storage/Trace.h"
+#include "../../include/storage/AllocationStats.h"
 #include <vector>
 #include <string>
 #include <map>
 #include <iostream>
 #include <stack>
+#include <fstream>
 
 using namespace std;
 
 void FileSystemService::createFile(string folderId, string fileName) 
 { 
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::CREATE_FILE);
     fileService->createFile(folderId, fileName); 
     historyService->addEntry("touch " + fileName, "CREATE_FILE", fileName, currentPath());
 }
@@ -24,51 +28,276 @@ string FileSystemService::getCurrentFolder() { return folderService->getCurrentF
 
 void FileSystemService::addContent(string fileId, string content) 
 { 
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::WRITE_FILE);
     fileService->addContent(fileId, content); 
     historyService->addEntry("write " + fileId + " " + content, "WRITE_FILE", fileId, currentPath());
 }
 
 void FileSystemService::removeFile(string fileName) 
 { 
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::REMOVE_FILE);
     fileService->removeFile(fileName); 
     historyService->addEntry("rm " + fileName, "REMOVE_FILE", fileName, currentPath());
 }
 
+bool FileSystemService::checkHostAccess()
+{
+    if (!hostAccess)
+        getOutput() << "     " << "Host files cannot be read or written from this session." << endl;
+    return hostAccess;
+}
+
+void FileSystemService::setHostAccess(bool allowed)
+{
+    hostAccess = allowed;
+}
+
+void FileSystemService::saveSnapshot(string hostPath)
+{
+    if (!checkHostAccess())
+        return;
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::SAVE_SNAPSHOT);
+    store.saveSnapshot(session, hostPath);
+    historyService->addEntry("save " + hostPath, "SAVE_SNAPSHOT", hostPath, currentPath());
+}
+
+void FileSystemService::loadSnapshot(string hostPath)
+{
+    if (!checkHostAccess())
+        return;
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::LOAD_SNAPSHOT);
+    store.restore(session, hostPath);
+    historyService->addEntry("load " + hostPath, "LOAD_SNAPSHOT", hostPath, currentPath());
+}
+
+void FileSystemService::importTree(string hostPath)
+{
+    if (!checkHostAccess())
+        return;
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::IMPORT);
+    importService->importTree(hostPath);
+    historyService->addEntry("import " + hostPath, "IMPORT", hostPath, currentPath());
+}
+
+void FileSystemService::exportTree(string hostPath)
+{
+    if (!checkHostAccess())
+        return;
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::EXPORT);
+    exportService->exportTree(hostPath);
+    historyService->addEntry("export " + hostPath, "EXPORT", hostPath, currentPath());
+}
+
+void FileSystemService::showDiskUsage(string folderPath, bool humanReadable, int maxDepth, const string &arguments)
+{
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::DISK_USAGE);
+    usageService->showDiskUsage(folderPath, humanReadable, maxDepth);
+    historyService->addEntry(arguments.empty() ? "du" : "du " + arguments, "DISK_USAGE", folderPath, currentPath());
+}
+
+void FileSystemService::showFreeSpace(bool humanReadable)
+{
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::FREE_SPACE);
+    usageService->showFreeSpace(humanReadable);
+    historyService->addEntry("df", "FREE_SPACE", "", currentPath());
+}
+
+void FileSystemService::showStats()
+{
+    store.getOperationStats().writeTable(getOutput());
+}
+
+void FileSystemService::dumpStats(string hostPath)
+{
+    if (!hostPath.empty() && !checkHostAccess())
+        return;
+    ostream &out = getOutput();
+    if (hostPath.empty())
+    {
+        store.getOperationStats().writeJson(out);
+        return;
+    }
+    ofstream file(hostPath);
+    store.getOperationStats().writeJson(file);
+    if (!file)
+        out << "     " << "Could not write " << hostPath << endl;
+    else
+        out << "     " << "Stats written to " << hostPath << endl;
+}
+
+void FileSystemService::resetStats()
+{
+    store.getOperationStats().reset();
+    getOutput() << "     " << "Stats cleared." << endl;
+}
+
+void FileSystemService::startTrace()
+{
+    Tracer::start();
+    getOutput() << "     " << "Tracing started." << endl;
+}
+
+void FileSystemService::stopTrace()
+{
+    Tracer::stop();
+    getOutput() << "     " << "Tracing stopped." << endl;
+}
+
+void FileSystemService::dumpTrace(string hostPath)
+{
+    if (!checkHostAccess())
+        return;
+    ostream &out = getOutput();
+    ofstream file(hostPath);
+    size_t spans = Tracer::writeChromeJson(file);
+    if (!file)
+        out << "     " << "Could not write " << hostPath << endl;
+    else
+        out << "     " << spans << " spans written to " << hostPath << endl;
+}
+
+void FileSystemService::startAllocationProfile()
+{
+    AllocationTracker::start();
+    getOutput() << "     " << "Allocation tracking started." << endl;
+}
+
+void FileSystemService::stopAllocationProfile()
+{
+    AllocationTracker::stop();
+    getOutput() << "     " << "Allocation tracking stopped." << endl;
+}
+
+void FileSystemService::showAllocations(size_t topSites)
+{
+    AllocationTracker::writeReport(getOutput(), topSites);
+}
+
+void FileSystemService::resetAllocations()
+{
+    AllocationTracker::reset();
+    getOutput() << "     " << "Allocation counts cleared." << endl;
+}
+
+void FileSystemService::showSlowCommands()
+{
+    store.getSlowCommandLog().write(getOutput());
+}
+
+void FileSystemService::setSlowCommandThreshold(double milliseconds)
+{
+    store.getSlowCommandLog().setThreshold(uint64_t(milliseconds * 1e6));
+    if (milliseconds > 0)
+        getOutput() << "     " << "Logging commands slower than " << milliseconds << " ms." << endl;
+    else
+        getOutput() << "     " << "Slow command log turned off." << endl;
+}
+
+void FileSystemService::setSlowCommandFile(string hostPath)
+{
+    if (!hostPath.empty() && !checkHostAccess())
+        return;
+    ostream &out = getOutput();
+    if (!store.getSlowCommandLog().setFile(hostPath))
+        out << "     " << "Could not open " << hostPath << endl;
+    else if (hostPath.empty())
+        out << "     " << "Slow commands are no longer written to a file." << endl;
+    else
+        out << "     " << "Appending slow commands to " << hostPath << endl;
+}
+
+void FileSystemService::clearSlowCommands()
+{
+    store.getSlowCommandLog().clear();
+    getOutput() << "     " << "Slow command log cleared." << endl;
+}
+
 string FileSystemService::showFileContent(string fileId) { return fileService->showFileContent(fileId); }
 
+void FileSystemService::catFile(string filePath)
+{
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::READ_FILE);
+    ostream &out = getOutput();
+    string fileId = store.resolveFile(session, filePath);
+    if (fileId.empty())
+    {
+        out << "     File not found: " << filePath << endl;
+        return;
+    }
+    string content = fileService->showFileContent(fileId);
+    size_t start = 0;
+    while (start < content.size())
+    {
+        size_t end = content.find('\n', start);
+        if (end == string::npos)
+            end = content.size();
+        out << "     " << content.substr(start, end - start) << endl;
+        start = end + 1;
+    }
+    historyService->addEntry("cat " + filePath, "READ_FILE", filePath, currentPath());
+}
+
+string FileSystemService::resolveFolder(string folderPath) { return store.resolveFolder(session, folderPath); }
+
 void FileSystemService::createFolder(string parentFolderId, string folderName) 
 { 
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::CREATE_FOLDER);
     folderService->createFolder(parentFolderId, folderName); 
     historyService->addEntry("mkdir " + folderName, "CREATE_FOLDER", folderName, currentPath());
 }
 
 void FileSystemService::removeFolder(string folderName) 
 { 
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::REMOVE_FOLDER);
     folderService->removeFolder(folderName); 
     historyService->addEntry("rmdir " + folderName, "REMOVE_FOLDER", folderName, currentPath());
 }
 
 void FileSystemService::showTree(string folderId) 
 { 
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::SHOW_TREE);
     folderService->showTree(folderService->getCurrentFolder()); 
     historyService->addEntry("tree", "SHOW_TREE", "", currentPath());
 }
 
 void FileSystemService::listAllItems(string folderId) 
 { 
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::LIST_ITEMS);
     folderService->listAllItems(folderId); 
     historyService->addEntry("ls", "LIST_ITEMS", "", currentPath());
 }
 
+void FileSystemService::listMatchingItems(string pattern)
+{
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::LIST_ITEMS);
+    folderService->listMatchingItems(pattern);
+    historyService->addEntry("ls " + pattern, "LIST_ITEMS", pattern, currentPath());
+}
+
+void FileSystemService::removeMatchingFiles(string pattern)
+{
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::REMOVE_FILE);
+    fileService->removeMatchingFiles(pattern);
+    historyService->addEntry("rm " + pattern, "REMOVE_FILE", pattern, currentPath());
+}
+
+void FileSystemService::removeMatchingFolders(string pattern)
+{
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::REMOVE_FOLDER);
+    folderService->removeMatchingFolders(pattern);
+    historyService->addEntry("rmdir " + pattern, "REMOVE_FOLDER", pattern, currentPath());
+}
+
 void FileSystemService::getIntoFolder(string folderName) 
 { 
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::CHANGE_DIR);
     folderService->getIntoFolder(folderName); 
     historyService->addEntry("cd " + folderName, "CHANGE_DIR", folderName, currentPath());
 }
 
-bool FileSystemService::isFolderAvailable(string name) { return Storage::getInstance()->validateFolder(name); }
+bool FileSystemService::isFolderAvailable(string name) { return store.validateFolder(session, name); }
 
-string FileSystemService::currentPath() { return Storage::getInstance()->getPath(folderService->getCurrentFolder()); }
+string FileSystemService::currentPath() { return store.currentPath(session); }
 
 // History operations
 void FileSystemService::showHistory() const
@@ -94,53 +323,110 @@ int FileSystemService::getHistoryCount() const
 // Grep operations
 void FileSystemService::grepPattern(const string& pattern)
 {
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::GREP);
     grepService->grep(pattern);
     historyService->addEntry("grep " + pattern, "GREP", pattern, currentPath());
 }
 
 void FileSystemService::grepInFile(const string& pattern, const string& fileName)
 {
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::GREP_FILE);
     grepService->grepInFile(pattern, fileName);
     historyService->addEntry("grep " + pattern + " " + fileName, "GREP_FILE", fileName, currentPath());
 }
 
 void FileSystemService::grepRecursive(const string& pattern)
 {
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::GREP_RECURSIVE);
     GrepOptions options;
     options.recursive = true;
     grepService->grep(pattern, options);
     historyService->addEntry("grep -r " + pattern, "GREP_RECURSIVE", pattern, currentPath());
 }
 
-void FileSystemService::grepWithOptions(const string& pattern, const string& options)
+void FileSystemService::grepWithOptions(const string& pattern, const GrepOptions& options, const string& flags)
 {
-    GrepOptions grepOpts;
-    
-    // Parse options
-    for (char c : options) {
-        switch (c) {
-            case 'i': grepOpts.caseInsensitive = true; break;
-            case 'r': grepOpts.recursive = true; break;
-            case 'c': grepOpts.countOnly = true; break;
-            case 'v': grepOpts.invertMatch = true; break;
-            case 'n': grepOpts.showLineNumbers = true; break;
-        }
-    }
-    
-    grepService->grep(pattern, grepOpts);
-    historyService->addEntry("grep -" + options + " " + pattern, "GREP_OPTIONS", pattern, currentPath());
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::GREP_OPTIONS);
+    grepService->grep(pattern, options);
+    historyService->addEntry("grep " + (flags.empty() ? "" : "-" + flags + " ") + pattern, "GREP_OPTIONS", pattern, currentPath());
 }
 
 void FileSystemService::showGrepHelp()
 {
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::GREP_HELP);
     grepService->showGrepHelp();
     historyService->addEntry("grep --help", "GREP_HELP", "", currentPath());
 }
 
-FileSystemService::FileSystemService()
+void FileSystemService::findItems(string folderPath, const FindOptions &options, const string &arguments)
+{
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::FIND);
+    findService->find(folderPath, options);
+    historyService->addEntry(arguments.empty() ? "find" : "find " + arguments, "FIND", folderPath, currentPath());
+}
+
+void FileSystemService::locate(string query)
+{
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::LOCATE);
+    store.locate(session, query);
+    historyService->addEntry("locate " + query, "LOCATE", query, currentPath());
+}
+
+void FileSystemService::moveItem(string source, string destination)
+{
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::MOVE);
+    store.moveItem(session, source, destination);
+    historyService->addEntry("mv " + source + " " + destination, "MOVE", source, currentPath());
+}
+
+void FileSystemService::copyItem(string source, string destination, bool recursive)
+{
+    OperationStats::Timer timer(store.getOperationStats(), OperationStats::COPY);
+    store.copyItem(session, source, destination, recursive);
+    historyService->addEntry(string(recursive ? "cp -r " : "cp ") + source + " " + destination, "COPY", source, currentPath());
+}
+
+Storage &FileSystemService::getStorage() { return store; }
+
+Session &FileSystemService::getSession() { return session; }
+
+ostream &FileSystemService::getOutput() { return session.getOutput(); }
+
+FileSystemService::FileSystemService(ostream &out)
+    : ownedStore(new Storage()), store(*ownedStore), session(store.openSession(out)), hostAccess(true)
+{
+    folderService = new FolderService(store, session);
+    fileService = new FileService(store, session);
+    historyService = new HistoryService(out);
+    grepService = new GrepService(store, session);
+    findService = new FindService(store, session);
+    importService = new ImportService(store, session);
+    exportService = new ExportService(store, session);
+    usageService = new UsageService(store, session);
+}
+
+FileSystemService::FileSystemService(Storage &sharedStore, ostream &out)
+    : ownedStore(nullptr), store(sharedStore), session(store.openSession(out)), hostAccess(true)
+{
+    folderService = new FolderService(store, session);
+    fileService = new FileService(store, session);
+    historyService = new HistoryService(out);
+    grepService = new GrepService(store, session);
+    findService = new FindService(store, session);
+    importService = new ImportService(store, session);
+    exportService = new ExportService(store, session);
+    usageService = new UsageService(store, session);
+}
+
+FileSystemService::~FileSystemService()
 {
-    folderService = new FolderService();
-    fileService = new FileService();
-    historyService = new HistoryService();
-    grepService = new GrepService();
+    delete folderService;
+    delete fileService;
+    delete historyService;
+    delete grepService;
+    delete findService;
+    delete importService;
+    delete exportService;
+    delete usageService;
+    delete ownedStore;
 }
\ No newline at end of file
@@ -0,0 +1,179 @@
+// src/services/FindService.cpp
+
+#include "../../include/services/FindService.h"
+#include "../../include/storage/Trace.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+using namespace std;
+
+// Matches are written out once a folder's buffer grows past this
+static const size_t OUTPUT_CHUNK = 64 * 1024;
+
+struct FindTask
+{
+    string folderId;
+    string path;
+    int depth;
+};
+
+// Traversal state shared by the worker threads
+struct FindRun
+{
+    Storage &store;
+    const FindOptions &options;
+    GlobPattern name;
+    ostream &out;
+    deque<FindTask> pending;
+    size_t busy = 0;
+    mutex lock;
+    condition_variable changed;
+    mutex outputLock;
+    size_t matches = 0;
+    uint64_t nodes = 0;
+
+    FindRun(Storage &store, const FindOptions &options, ostream &out)
+        : store(store), options(options), name(options.namePattern), out(out) {}
+};
+
+static void writeMatches(FindRun &run, string &buffer)
+{
+    if (buffer.empty())
+        return;
+    lock_guard<mutex> held(run.outputLock);
+    run.out << buffer << flush;
+    buffer.clear();
+}
+
+static bool matchesFile(const FindRun &run, File *file)
+{
+    const FindOptions &options = run.options;
+    if (!options.extension.empty() && !NameIndex::extensionMatches(file->getExtension(), options.extension))
+        return false;
+    if (options.hasSize)
+    {
+        const Blob *blob = file->getBlob();
+        uint64_t size = blob ? blob->size : 0;
+        if (options.sizeCompare < 0 ? size >= options.sizeBytes
+                                    : options.sizeCompare > 0 ? size <= options.sizeBytes : size != options.sizeBytes)
+            return false;
+    }
+    return true;
+}
+
+// Checks the children of one folder and returns its subfolders to search
+static void searchFolder(FindRun &run, const FindTask &task, vector<FindTask> &next, string &buffer,
+                         size_t &matches, uint64_t &nodes)
+{
+    TraceSpan span("find", "searchFolder");
+    const FindOptions &options = run.options;
+    Storage::ReadGuard guard(run.store);
+    const ChildList *children = run.store.getChildren(task.folderId);
+    if (!children)
+        return;
+    nodes += children->byName.size();
+    bool descend = options.maxDepth < 0 || task.depth + 1 < options.maxDepth;
+    bool anyName = options.namePattern.empty();
+    // Extension and size only hold for files
+    bool folders = options.type != 'f' && options.extension.empty() && !options.hasSize;
+    bool files = options.type != 'd';
+    string prefix = task.path.back() == '/' ? task.path : task.path + "/";
+    for (const ChildList::Named &child : children->byName)
+    {
+        bool isFolder = child.id[0] == 'F';
+        if (isFolder ? !folders && !descend : !files)
+            continue;
+        bool named = anyName || run.name.matches(child.name);
+        // A concurrent remove may already have cleared an entry we still see
+        if (isFolder)
+        {
+            if (!run.store.getFolder(child.id))
+                continue;
+            if (descend)
+                next.push_back({child.id, prefix + child.name, task.depth + 1});
+            if (!folders || !named)
+                continue;
+        }
+        else
+        {
+            if (!named)
+                continue;
+            File *file = run.store.getFile(child.id);
+            if (!file || !matchesFile(run, file))
+                continue;
+        }
+        matches++;
+        buffer += "     ";
+        buffer += prefix;
+        buffer += child.name;
+        buffer += '\n';
+        if (buffer.size() >= OUTPUT_CHUNK)
+            writeMatches(run, buffer);
+    }
+}
+
+static void work(FindRun &run)
+{
+    size_t matches = 0;
+    uint64_t nodes = 0;
+    vector<FindTask> next;
+    string buffer;
+    unique_lock<mutex> held(run.lock);
+    while (true)
+    {
+        run.changed.wait(held, [&run]
+                         { return !run.pending.empty() || run.busy == 0; });
+        if (run.pending.empty())
+            break;
+        FindTask task = move(run.pending.front());
+        run.pending.pop_front();
+        run.busy++;
+        held.unlock();
+        searchFolder(run, task, next, buffer, matches, nodes);
+        writeMatches(run, buffer);
+        held.lock();
+        for (FindTask &folder : next)
+            run.pending.push_back(move(folder));
+        next.clear();
+        run.busy--;
+        run.changed.notify_all();
+    }
+    run.matches += matches;
+    run.nodes += nodes;
+}
+
+FindService::FindService(Storage &store, Session &session) : store(store), session(session), out(session.getOutput()) {}
+
+size_t FindService::find(const string &folderPath, const FindOptions &options, int threads)
+{
+    string folderId = store.resolveFolder(session, folderPath.empty() ? "." : folderPath);
+    if (folderId.empty())
+    {
+        out << "     " << "Folder does not exist." << endl;
+        return 0;
+    }
+    FindRun run(store, options, out);
+    run.pending.push_back({folderId, folderPath.empty() ? "." : folderPath, 0});
+    if (options.maxDepth != 0)
+    {
+        // The calling thread is one of the workers
+        if (threads <= 0)
+            threads = clamp<int>(thread::hardware_concurrency(), 1, 16);
+        vector<thread> workers;
+        for (int i = 1; i < threads; i++)
+            workers.emplace_back(work, ref(run));
+        work(run);
+        for (thread &worker : workers)
+            worker.join();
+    }
+    // Node counts are per thread, so the workers' are added here
+    SlowCommandLog::touch(run.nodes);
+    if (run.matches == 0)
+        out << "     " << "No matches found." << endl;
+    return run.matches;
+}
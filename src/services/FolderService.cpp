@@ -9,18 +9,23 @@
 #include <stack>
 using namespace std;
 
-void FolderService::createFolder(string parentFolderId, string folderName) { Storage::getInstance()->addFolder(folderName, parentFolderId); }
+void FolderService::createFolder(string parentFolderId, string folderName) { store.addFolder(session, folderName, parentFolderId); }
 
-void FolderService::removeFolder(string folderName) { Storage::getInstance()->removeFolder(folderName); }
+void FolderService::removeFolder(string folderName) { store.removeFolder(session, folderName); }
 
-void FolderService::showTree(string folderId) { Storage::getInstance()->showFolderTree(); }
+void FolderService::removeMatchingFolders(string pattern) { store.removeMatchingFolders(session, pattern); }
 
-void FolderService::listAllItems(string folderId) { Storage::getInstance()->showItemsInFolder(folderId); }
+void FolderService::showTree(string folderId) { store.showFolderTree(session); }
 
-void FolderService::showFolderPath(string folderId) { Storage::getInstance()->showFolderPath(folderId); }
+void FolderService::listAllItems(string folderId) { store.showItemsInFolder(session, folderId); }
 
-string FolderService::getCurrentFolder() { return Storage::getInstance()->getCurrentFolderId(); }
+void FolderService::listMatchingItems(string pattern) { store.showMatchingItems(session, pattern); }
 
-FolderService::FolderService() {}
+void FolderService::showFolderPath(string folderId) { store.showFolderPath(session, folderId); }
 
-void FolderService::getIntoFolder(string folderName) { Storage::getInstance()->getIntoFolder(folderName); }
\ No newline at end of file
+// Falls back to the root, like path resolution, if another session removed it
+string FolderService::getCurrentFolder() { return store.resolveFolder(session, "."); }
+
+FolderService::FolderService(Storage &store, Session &session) : store(store), session(session) {}
+
+void FolderService::getIntoFolder(string folderName) { store.getIntoFolder(session, folderName); }
\ No newline at end of file
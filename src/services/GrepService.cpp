@@ -2,6 +2,7 @@
 
 #include "../../include/services/GrepService.h"
 #include "../../include/storage/Storage.h"
+#include "../../include/storage/Trace.h"
 #include <vector>
 #include <string>
 #include <map>
@@ -13,8 +14,7 @@
 
 using namespace std;
 
-GrepService::GrepService() {
-    store = Storage::getInstance();
+GrepService::GrepService(Storage &store, Session &session) : store(store), session(session), out(session.getOutput()) {
 }
 
 vector<string> GrepService::splitLines(const string& content) {
@@ -58,19 +58,21 @@ bool GrepService::matchesPattern(const string& line, const string& pattern, bool
 }
 
 void GrepService::searchInFile(const string& fileId, const string& pattern, const GrepOptions& options, vector<GrepResult>& results) {
-    File* file = store->getFile(fileId);
+    TraceSpan span("grep", "searchInFile");
+    File* file = store.getFile(fileId);
     if (!file) return;
+    SlowCommandLog::touch(1);
     
-    string content = file->getContent();
-    if (content.empty()) return;
+    BlobContent content = file->getContent();
+    if (content->empty()) return;
     
-    vector<string> lines = splitLines(content);
+    vector<string> lines = splitLines(*content);
     
     for (size_t i = 0; i < lines.size(); i++) {
         if (matchesPattern(lines[i], pattern, options.caseInsensitive, options.invertMatch)) {
             GrepResult result;
             result.fileName = file->getFileName();
-            result.filePath = store->getPath(file->getFolderId()) + "/" + file->getFileName();
+            result.filePath = store.getPath(file->getFolderId()) + "/" + file->getFileName();
             result.lineNumber = i + 1;
             result.matchedLine = lines[i];
             result.fileId = fileId;
@@ -80,8 +82,10 @@ void GrepService::searchInFile(const string& fileId, const string& pattern, cons
 }
 
 void GrepService::searchInFolder(const string& folderId, const string& pattern, const GrepOptions& options, vector<GrepResult>& results) {
+    TraceSpan span("grep", "searchInFolder");
+    SlowCommandLog::touch(1);
     // Get all files in the current folder
-    vector<string> fileIds = store->getFileIdsInFolder(folderId);
+    vector<string> fileIds = store.getFileIdsInFolder(folderId);
     
     // Search in each file
     for (const string& fileId : fileIds) {
@@ -90,7 +94,7 @@ void GrepService::searchInFolder(const string& folderId, const string& pattern,
     
     // If recursive search is enabled, search in subfolders
     if (options.recursive) {
-        vector<string> folderIds = store->getFolderIdsInFolder(folderId);
+        vector<string> folderIds = store.getFolderIdsInFolder(folderId);
         for (const string& subFolderId : folderIds) {
             searchInFolder(subFolderId, pattern, options, results);
         }
@@ -98,29 +102,30 @@ void GrepService::searchInFolder(const string& folderId, const string& pattern,
 }
 
 void GrepService::displayResults(const vector<GrepResult>& results, const GrepOptions& options) {
+    TraceSpan span("grep", "displayResults");
     if (results.empty()) {
-        cout << "     No matches found." << endl;
+        out << "     No matches found." << endl;
         return;
     }
     
     if (options.countOnly) {
-        cout << "     Total matches: " << results.size() << endl;
+        out << "     Total matches: " << results.size() << endl;
         return;
     }
     
     string currentFile = "";
     for (const auto& result : results) {
         if (options.showFilePath && result.fileName != currentFile) {
-            if (!currentFile.empty()) cout << endl;
-            cout << "     === " << result.filePath << " ===" << endl;
+            if (!currentFile.empty()) out << endl;
+            out << "     === " << result.filePath << " ===" << endl;
             currentFile = result.fileName;
         }
         
-        cout << "     ";
+        out << "     ";
         if (options.showLineNumbers) {
-            cout << result.lineNumber << ": ";
+            out << result.lineNumber << ": ";
         }
-        cout << result.matchedLine << endl;
+        out << result.matchedLine << endl;
     }
 }
 
@@ -133,9 +138,12 @@ void GrepService::grep(const string& pattern, const GrepOptions& options) {
         return;
     }
     
-    // Search in current directory
-    string currentFolderId = store->getCurrentFolderId();
-    cout << "     Searching for pattern: \"" << pattern << "\" in current directory..." << endl;
+    // Search in current directory. No lock is taken: the ReadGuard keeps
+    // every File reached during the traversal alive while lines are matched
+    Storage::ReadGuard guard(store);
+    // Resolved like every other command, so a removed cwd falls back to root
+    string currentFolderId = store.resolveFolder(session, ".");
+    out << "     Searching for pattern: \"" << pattern << "\" in current directory..." << endl;
     
     searchInFolder(currentFolderId, pattern, options, results);
     displayResults(results, options);
@@ -144,16 +152,16 @@ void GrepService::grep(const string& pattern, const GrepOptions& options) {
 void GrepService::grepInFile(const string& pattern, const string& fileName, const GrepOptions& options) {
     vector<GrepResult> results;
     
-    // Find the file in current directory
-    string currentFolderId = store->getCurrentFolderId();
-    string fileId = store->getFileIdByName(fileName, currentFolderId);
+    // Resolve the file relative to the current directory
+    Storage::ReadGuard guard(store);
+    string fileId = store.resolveFile(session, fileName);
     
     if (!fileId.empty()) {
-        cout << "     Searching for pattern: \"" << pattern << "\" in file: " << fileName << endl;
+        out << "     Searching for pattern: \"" << pattern << "\" in file: " << fileName << endl;
         searchInFile(fileId, pattern, options, results);
         displayResults(results, options);
     } else {
-        cout << "     File not found: " << fileName << endl;
+        out << "     File not found: " << fileName << endl;
     }
 }
 
@@ -164,17 +172,17 @@ void GrepService::grepRecursive(const string& pattern, const GrepOptions& option
 }
 
 void GrepService::showGrepHelp() {
-    cout << "     GREP - Search for patterns in files" << endl;
-    cout << "     Usage:" << endl;
-    cout << "       grep <pattern>                    - Search pattern in current directory" << endl;
-    cout << "       grep <pattern> <filename>         - Search pattern in specific file" << endl;
-    cout << "       grep -i <pattern>                 - Case-insensitive search" << endl;
-    cout << "       grep -r <pattern>                 - Recursive search in subdirectories" << endl;
-    cout << "       grep -c <pattern>                 - Count matches only" << endl;
-    cout << "       grep -v <pattern>                 - Invert match (show non-matching lines)" << endl;
-    cout << "       grep -n <pattern>                 - Show line numbers (default)" << endl;
-    cout << "       grep --help                       - Show this help" << endl;
-    cout << endl;
-    cout << "     Options can be combined: grep -ir <pattern>" << endl;
-    cout << "     Pattern supports basic regex syntax" << endl;
+    out << "     GREP - Search for patterns in files" << endl;
+    out << "     Usage:" << endl;
+    out << "       grep <pattern>                    - Search pattern in current directory" << endl;
+    out << "       grep <pattern> <filename>         - Search pattern in specific file" << endl;
+    out << "       grep -i <pattern>                 - Case-insensitive search" << endl;
+    out << "       grep -r <pattern>                 - Recursive search in subdirectories" << endl;
+    out << "       grep -c <pattern>                 - Count matches only" << endl;
+    out << "       grep -v <pattern>                 - Invert match (show non-matching lines)" << endl;
+    out << "       grep -n <pattern>                 - Show line numbers (default)" << endl;
+    out << "       grep --help                       - Show this help" << endl;
+    out << endl;
+    out << "     Options can be combined: grep -ir <pattern>" << endl;
+    out << "     Pattern supports basic regex syntax" << endl;
 }
@@ -1,19 +1,21 @@
 // src/services/HistoryService.cpp
 
 #include "../../include/services/HistoryService.h"
+#include "../../include/storage/SlowCommandLog.h"
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
 
 using namespace std;
 
-HistoryService::HistoryService()
+HistoryService::HistoryService(ostream &out) : nextId(1), out(out)
 {
 }
 
 void HistoryService::addEntry(string command, string operationType, string target, string currentPath)
 {
-    History* newEntry = new History(command, operationType, target, currentPath);
+    SlowCommandLog::PhaseTimer recording(SlowCommandLog::HISTORY);
+    History* newEntry = new History(nextId++, command, operationType, target, currentPath);
     historyEntries.push_back(newEntry);
     
     // Maintain maximum history size
@@ -28,59 +30,59 @@ void HistoryService::showHistory() const
 {
     if (historyEntries.empty())
     {
-        cout << "No history available." << endl;
+        out << "No history available." << endl;
         return;
     }
     
-    cout << endl;
-    cout << "Command History:" << endl;
-    cout << "----------------" << endl;
-    cout << setw(4) << right << "ID" << "  ";
-    cout << setw(19) << left << "Timestamp" << "  ";
-    cout << setw(12) << left << "Operation" << "  ";
-    cout << setw(20) << left << "Target" << "  ";
-    cout << setw(15) << left << "Path" << "  ";
-    cout << "Command" << endl;
-    cout << string(90, '-') << endl;
+    out << endl;
+    out << "Command History:" << endl;
+    out << "----------------" << endl;
+    out << setw(4) << right << "ID" << "  ";
+    out << setw(19) << left << "Timestamp" << "  ";
+    out << setw(12) << left << "Operation" << "  ";
+    out << setw(20) << left << "Target" << "  ";
+    out << setw(15) << left << "Path" << "  ";
+    out << "Command" << endl;
+    out << string(90, '-') << endl;
     
     for (const auto& entry : historyEntries)
     {
-        cout << entry->getFormattedEntry() << endl;
+        out << entry->getFormattedEntry() << endl;
     }
-    cout << endl;
+    out << endl;
 }
 
 void HistoryService::showHistory(int count) const
 {
     if (historyEntries.empty())
     {
-        cout << "No history available." << endl;
+        out << "No history available." << endl;
         return;
     }
     
     if (count <= 0)
     {
-        cout << "Invalid count. Please specify a positive number." << endl;
+        out << "Invalid count. Please specify a positive number." << endl;
         return;
     }
     
-    cout << endl;
-    cout << "Recent Command History (last " << count << " commands):" << endl;
-    cout << "--------------------------------------------------------" << endl;
-    cout << setw(4) << right << "ID" << "  ";
-    cout << setw(19) << left << "Timestamp" << "  ";
-    cout << setw(12) << left << "Operation" << "  ";
-    cout << setw(20) << left << "Target" << "  ";
-    cout << setw(15) << left << "Path" << "  ";
-    cout << "Command" << endl;
-    cout << string(90, '-') << endl;
+    out << endl;
+    out << "Recent Command History (last " << count << " commands):" << endl;
+    out << "--------------------------------------------------------" << endl;
+    out << setw(4) << right << "ID" << "  ";
+    out << setw(19) << left << "Timestamp" << "  ";
+    out << setw(12) << left << "Operation" << "  ";
+    out << setw(20) << left << "Target" << "  ";
+    out << setw(15) << left << "Path" << "  ";
+    out << "Command" << endl;
+    out << string(90, '-') << endl;
     
     int start = max(0, static_cast<int>(historyEntries.size()) - count);
     for (int i = start; i < static_cast<int>(historyEntries.size()); i++)
     {
-        cout << historyEntries[i]->getFormattedEntry() << endl;
+        out << historyEntries[i]->getFormattedEntry() << endl;
     }
-    cout << endl;
+    out << endl;
 }
 
 void HistoryService::clearHistory()
@@ -90,7 +92,7 @@ void HistoryService::clearHistory()
         delete entry;
     }
     historyEntries.clear();
-    cout << "History cleared successfully." << endl;
+    out << "History cleared successfully." << endl;
 }
 
 int HistoryService::getHistoryCount() const
@@ -0,0 +1,251 @@
+// src/services/ImportService.cpp
+
+#include "../../include/services/ImportService.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// Files at least this large are mapped instead of read
+static const size_t MMAP_THRESHOLD = 256 * 1024;
+// A directory's files are inserted in pieces once this many are buffered
+static const size_t BATCH_FILES = 4096;
+static const size_t BATCH_BYTES = 64 * 1024 * 1024;
+
+// Traversal state shared by the worker threads
+struct ImportRun
+{
+    Storage &store;
+    deque<pair<string, string>> pending; // host directory, folder id
+    size_t busy = 0;
+    mutex lock;
+    condition_variable changed;
+    ImportStats totals;
+
+    explicit ImportRun(Storage &store) : store(store) {}
+};
+
+static bool readHostFile(int dirFd, const char *name, string &content)
+{
+    int fd = openat(dirFd, name, O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+    {
+        close(fd);
+        return false;
+    }
+    size_t size = info.st_size;
+    if (size >= MMAP_THRESHOLD)
+    {
+        void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED)
+        {
+            madvise(mapped, size, MADV_SEQUENTIAL);
+            content.assign(static_cast<const char *>(mapped), size);
+            munmap(mapped, size);
+            close(fd);
+            return true;
+        }
+    }
+    content.resize(size);
+    size_t filled = 0;
+    while (filled < size)
+    {
+        ssize_t got = read(fd, &content[filled], size - filled);
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got <= 0)
+            break;
+        filled += got;
+    }
+    content.resize(filled);
+    close(fd);
+    return true;
+}
+
+static void insertFiles(ImportRun &run, const string &folderId, vector<pair<string, string>> &files, ImportStats &local)
+{
+    size_t skipped;
+    run.store.insertBatch(folderId, {}, files, skipped);
+    local.files += files.size() - skipped;
+    local.skipped += skipped;
+    files.clear();
+}
+
+static void importDirectory(ImportRun &run, const string &hostPath, const string &folderId,
+                            ImportStats &local, vector<pair<string, string>> &next)
+{
+    DIR *dir = opendir(hostPath.c_str());
+    if (!dir)
+    {
+        local.errors++;
+        return;
+    }
+    int dirFd = dirfd(dir);
+    vector<string> folderNames;
+    vector<pair<string, string>> files;
+    size_t batchBytes = 0;
+    while (dirent *entry = readdir(dir))
+    {
+        const char *name = entry->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+            continue;
+        unsigned char type = entry->d_type;
+        if (type == DT_UNKNOWN)
+        {
+            struct stat info;
+            if (fstatat(dirFd, name, &info, AT_SYMLINK_NOFOLLOW) != 0)
+                continue;
+            type = S_ISDIR(info.st_mode) ? DT_DIR : S_ISREG(info.st_mode) ? DT_REG : DT_UNKNOWN;
+        }
+        if (type == DT_DIR)
+            folderNames.push_back(name);
+        else if (type == DT_REG)
+        {
+            string content;
+            if (!readHostFile(dirFd, name, content))
+            {
+                local.errors++;
+                continue;
+            }
+            local.bytes += content.size();
+            batchBytes += content.size();
+            files.emplace_back(name, move(content));
+            if (files.size() >= BATCH_FILES || batchBytes >= BATCH_BYTES)
+            {
+                insertFiles(run, folderId, files, local);
+                batchBytes = 0;
+            }
+        }
+        else
+            local.skipped++;
+    }
+    closedir(dir);
+
+    size_t skipped;
+    vector<string> ids = run.store.insertBatch(folderId, folderNames, files, skipped);
+    local.files += files.size() - skipped;
+    local.skipped += skipped;
+    local.folders += folderNames.size();
+    for (size_t i = 0; i < folderNames.size(); i++)
+        if (!ids[i].empty())
+            next.emplace_back(hostPath + "/" + folderNames[i], ids[i]);
+}
+
+static void work(ImportRun &run)
+{
+    ImportStats local;
+    vector<pair<string, string>> next;
+    unique_lock<mutex> held(run.lock);
+    while (true)
+    {
+        run.changed.wait(held, [&run]
+                         { return !run.pending.empty() || run.busy == 0; });
+        if (run.pending.empty())
+            break;
+        pair<string, string> task = move(run.pending.front());
+        run.pending.pop_front();
+        run.busy++;
+        held.unlock();
+        importDirectory(run, task.first, task.second, local, next);
+        held.lock();
+        for (auto &directory : next)
+            run.pending.push_back(move(directory));
+        next.clear();
+        run.busy--;
+        run.changed.notify_all();
+    }
+    run.totals.folders += local.folders;
+    run.totals.files += local.files;
+    run.totals.bytes += local.bytes;
+    run.totals.skipped += local.skipped;
+    run.totals.errors += local.errors;
+}
+
+ImportService::ImportService(Storage &store, Session &session) : store(store), session(session), out(session.getOutput()) {}
+
+ImportStats ImportService::importTree(const string &hostPath, int threads)
+{
+    ImportRun run(store);
+    char resolved[PATH_MAX];
+    struct stat info;
+    if (!realpath(hostPath.c_str(), resolved) || lstat(resolved, &info) != 0)
+    {
+        out << "     " << "Cannot read " << hostPath << endl;
+        return run.totals;
+    }
+    string path = resolved;
+    string name = path.substr(path.rfind('/') + 1);
+    if (name.empty())
+    {
+        out << "     " << "Cannot import the host root directory" << endl;
+        return run.totals;
+    }
+
+    auto start = chrono::steady_clock::now();
+    // Resolved like every other command, so a removed cwd falls back to root
+    string folderId = store.resolveFolder(session, ".");
+    if (S_ISREG(info.st_mode))
+    {
+        int parentFd = open(path.substr(0, path.rfind('/') + 1).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        vector<pair<string, string>> files(1);
+        files[0].first = name;
+        if (parentFd >= 0 && readHostFile(parentFd, name.c_str(), files[0].second))
+        {
+            run.totals.bytes = files[0].second.size();
+            insertFiles(run, folderId, files, run.totals);
+        }
+        else
+            run.totals.errors++;
+        if (parentFd >= 0)
+            close(parentFd);
+    }
+    else if (S_ISDIR(info.st_mode))
+    {
+        vector<pair<string, string>> none;
+        size_t skipped;
+        string rootId = store.insertBatch(folderId, {name}, none, skipped)[0];
+        if (rootId.empty())
+        {
+            out << "     " << "No such folder " << session.getCurrentPath() << endl;
+            return run.totals;
+        }
+        run.totals.folders = 1;
+        run.pending.emplace_back(path, rootId);
+        if (threads <= 0)
+            threads = clamp<int>(thread::hardware_concurrency() * 2, 4, 32);
+        vector<thread> workers;
+        for (int i = 0; i < threads; i++)
+            workers.emplace_back(work, ref(run));
+        for (thread &worker : workers)
+            worker.join();
+    }
+    else
+    {
+        out << "     " << hostPath << " is not a regular file or directory" << endl;
+        return run.totals;
+    }
+
+    double millis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    out << "     " << "Imported " << run.totals.folders << " folders and " << run.totals.files << " files ("
+        << run.totals.bytes << " bytes) from " << path << " in " << (long)millis << " ms" << endl;
+    if (run.totals.skipped > 0 || run.totals.errors > 0)
+        out << "     " << run.totals.skipped << " entries skipped, " << run.totals.errors << " could not be read" << endl;
+    return run.totals;
+}
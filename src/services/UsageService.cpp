@@ -0,0 +1,78 @@
+// src/services/UsageService.cpp
+
+#include "../../include/services/UsageService.h"
+#include <string>
+#include <cstdio>
+#include <iomanip>
+
+using namespace std;
+
+UsageService::UsageService(Storage &store, Session &session) : store(store), session(session), out(session.getOutput()) {}
+
+string UsageService::formatSize(uint64_t bytes, bool humanReadable)
+{
+    if (!humanReadable || bytes < 1024)
+        return to_string(bytes);
+    // Rounded up like du -h: one decimal below 10, whole units above
+    const char *units = "KMGTPE";
+    double value = bytes / 1024.0;
+    int unit = 0;
+    while (value >= 1024 && unit < 5)
+    {
+        value /= 1024;
+        unit++;
+    }
+    char text[32];
+    if (value < 10)
+        snprintf(text, sizeof(text), "%.1f%c", (uint64_t)(value * 10 + 0.999) / 10.0, units[unit]);
+    else
+        snprintf(text, sizeof(text), "%llu%c", (unsigned long long)(value + 0.999), units[unit]);
+    return text;
+}
+
+void UsageService::showFolder(const string &folderId, const string &path, int depth, int maxDepth, bool humanReadable)
+{
+    if (maxDepth < 0 || depth < maxDepth)
+    {
+        for (const string &childId : store.getFolderIdsInFolder(folderId))
+        {
+            Folder *child = store.getFolder(childId);
+            if (child)
+                showFolder(childId, (path == "/" ? path : path + "/") + child->getName(), depth + 1, maxDepth, humanReadable);
+        }
+    }
+    SlowCommandLog::touch(1);
+    // A folder removed by another session while we listed it is skipped
+    UsageTotals totals;
+    if (!store.getUsage(folderId, totals))
+        return;
+    out << "     " << setw(10) << formatSize(totals.bytes, humanReadable) << setw(10)
+        << 1 + totals.files + totals.folders << "  " << path << endl;
+}
+
+void UsageService::showDiskUsage(const string &folderPath, bool humanReadable, int maxDepth)
+{
+    string folderId = store.resolveFolder(session, folderPath.empty() ? "." : folderPath);
+    if (folderId.empty())
+    {
+        out << "     " << "Folder does not exist." << endl;
+        return;
+    }
+    // Pointers from getFolder stay valid for the whole listing
+    Storage::ReadGuard guard(store);
+    out << "     " << setw(10) << "Size" << setw(10) << "Nodes" << "  Path" << endl;
+    showFolder(folderId, folderPath.empty() ? "." : folderPath, 0, maxDepth, humanReadable);
+}
+
+void UsageService::showFreeSpace(bool humanReadable)
+{
+    UsageTotals totals;
+    store.getUsage(store.getRootFolderId(), totals);
+    BlobStats blobs = store.getBlobStore().getStats();
+    size_t resident = blobs.hotBytes + blobs.packedBytes + blobs.cachedBytes;
+    out << "     " << setw(10) << "Folders" << setw(10) << "Files" << setw(10) << "Content"
+        << setw(10) << "Stored" << setw(10) << "Resident" << setw(10) << "Blobs" << endl;
+    out << "     " << setw(10) << 1 + totals.folders << setw(10) << totals.files
+        << setw(10) << formatSize(totals.bytes, humanReadable) << setw(10) << formatSize(blobs.storedBytes, humanReadable)
+        << setw(10) << formatSize(resident, humanReadable) << setw(10) << blobs.blobs << endl;
+}
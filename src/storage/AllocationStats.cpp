@@ -0,0 +1,384 @@
+// src/storage/AllocationStats.cpp
+
+#include "../../include/storage/AllocationStats.h"
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <map>
+#include <sstream>
+#include <algorithm>
+#include <iomanip>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+
+using namespace std;
+
+namespace
+{
+    struct TagStats
+    {
+        atomic<const char *> name{nullptr};
+        atomic<uint64_t> calls{0};
+        atomic<uint64_t> allocations{0};
+        atomic<uint64_t> bytes{0};
+        atomic<uint64_t> frees{0};
+    };
+
+    // A slot is claimed by a CAS on its key (a hash of the frames); the
+    // frames are published afterwards through ready
+    struct SiteStats
+    {
+        atomic<uint64_t> key{0};
+        atomic<bool> ready{false};
+        atomic<uintptr_t> frames[AllocationTracker::SITE_FRAMES];
+        atomic<uint64_t> allocations{0};
+        atomic<uint64_t> bytes{0};
+    };
+
+    // Static storage only: nothing here may allocate while operator new runs.
+    // Tag 0 is for allocations outside every scope
+    TagStats tags[AllocationTracker::MAX_TAGS];
+    SiteStats sites[AllocationTracker::MAX_SITES];
+    atomic<uint64_t> unplacedSites{0};
+
+    thread_local int currentTag = 0;
+    // Set while the thread is inside the tracker, so allocations made by
+    // backtrace() or by the report are not counted
+    thread_local bool busy = false;
+
+    // Frames skipped: recordAllocation and operator new
+    const int SKIPPED_FRAMES = 2;
+
+    void resetSite(SiteStats &site)
+    {
+        site.ready.store(false, memory_order_relaxed);
+        site.key.store(0, memory_order_relaxed);
+        site.allocations.store(0, memory_order_relaxed);
+        site.bytes.store(0, memory_order_relaxed);
+    }
+
+    SiteStats *findSite(void **frames, int count)
+    {
+        // FNV-1a over the addresses; 0 marks an empty slot
+        uint64_t key = 1469598103934665603ull;
+        for (int i = 0; i < count; i++)
+            key = (key ^ uintptr_t(frames[i])) * 1099511628211ull;
+        key |= 1;
+        for (int probe = 0; probe < 16; probe++)
+        {
+            SiteStats &site = sites[(key + probe) % AllocationTracker::MAX_SITES];
+            uint64_t seen = site.key.load(memory_order_acquire);
+            if (seen == key)
+                return &site;
+            if (seen == 0 && site.key.compare_exchange_strong(seen, key, memory_order_acq_rel))
+            {
+                for (int i = 0; i < AllocationTracker::SITE_FRAMES; i++)
+                    site.frames[i].store(i < count ? uintptr_t(frames[i]) : 0, memory_order_relaxed);
+                site.ready.store(true, memory_order_release);
+                return &site;
+            }
+            // Another thread may have just claimed the slot for this site
+            if (seen == key)
+                return &site;
+        }
+        return nullptr;
+    }
+
+    // "Class::method" for a return address, or "file+0x1a2b" when the
+    // symbol is not exported (build with -rdynamic to name everything)
+    string describe(uintptr_t address, bool &library)
+    {
+        Dl_info info;
+        // The return address may be the first byte of the next function
+        if (!dladdr(reinterpret_cast<void *>(address - 1), &info) || !info.dli_fname)
+            return "?";
+        library = strstr(info.dli_fname, "libstdc++") || strstr(info.dli_fname, "libc.so");
+        if (!info.dli_sname)
+        {
+            const char *file = strrchr(info.dli_fname, '/');
+            ostringstream name;
+            name << (file ? file + 1 : info.dli_fname) << "+0x" << hex << address - uintptr_t(info.dli_fbase);
+            return name.str();
+        }
+        int status = 0;
+        char *demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        string name = status == 0 && demangled ? demangled : info.dli_sname;
+        free(demangled);
+        // Drop the parameter list, which is usually longer than the name
+        int depth = 0;
+        for (size_t i = 0; i < name.size(); i++)
+        {
+            if (name[i] == '<')
+                depth++;
+            else if (name[i] == '>')
+                depth--;
+            else if (name[i] == '(' && depth == 0 && i > 0)
+            {
+                name.resize(i);
+                break;
+            }
+        }
+        return name;
+    }
+
+    struct SiteRow
+    {
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+    };
+}
+
+atomic<bool> AllocationTracker::enabled{false};
+
+void AllocationTracker::start()
+{
+    // The first backtrace() loads the unwinder, which allocates
+    busy = true;
+    void *frames[SITE_FRAMES];
+    backtrace(frames, SITE_FRAMES);
+    busy = false;
+    reset();
+    enabled.store(true, memory_order_relaxed);
+}
+
+void AllocationTracker::stop()
+{
+    enabled.store(false, memory_order_relaxed);
+}
+
+void AllocationTracker::reset()
+{
+    for (TagStats &tag : tags)
+    {
+        tag.calls.store(0, memory_order_relaxed);
+        tag.allocations.store(0, memory_order_relaxed);
+        tag.bytes.store(0, memory_order_relaxed);
+        tag.frees.store(0, memory_order_relaxed);
+    }
+    for (SiteStats &site : sites)
+        resetSite(site);
+    unplacedSites.store(0, memory_order_relaxed);
+}
+
+__attribute__((noinline)) void AllocationTracker::recordAllocation(size_t bytes)
+{
+    if (busy)
+        return;
+    busy = true;
+    TagStats &tag = tags[currentTag];
+    tag.allocations.fetch_add(1, memory_order_relaxed);
+    tag.bytes.fetch_add(bytes, memory_order_relaxed);
+    void *frames[SKIPPED_FRAMES + SITE_FRAMES];
+    int count = backtrace(frames, SKIPPED_FRAMES + SITE_FRAMES) - SKIPPED_FRAMES;
+    SiteStats *site = count > 0 ? findSite(frames + SKIPPED_FRAMES, count) : nullptr;
+    if (site)
+    {
+        site->allocations.fetch_add(1, memory_order_relaxed);
+        site->bytes.fetch_add(bytes, memory_order_relaxed);
+    }
+    else
+        unplacedSites.fetch_add(1, memory_order_relaxed);
+    busy = false;
+}
+
+void AllocationTracker::recordFree()
+{
+    if (!busy)
+        tags[currentTag].frees.fetch_add(1, memory_order_relaxed);
+}
+
+int AllocationTracker::enter(const char *name)
+{
+    int previous = currentTag;
+    int found = 0;
+    for (int i = 1; i < MAX_TAGS && !found; i++)
+    {
+        const char *seen = tags[i].name.load(memory_order_acquire);
+        if (!seen && tags[i].name.compare_exchange_strong(seen, name, memory_order_acq_rel))
+            seen = name;
+        // Names are compared by content, since equal literals in different
+        // translation units need not share an address
+        if (seen == name || strcmp(seen, name) == 0)
+            found = i;
+    }
+    tags[found].calls.fetch_add(1, memory_order_relaxed);
+    currentTag = found;
+    return previous;
+}
+
+void AllocationTracker::leave(int previous)
+{
+    currentTag = previous;
+}
+
+void AllocationTracker::writeReport(ostream &out, size_t topSites)
+{
+    bool wasBusy = busy;
+    busy = true;
+    out << "     " << left << setw(20) << "Scope" << right << setw(10) << "Calls" << setw(12) << "Allocs"
+        << setw(14) << "Bytes" << setw(12) << "Frees" << setw(13) << "Allocs/call" << setw(13) << "Bytes/call" << endl;
+    out << fixed << setprecision(1);
+    uint64_t totalAllocations = 0;
+    for (int i = 0; i < MAX_TAGS; i++)
+    {
+        const TagStats &tag = tags[i];
+        const char *name = i == 0 ? "(outside scopes)" : tag.name.load(memory_order_acquire);
+        uint64_t calls = tag.calls.load(memory_order_relaxed);
+        uint64_t allocations = tag.allocations.load(memory_order_relaxed);
+        uint64_t bytes = tag.bytes.load(memory_order_relaxed);
+        uint64_t frees = tag.frees.load(memory_order_relaxed);
+        if (!name || (!calls && !allocations && !frees))
+            continue;
+        totalAllocations += allocations;
+        out << "     " << left << setw(20) << name << right << setw(10) << calls << setw(12) << allocations
+            << setw(14) << bytes << setw(12) << frees;
+        if (calls)
+            out << setw(13) << double(allocations) / calls << setw(13) << double(bytes) / calls;
+        out << endl;
+    }
+    out << defaultfloat << setprecision(6);
+    if (!totalAllocations)
+    {
+        out << "     No allocations recorded." << endl;
+        busy = wasBusy;
+        return;
+    }
+
+    // Stacks that differ only inside the standard library print the same,
+    // so they are merged by their printed form
+    map<string, SiteRow> rows;
+    for (const SiteStats &site : sites)
+    {
+        if (!site.ready.load(memory_order_acquire))
+            continue;
+        string printed;
+        int shown = 0;
+        for (int i = 0; i < SITE_FRAMES && shown < 3; i++)
+        {
+            uintptr_t address = site.frames[i].load(memory_order_relaxed);
+            if (!address)
+                break;
+            bool library = false;
+            string name = describe(address, library);
+            // Sanitizer runtimes can add a frame, leaving operator new in view
+            if (library || name.compare(0, 12, "operator new") == 0)
+                continue;
+            printed += (shown ? " <- " : "") + name;
+            shown++;
+        }
+        SiteRow &row = rows[printed.empty() ? "(standard library only)" : printed];
+        row.allocations += site.allocations.load(memory_order_relaxed);
+        row.bytes += site.bytes.load(memory_order_relaxed);
+    }
+    vector<pair<string, SiteRow>> sorted(rows.begin(), rows.end());
+    sort(sorted.begin(), sorted.end(), [](const pair<string, SiteRow> &a, const pair<string, SiteRow> &b)
+         { return a.second.allocations > b.second.allocations; });
+    out << endl
+        << "     Top call sites" << endl;
+    out << "     " << setw(12) << "Allocs" << setw(14) << "Bytes" << "  Site" << endl;
+    for (size_t i = 0; i < sorted.size() && i < topSites; i++)
+        out << "     " << setw(12) << sorted[i].second.allocations << setw(14) << sorted[i].second.bytes
+            << "  " << sorted[i].first << endl;
+    if (uint64_t unplaced = unplacedSites.load(memory_order_relaxed))
+        out << "     " << unplaced << " allocations from sites beyond the first " << MAX_SITES << " are not listed." << endl;
+    busy = wasBusy;
+}
+
+// Replacements for the global allocation functions. They use malloc and
+// free like the default ones, and report to the tracker only while it runs.
+
+static void *allocate(size_t size)
+{
+    void *pointer;
+    while (!(pointer = malloc(size ? size : 1)))
+    {
+        new_handler handler = get_new_handler();
+        if (!handler)
+            throw bad_alloc();
+        handler();
+    }
+    return pointer;
+}
+
+static void *allocateAligned(size_t size, align_val_t alignment)
+{
+    void *pointer = nullptr;
+    size_t align = max(size_t(alignment), sizeof(void *));
+    while (posix_memalign(&pointer, align, size ? size : 1) != 0)
+    {
+        new_handler handler = get_new_handler();
+        if (!handler)
+            throw bad_alloc();
+        handler();
+    }
+    return pointer;
+}
+
+static void release(void *pointer)
+{
+    if (pointer && AllocationTracker::isEnabled())
+        AllocationTracker::recordFree();
+    free(pointer);
+}
+
+__attribute__((noinline)) void *operator new(size_t size)
+{
+    void *pointer = allocate(size);
+    if (AllocationTracker::isEnabled())
+        AllocationTracker::recordAllocation(size);
+    return pointer;
+}
+
+__attribute__((noinline)) void *operator new[](size_t size)
+{
+    void *pointer = allocate(size);
+    if (AllocationTracker::isEnabled())
+        AllocationTracker::recordAllocation(size);
+    return pointer;
+}
+
+__attribute__((noinline)) void *operator new(size_t size, const nothrow_t &) noexcept
+{
+    void *pointer = malloc(size ? size : 1);
+    if (pointer && AllocationTracker::isEnabled())
+        AllocationTracker::recordAllocation(size);
+    return pointer;
+}
+
+__attribute__((noinline)) void *operator new[](size_t size, const nothrow_t &) noexcept
+{
+    void *pointer = malloc(size ? size : 1);
+    if (pointer && AllocationTracker::isEnabled())
+        AllocationTracker::recordAllocation(size);
+    return pointer;
+}
+
+__attribute__((noinline)) void *operator new(size_t size, align_val_t alignment)
+{
+    void *pointer = allocateAligned(size, alignment);
+    if (AllocationTracker::isEnabled())
+        AllocationTracker::recordAllocation(size);
+    return pointer;
+}
+
+__attribute__((noinline)) void *operator new[](size_t size, align_val_t alignment)
+{
+    void *pointer = allocateAligned(size, alignment);
+    if (AllocationTracker::isEnabled())
+        AllocationTracker::recordAllocation(size);
+    return pointer;
+}
+
+void operator delete(void *pointer) noexcept { release(pointer); }
+void operator delete[](void *pointer) noexcept { release(pointer); }
+void operator delete(void *pointer, size_t) noexcept { release(pointer); }
+void operator delete[](void *pointer, size_t) noexcept { release(pointer); }
+void operator delete(void *pointer, const nothrow_t &) noexcept { release(pointer); }
+void operator delete[](void *pointer, const nothrow_t &) noexcept { release(pointer); }
+void operator delete(void *pointer, align_val_t) noexcept { release(pointer); }
+void operator delete[](void *pointer, align_val_t) noexcept { release(pointer); }
+void operator delete(void *pointer, size_t, align_val_t) noexcept { release(pointer); }
+void operator delete[](void *pointer, size_t, align_val_t) noexcept { release(pointer); }
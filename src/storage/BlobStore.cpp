@@ -0,0 +1,320 @@
+// src/storage/BlobStore.cpp
+
+#include "../../include/storage/BlobStore.h"
+#include <cstring>
+#include <algorithm>
+#include "../../include/storage/LzCodec.h"
+
+using namespace std;
+
+static const uint64_t PRIME1 = 11400714785074694791ULL;
+static const uint64_t PRIME2 = 14029467366897019727ULL;
+static const uint64_t PRIME3 = 1609587929392839161ULL;
+static const uint64_t PRIME4 = 9650029242287828579ULL;
+static const uint64_t PRIME5 = 2870177450012600261ULL;
+
+static uint64_t rotl(uint64_t value, int bits) { return (value << bits) | (value >> (64 - bits)); }
+
+static uint64_t read64(const char *p)
+{
+    uint64_t value;
+    memcpy(&value, p, 8);
+    return value;
+}
+
+static uint32_t read32(const char *p)
+{
+    uint32_t value;
+    memcpy(&value, p, 4);
+    return value;
+}
+
+static uint64_t round64(uint64_t acc, uint64_t input)
+{
+    acc += input * PRIME2;
+    return rotl(acc, 31) * PRIME1;
+}
+
+static uint64_t merge64(uint64_t acc, uint64_t value)
+{
+    acc ^= round64(0, value);
+    return acc * PRIME1 + PRIME4;
+}
+
+uint64_t BlobStore::hash(string_view data)
+{
+    const char *p = data.data();
+    const char *end = p + data.size();
+    uint64_t h;
+    if (data.size() >= 32)
+    {
+        uint64_t v1 = PRIME1 + PRIME2, v2 = PRIME2, v3 = 0, v4 = 0 - PRIME1;
+        for (; p + 32 <= end; p += 32)
+        {
+            v1 = round64(v1, read64(p));
+            v2 = round64(v2, read64(p + 8));
+            v3 = round64(v3, read64(p + 16));
+            v4 = round64(v4, read64(p + 24));
+        }
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = merge64(h, v1);
+        h = merge64(h, v2);
+        h = merge64(h, v3);
+        h = merge64(h, v4);
+    }
+    else
+        h = PRIME5;
+    h += data.size();
+    for (; p + 8 <= end; p += 8)
+        h = rotl(h ^ round64(0, read64(p)), 27) * PRIME1 + PRIME4;
+    if (p + 4 <= end)
+    {
+        h = rotl(h ^ (uint64_t(read32(p)) * PRIME1), 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+    for (; p < end; p++)
+        h = rotl(h ^ (uint64_t(uint8_t(*p)) * PRIME5), 11) * PRIME1;
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+// Decompressed copies kept for reads of cold blobs, by default
+static const size_t DEFAULT_CACHE_BYTES = 64 << 20;
+
+BlobStore::BlobStore() : cacheLimit(DEFAULT_CACHE_BYTES), tick(1), hasRetiring(false) {}
+
+bool BlobStore::sameContent(const Blob *blob, const string &data) const
+{
+    if (blob->size != data.size())
+        return false;
+    // Under the lock neither the plain string nor the packed form can be
+    // queued for retirement, so both are safe to read here
+    if (const string *plain = blob->plain.load(memory_order_acquire))
+        return *plain == data;
+    string decoded;
+    return LzCodec::decompress(*blob->packed, blob->size, decoded) && decoded == data;
+}
+
+const Blob *BlobStore::intern(string data)
+{
+    if (data.empty())
+        return nullptr;
+    uint64_t digest = hash(data);
+    lock_guard<mutex> held(lock);
+    vector<Blob *> &bucket = buckets[digest];
+    for (Blob *blob : bucket)
+        if (sameContent(blob, data))
+        {
+            blob->refs++;
+            blob->lastUse.store(tick.load(memory_order_relaxed), memory_order_relaxed);
+            stats.logicalBytes += blob->size;
+            return blob;
+        }
+    Blob *blob = new Blob();
+    blob->hash = digest;
+    blob->size = data.size();
+    blob->refs = 1;
+    blob->store = this;
+    blob->plain.store(new string(move(data)), memory_order_release);
+    blob->packed = nullptr;
+    blob->lastUse.store(tick.load(memory_order_relaxed), memory_order_relaxed);
+    blob->incompressible = false;
+    blob->cachedAt = 0;
+    blob->cached = false;
+    bucket.push_back(blob);
+    stats.blobs++;
+    stats.storedBytes += blob->size;
+    stats.logicalBytes += blob->size;
+    stats.hotBytes += blob->size;
+    return blob;
+}
+
+const Blob *BlobStore::retain(const Blob *blob)
+{
+    if (!blob)
+        return nullptr;
+    lock_guard<mutex> held(lock);
+    const_cast<Blob *>(blob)->refs++;
+    stats.logicalBytes += blob->size;
+    return blob;
+}
+
+void BlobStore::freeLocked(Blob *blob)
+{
+    // No File refers to the blob any more, so no reader can hold its strings
+    auto found = buckets.find(blob->hash);
+    vector<Blob *> &bucket = found->second;
+    bucket.erase(find(bucket.begin(), bucket.end(), blob));
+    if (bucket.empty())
+        buckets.erase(found);
+    if (blob->cached)
+    {
+        cache.erase(blob->cacheEntry);
+        stats.cachedBytes -= blob->size;
+    }
+    if (blob->packed)
+    {
+        stats.coldBlobs--;
+        stats.packedBytes -= blob->packed->size();
+    }
+    else
+        stats.hotBytes -= blob->size;
+    stats.blobs--;
+    stats.storedBytes -= blob->size;
+    delete blob->plain.load();
+    delete blob->packed;
+    delete blob;
+}
+
+void BlobStore::release(const Blob *blob)
+{
+    if (!blob)
+        return;
+    lock_guard<mutex> held(lock);
+    Blob *owned = const_cast<Blob *>(blob);
+    stats.logicalBytes -= owned->size;
+    if (--owned->refs == 0)
+        freeLocked(owned);
+}
+
+BlobContent BlobStore::read(const Blob *blob)
+{
+    Blob *owned = const_cast<Blob *>(blob);
+    uint64_t now = tick.load(memory_order_relaxed);
+    if (owned->lastUse.load(memory_order_relaxed) != now)
+        owned->lastUse.store(now, memory_order_relaxed);
+    if (const string *plain = owned->plain.load(memory_order_acquire))
+        return BlobContent(plain);
+
+    // Cold: share the cached copy, or decompress outside the lock and cache
+    // the result unless another reader got there first
+    {
+        lock_guard<mutex> held(lock);
+        if (owned->copy)
+            return BlobContent(owned->copy.get(), owned->copy);
+    }
+    auto decoded = make_shared<string>();
+    LzCodec::decompress(*owned->packed, owned->size, *decoded);
+    lock_guard<mutex> held(lock);
+    if (owned->copy)
+        return BlobContent(owned->copy.get(), owned->copy);
+    owned->copy = decoded;
+    owned->cached = true;
+    owned->cachedAt = now;
+    owned->cacheEntry = cache.insert(cache.end(), owned);
+    stats.cachedBytes += owned->size;
+    evictLocked();
+    return BlobContent(decoded.get(), decoded);
+}
+
+void BlobStore::evictLocked()
+{
+    // Oldest first; a copy read since it was cached goes to the back once
+    while (stats.cachedBytes > cacheLimit && !cache.empty())
+    {
+        Blob *victim = cache.front();
+        cache.pop_front();
+        uint64_t lastUse = victim->lastUse.load(memory_order_relaxed);
+        if (lastUse > victim->cachedAt)
+        {
+            victim->cachedAt = lastUse;
+            victim->cacheEntry = cache.insert(cache.end(), victim);
+            continue;
+        }
+        // Readers still holding the copy keep it alive until they are done
+        victim->cached = false;
+        victim->copy.reset();
+        stats.cachedBytes -= victim->size;
+    }
+}
+
+size_t BlobStore::compactCold(size_t minBytes, uint64_t idlePasses)
+{
+    lock_guard<mutex> single(compacting);
+    vector<Blob *> candidates;
+    {
+        lock_guard<mutex> held(lock);
+        uint64_t now = tick.fetch_add(1, memory_order_relaxed);
+        for (auto &bucket : buckets)
+            for (Blob *blob : bucket.second)
+                if (!blob->packed && !blob->incompressible && blob->size >= minBytes &&
+                    blob->lastUse.load(memory_order_relaxed) + idlePasses <= now)
+                {
+                    blob->refs++;
+                    candidates.push_back(blob);
+                }
+    }
+
+    // A hot blob's plain string is only ever replaced here, so it can be
+    // compressed without the lock
+    vector<string *> packedForms(candidates.size(), nullptr);
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        string packed = LzCodec::compress(*candidates[i]->plain.load(memory_order_acquire));
+        if (packed.size() <= candidates[i]->size / 8 * 7)
+            packedForms[i] = new string(move(packed));
+    }
+
+    size_t compacted = 0;
+    lock_guard<mutex> held(lock);
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        Blob *blob = candidates[i];
+        if (packedForms[i])
+        {
+            blob->packed = packedForms[i];
+            retiring.push_back(blob->plain.exchange(nullptr, memory_order_acq_rel));
+            hasRetiring.store(true, memory_order_release);
+            stats.coldBlobs++;
+            stats.hotBytes -= blob->size;
+            stats.packedBytes += blob->packed->size();
+            compacted++;
+        }
+        else
+            blob->incompressible = true;
+        if (--blob->refs == 0)
+            freeLocked(blob);
+    }
+    return compacted;
+}
+
+void BlobStore::setCacheLimit(size_t bytes)
+{
+    lock_guard<mutex> held(lock);
+    cacheLimit = bytes;
+    evictLocked();
+}
+
+void BlobStore::drainRetired(EpochManager &epochs)
+{
+    if (!hasRetiring.load(memory_order_acquire))
+        return;
+    lock_guard<mutex> held(lock);
+    for (const string *plain : retiring)
+        epochs.retire(plain);
+    retiring.clear();
+    hasRetiring.store(false, memory_order_relaxed);
+}
+
+BlobStats BlobStore::getStats() const
+{
+    lock_guard<mutex> held(lock);
+    return stats;
+}
+
+BlobStore::~BlobStore()
+{
+    for (const string *plain : retiring)
+        delete plain;
+    for (auto &bucket : buckets)
+        for (Blob *blob : bucket.second)
+        {
+            delete blob->plain.load();
+            delete blob->packed;
+            delete blob;
+        }
+}
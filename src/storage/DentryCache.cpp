@@ -0,0 +1,31 @@
+// src/storage/DentryCache.cpp
+
+#include "../../include/storage/DentryCache.h"
+#include <string>
+#include <string_view>
+#include <functional>
+
+using namespace std;
+
+DentryCache::DentryCache() : hits(0), misses(0) {}
+
+DentryCache::Entry &DentryCache::slotFor(size_t parent, string_view name)
+{
+    // Allocated on first use so idle sessions stay small
+    if (entries.empty())
+        entries.resize(SLOTS);
+    size_t h = hash<string_view>()(name) ^ (parent * 0x9E3779B97F4A7C15ull);
+    return entries[h & (SLOTS - 1)];
+}
+
+bool DentryCache::matches(const Entry &entry, size_t parent, uint64_t version, string_view name)
+{
+    return entry.parent == parent && entry.version == version && entry.name == name;
+}
+
+void DentryCache::clear()
+{
+    entries.clear();
+    hits = 0;
+    misses = 0;
+}
@@ -0,0 +1,104 @@
+// src/storage/Epoch.cpp
+
+#include "../../include/storage/Epoch.h"
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+// Managers the current thread is inside a Guard for, with their slot
+static thread_local vector<pair<const EpochManager *, int>> activeGuards;
+
+int EpochManager::enter() const
+{
+    // Start probing at a per-thread position so threads rarely share a slot
+    static thread_local size_t hint = hash<thread::id>()(this_thread::get_id());
+    while (true)
+    {
+        for (int i = 0; i < SLOTS; i++)
+        {
+            int index = (hint + i) % SLOTS;
+            uint64_t expected = 0;
+            uint64_t epoch = globalEpoch.load();
+            if (slots[index].epoch.load(memory_order_relaxed) == 0 &&
+                slots[index].epoch.compare_exchange_strong(expected, epoch))
+            {
+                hint = index;
+                return index;
+            }
+        }
+        this_thread::yield();
+    }
+}
+
+void EpochManager::leave(int slot) const
+{
+    slots[slot].epoch.store(0, memory_order_release);
+}
+
+uint64_t EpochManager::oldestActiveEpoch() const
+{
+    uint64_t oldest = UINT64_MAX;
+    for (const Slot &slot : slots)
+    {
+        uint64_t epoch = slot.epoch.load();
+        if (epoch != 0 && epoch < oldest)
+            oldest = epoch;
+    }
+    return oldest;
+}
+
+EpochManager::Guard::Guard(const EpochManager &manager) : manager(nullptr), slot(-1)
+{
+    for (auto &active : activeGuards)
+        if (active.first == &manager)
+            return;
+    slot = manager.enter();
+    this->manager = &manager;
+    activeGuards.push_back({&manager, slot});
+}
+
+EpochManager::Guard::~Guard()
+{
+    if (!manager)
+        return;
+    for (auto it = activeGuards.begin(); it != activeGuards.end(); ++it)
+    {
+        if (it->first == manager)
+        {
+            activeGuards.erase(it);
+            break;
+        }
+    }
+    manager->leave(slot);
+}
+
+void EpochManager::retireRaw(void *object, void (*deleter)(void *))
+{
+    // Readers that entered at or before this epoch may still hold the object
+    retired.push_back({object, deleter, globalEpoch.fetch_add(1)});
+}
+
+void EpochManager::collect()
+{
+    // Scanning every slot is the expensive part, so batch it
+    if (retired.size() >= RECLAIM_THRESHOLD)
+        reclaim(oldestActiveEpoch());
+}
+
+void EpochManager::reclaim(uint64_t oldest)
+{
+    auto keep = partition(retired.begin(), retired.end(), [oldest](const Retired &r)
+                          { return r.epoch >= oldest; });
+    for (auto it = keep; it != retired.end(); ++it)
+        it->deleter(it->object);
+    retired.erase(keep, retired.end());
+}
+
+EpochManager::~EpochManager()
+{
+    reclaim(UINT64_MAX);
+}
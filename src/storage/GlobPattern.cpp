@@ -0,0 +1,171 @@
+// src/storage/GlobPattern.cpp
+
+#include "../../include/storage/GlobPattern.h"
+
+using namespace std;
+
+// Index of the ']' closing the set opened at pattern[open], or npos. A ']'
+// right after the '[' (or after its negation) belongs to the set.
+static size_t setEnd(string_view pattern, size_t open)
+{
+    size_t i = open + 1;
+    if (i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^'))
+        i++;
+    if (i < pattern.size() && pattern[i] == ']')
+        i++;
+    for (; i < pattern.size(); i++)
+    {
+        if (pattern[i] == '\\')
+            i++;
+        else if (pattern[i] == ']')
+            return i;
+    }
+    return string_view::npos;
+}
+
+bool GlobPattern::isGlob(string_view text)
+{
+    for (size_t i = 0; i < text.size(); i++)
+        if (text[i] == '*' || text[i] == '?' || text[i] == '\\' || (text[i] == '[' && setEnd(text, i) != string_view::npos))
+            return true;
+    return false;
+}
+
+GlobPattern::GlobPattern(string_view pattern)
+{
+    auto appendLiteral = [this](char c)
+    {
+        if (tokens.empty() || tokens.back().kind != LITERAL)
+            tokens.push_back({LITERAL, "", 0});
+        tokens.back().literal += c;
+        minLength++;
+    };
+    for (size_t i = 0; i < pattern.size(); i++)
+    {
+        char c = pattern[i];
+        if (c == '\\' && i + 1 < pattern.size())
+            appendLiteral(pattern[++i]);
+        else if (c == '*')
+        {
+            // Consecutive stars match the same as one
+            if (tokens.empty() || tokens.back().kind != STAR)
+                tokens.push_back({STAR, "", 0});
+            hasStar = true;
+        }
+        else if (c == '?')
+        {
+            tokens.push_back({ANY, "", 0});
+            minLength++;
+        }
+        else if (c == '[' && setEnd(pattern, i) != string_view::npos)
+        {
+            size_t end = setEnd(pattern, i);
+            bitset<256> set;
+            size_t j = i + 1;
+            bool negated = pattern[j] == '!' || pattern[j] == '^';
+            if (negated)
+                j++;
+            while (j < end)
+            {
+                unsigned char low = pattern[j] == '\\' && j + 1 < end ? pattern[++j] : pattern[j];
+                j++;
+                unsigned char high = low;
+                // "a-f" is a range; a '-' at either end of the set is literal
+                if (j + 1 < end && pattern[j] == '-')
+                {
+                    high = pattern[j + 1] == '\\' && j + 2 < end ? pattern[j + 2] : pattern[j + 1];
+                    j += pattern[j + 1] == '\\' && j + 2 < end ? 3 : 2;
+                }
+                for (unsigned c = low; c <= high; c++)
+                    set.set(c);
+            }
+            if (negated)
+                set.flip();
+            sets.push_back(set);
+            tokens.push_back({SET, "", sets.size() - 1});
+            minLength++;
+            i = end;
+        }
+        else
+            appendLiteral(c);
+    }
+    if (!tokens.empty() && tokens.front().kind == LITERAL)
+        prefix = tokens.front().literal;
+    if (hasStar && tokens.size() > 1 && tokens.back().kind == LITERAL)
+        suffix = tokens.back().literal;
+}
+
+bool GlobPattern::matchesToken(const Token &token, string_view name, size_t at) const
+{
+    switch (token.kind)
+    {
+    case LITERAL:
+        return name.compare(at, token.literal.size(), token.literal) == 0;
+    case ANY:
+        return at < name.size();
+    case SET:
+        return at < name.size() && sets[token.set].test((unsigned char)name[at]);
+    default:
+        return false;
+    }
+}
+
+bool GlobPattern::matches(string_view name) const
+{
+    if (name.size() < minLength || (!hasStar && name.size() != minLength))
+        return false;
+    if (name.compare(0, prefix.size(), prefix) != 0)
+        return false;
+    if (!suffix.empty() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0)
+        return false;
+
+    // Left to right, remembering the last star: on a mismatch that star
+    // takes one more character and matching resumes after it. When the
+    // star is followed by a literal, the next place it occurs is found
+    // directly instead of one character at a time.
+    size_t t = 0, n = 0;
+    size_t star = string_view::npos, starEnd = 0;
+    auto resume = [&]() -> bool
+    {
+        t = star + 1;
+        n = starEnd;
+        if (t < tokens.size() && tokens[t].kind == LITERAL)
+        {
+            size_t found = name.find(tokens[t].literal, n);
+            if (found == string_view::npos)
+                return false;
+            n = starEnd = found;
+        }
+        return true;
+    };
+    while (true)
+    {
+        if (t < tokens.size())
+        {
+            const Token &token = tokens[t];
+            if (token.kind == STAR)
+            {
+                if (t + 1 == tokens.size())
+                    return true;
+                star = t;
+                starEnd = n;
+                if (!resume())
+                    return false;
+                continue;
+            }
+            if (matchesToken(token, name, n))
+            {
+                n += token.kind == LITERAL ? token.literal.size() : 1;
+                t++;
+                continue;
+            }
+        }
+        else if (n == name.size())
+            return true;
+        if (star == string_view::npos || starEnd >= name.size())
+            return false;
+        starEnd++;
+        if (!resume())
+            return false;
+    }
+}
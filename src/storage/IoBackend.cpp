@@ -0,0 +1,363 @@
+// src/storage/IoBackend.cpp
+
+#include "../../include/storage/IoBackend.h"
+#include <unistd.h>
+#include <cerrno>
+#include <iostream>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <atomic>
+#include <cstring>
+#define HAVE_IO_URING 1
+#endif
+
+using namespace std;
+
+// pwrite() until everything is written; returns false on a hard error
+static bool writeFully(int fd, uint64_t offset, const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = pwrite(fd, data, size, offset);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return false;
+        data += written;
+        size -= written;
+        offset += written;
+    }
+    return true;
+}
+
+IoBackend *IoBackend::create(const string &kind)
+{
+    if (kind == "sync")
+        return new SyncIoBackend();
+    if (kind == "uring")
+    {
+        UringIoBackend *uring = new UringIoBackend();
+        if (uring->isReady())
+            return uring;
+        delete uring;
+    }
+    return new ThreadPoolIoBackend();
+}
+
+string SyncIoBackend::getName() const
+{
+    return "sync";
+}
+
+void SyncIoBackend::write(int fd, uint64_t offset, string data)
+{
+    if (!writeFully(fd, offset, data.data(), data.size()))
+        cerr << "Persistence write failed." << endl;
+}
+
+void SyncIoBackend::flush()
+{
+}
+
+ThreadPoolIoBackend::ThreadPoolIoBackend(int threads) : inFlight(0), stopping(false)
+{
+    for (int i = 0; i < threads; i++)
+        workers.emplace_back(&ThreadPoolIoBackend::work, this);
+}
+
+string ThreadPoolIoBackend::getName() const
+{
+    return "threads";
+}
+
+void ThreadPoolIoBackend::work()
+{
+    unique_lock<mutex> held(lock);
+    while (true)
+    {
+        hasWork.wait(held, [this]
+                     { return stopping || !jobs.empty(); });
+        if (jobs.empty())
+            return;
+        Job job = move(jobs.front());
+        jobs.pop_front();
+        inFlight++;
+        held.unlock();
+        if (!writeFully(job.fd, job.offset, job.data.data(), job.data.size()))
+            cerr << "Persistence write failed." << endl;
+        held.lock();
+        inFlight--;
+        if (jobs.empty() && inFlight == 0)
+            idle.notify_all();
+    }
+}
+
+void ThreadPoolIoBackend::write(int fd, uint64_t offset, string data)
+{
+    {
+        lock_guard<mutex> held(lock);
+        jobs.push_back({fd, offset, move(data)});
+    }
+    hasWork.notify_one();
+}
+
+void ThreadPoolIoBackend::flush()
+{
+    unique_lock<mutex> held(lock);
+    idle.wait(held, [this]
+              { return jobs.empty() && inFlight == 0; });
+}
+
+ThreadPoolIoBackend::~ThreadPoolIoBackend()
+{
+    {
+        lock_guard<mutex> held(lock);
+        stopping = true;
+    }
+    hasWork.notify_all();
+    for (thread &worker : workers)
+        worker.join();
+}
+
+#ifdef HAVE_IO_URING
+
+static unsigned loadAcquire(unsigned *value)
+{
+    return reinterpret_cast<atomic<unsigned> *>(value)->load(memory_order_acquire);
+}
+
+static void storeRelease(unsigned *value, unsigned next)
+{
+    reinterpret_cast<atomic<unsigned> *>(value)->store(next, memory_order_release);
+}
+
+UringIoBackend::UringIoBackend()
+    : ringFd(-1), sqRing(MAP_FAILED), cqRing(MAP_FAILED), sqeMemory(MAP_FAILED),
+      sqRingSize(0), cqRingSize(0), sqeSize(0), queued(0), submitted(0), nextTag(1), failed(false)
+{
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ringFd = syscall(__NR_io_uring_setup, ENTRIES, &params);
+    if (ringFd < 0)
+        return;
+
+    // A ring alone does not prove IORING_OP_WRITE: 5.1-5.5 have rings but
+    // fail every such request with EINVAL, and have no probe either
+    const unsigned probedOps = 256;
+    vector<char> probeMemory(sizeof(io_uring_probe) + probedOps * sizeof(io_uring_probe_op), 0);
+    io_uring_probe *probe = reinterpret_cast<io_uring_probe *>(probeMemory.data());
+    if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PROBE, probe, probedOps) < 0 ||
+        probe->ops_len <= IORING_OP_WRITE || !(probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED))
+    {
+        close(ringFd);
+        ringFd = -1;
+        return;
+    }
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    sqeSize = params.sq_entries * sizeof(io_uring_sqe);
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+    sqeMemory = mmap(nullptr, sqeSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqeMemory == MAP_FAILED)
+    {
+        close(ringFd);
+        ringFd = -1;
+        return;
+    }
+
+    char *sq = static_cast<char *>(sqRing);
+    sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sqMask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    char *cq = static_cast<char *>(cqRing);
+    cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cqMask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes = cq + params.cq_off.cqes;
+}
+
+bool UringIoBackend::isReady() const
+{
+    return ringFd >= 0;
+}
+
+string UringIoBackend::getName() const
+{
+    return "uring";
+}
+
+void UringIoBackend::queue(uint64_t tag)
+{
+    // Never run ahead of the completion queue: every SQE queued or in the
+    // kernel must have room for its CQE
+    if (queued + submitted >= ENTRIES)
+        submit(1);
+    // After a failed submit everything pending was written with pwrite()
+    if (failed)
+        return;
+
+    Pending &write = pending[tag];
+    unsigned tail = *sqTail;
+    unsigned index = tail & *sqMask;
+    io_uring_sqe *sqe = static_cast<io_uring_sqe *>(sqeMemory) + index;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = write.fd;
+    sqe->off = write.offset + write.done;
+    sqe->addr = reinterpret_cast<uint64_t>(write.data.data() + write.done);
+    sqe->len = write.data.size() - write.done;
+    sqe->user_data = tag;
+    sqArray[index] = index;
+    storeRelease(sqTail, tail + 1);
+    queued++;
+}
+
+bool UringIoBackend::submit(unsigned waitFor)
+{
+    if (failed)
+        return false;
+    while (true)
+    {
+        unsigned flags = waitFor > 0 ? IORING_ENTER_GETEVENTS : 0;
+        int result = syscall(__NR_io_uring_enter, ringFd, queued, waitFor, flags, nullptr, 0);
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result < 0)
+        {
+            fail(errno);
+            return false;
+        }
+        queued -= result;
+        submitted += result;
+        break;
+    }
+    reap();
+    return true;
+}
+
+void UringIoBackend::fail(int error)
+{
+    cerr << "Persistence: io_uring_enter failed (" << strerror(error) << "), falling back to pwrite." << endl;
+    failed = true;
+    for (auto &entry : pending)
+    {
+        Pending &write = entry.second;
+        if (!writeFully(write.fd, write.offset + write.done, write.data.data() + write.done, write.data.size() - write.done))
+            cerr << "Persistence write failed." << endl;
+    }
+    // Spliced, not copied: the buffers must stay where the kernel saw them
+    abandoned.merge(pending);
+}
+
+void UringIoBackend::reap()
+{
+    unsigned head = *cqHead;
+    vector<uint64_t> retry;
+    while (head != loadAcquire(cqTail))
+    {
+        io_uring_cqe *cqe = static_cast<io_uring_cqe *>(cqes) + (head & *cqMask);
+        uint64_t tag = cqe->user_data;
+        int result = cqe->res;
+        head++;
+        submitted--;
+
+        auto found = pending.find(tag);
+        if (found == pending.end())
+            continue;
+        Pending &write = found->second;
+        if (result == -EINTR || result == -EAGAIN)
+            retry.push_back(tag);
+        else if (result == -EINVAL || result == -EOPNOTSUPP)
+        {
+            // The kernel does not take this write through the ring
+            if (!writeFully(write.fd, write.offset + write.done, write.data.data() + write.done, write.data.size() - write.done))
+                cerr << "Persistence write failed." << endl;
+            pending.erase(found);
+        }
+        else if (result <= 0)
+        {
+            cerr << "Persistence write failed." << endl;
+            pending.erase(found);
+        }
+        else if (write.done + result < write.data.size())
+        {
+            write.done += result;
+            retry.push_back(tag);
+        }
+        else
+            pending.erase(found);
+    }
+    storeRelease(cqHead, head);
+    for (uint64_t tag : retry)
+        queue(tag);
+}
+
+void UringIoBackend::write(int fd, uint64_t offset, string data)
+{
+    lock_guard<mutex> held(lock);
+    if (failed)
+    {
+        if (!writeFully(fd, offset, data.data(), data.size()))
+            cerr << "Persistence write failed." << endl;
+        return;
+    }
+    uint64_t tag = nextTag++;
+    pending[tag] = {fd, offset, move(data), 0};
+    queue(tag);
+    submit(0);
+}
+
+void UringIoBackend::flush()
+{
+    lock_guard<mutex> held(lock);
+    while (!pending.empty())
+        if (!submit(queued > 0 ? 0 : 1))
+            break;
+}
+
+UringIoBackend::~UringIoBackend()
+{
+    if (ringFd < 0)
+        return;
+    flush();
+    munmap(sqeMemory, sqeSize);
+    munmap(cqRing, cqRingSize);
+    munmap(sqRing, sqRingSize);
+    close(ringFd);
+}
+
+#else
+
+UringIoBackend::UringIoBackend() : ringFd(-1)
+{
+}
+
+bool UringIoBackend::isReady() const
+{
+    return false;
+}
+
+string UringIoBackend::getName() const
+{
+    return "uring";
+}
+
+void UringIoBackend::write(int, uint64_t, string)
+{
+}
+
+void UringIoBackend::flush()
+{
+}
+
+UringIoBackend::~UringIoBackend()
+{
+}
+
+#endif
@@ -0,0 +1,317 @@
+// src/storage/Journal.cpp
+
+#include "../../include/storage/Journal.h"
+#include "../../include/storage/Storage.h"
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// Snapshot records are handed to the backend in chunks of about this size
+static const size_t SNAPSHOT_CHUNK = 1 << 20;
+
+// Reads the whole file behind fd into data
+static void readAll(int fd, string &data)
+{
+    struct stat info;
+    if (fstat(fd, &info) == 0)
+        data.resize(info.st_size);
+    size_t filled = 0;
+    while (filled < data.size())
+    {
+        ssize_t got = pread(fd, &data[filled], data.size() - filled, filled);
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got <= 0)
+            break;
+        filled += got;
+    }
+    data.resize(filled);
+}
+
+// The length of the record at position, or 0 if it is torn
+static uint32_t recordLength(const string &data, size_t position)
+{
+    if (data.size() - position < 4)
+        return 0;
+    const unsigned char *header = reinterpret_cast<const unsigned char *>(data.data() + position);
+    uint32_t length = (uint32_t(header[0]) << 24) | (uint32_t(header[1]) << 16) | (uint32_t(header[2]) << 8) | header[3];
+    return length < 2 || data.size() - position - 4 < length ? 0 : length;
+}
+
+Journal::Journal(IoBackend &backend, const string &path) : backend(&backend), path(path), fd(-1), offset(0)
+{
+    fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return;
+    // A crash can leave a torn record at the end. Replay stops there, so
+    // appending after it would lose every later record; cut it off instead.
+    string data;
+    readAll(fd, data);
+    size_t end = 0;
+    while (uint32_t length = recordLength(data, end))
+        end += 4 + length;
+    if (end < data.size() && ftruncate(fd, end) != 0)
+    {
+        close(fd);
+        fd = -1;
+        return;
+    }
+    offset = end;
+}
+
+bool Journal::isOpen() const
+{
+    return fd >= 0;
+}
+
+void Journal::setBackend(IoBackend &next)
+{
+    lock_guard<mutex> held(lock);
+    submitBatch();
+    backend->flush();
+    backend = &next;
+}
+
+void Journal::encode(string &buffer, char op, const string &path, const string &content)
+{
+    uint32_t length = 1 + path.size() + 1 + content.size();
+    char header[4] = {char(length >> 24), char(length >> 16), char(length >> 8), char(length)};
+    buffer.append(header, 4);
+    buffer.push_back(op);
+    buffer.append(path);
+    buffer.push_back('\0');
+    buffer.append(content);
+}
+
+void Journal::submitBatch()
+{
+    if (batch.empty())
+        return;
+    uint64_t at = offset;
+    offset += batch.size();
+    backend->write(fd, at, move(batch));
+    batch.clear();
+    batch.reserve(BATCH_BYTES);
+}
+
+void Journal::append(char op, const string &path, const string &content)
+{
+    lock_guard<mutex> held(lock);
+    if (fd < 0)
+        return;
+    encode(batch, op, path, content);
+    if (batch.size() >= BATCH_BYTES)
+        submitBatch();
+}
+
+void Journal::submit()
+{
+    lock_guard<mutex> held(lock);
+    if (fd >= 0)
+        submitBatch();
+}
+
+void Journal::flush()
+{
+    lock_guard<mutex> held(lock);
+    if (fd < 0)
+        return;
+    submitBatch();
+    backend->flush();
+}
+
+uint64_t Journal::mark()
+{
+    lock_guard<mutex> held(lock);
+    if (fd >= 0)
+        submitBatch();
+    return offset;
+}
+
+bool Journal::dropBefore(uint64_t mark)
+{
+    lock_guard<mutex> held(lock);
+    if (fd < 0)
+        return true;
+    // Records appended while the snapshot was written are read back, so
+    // they must have reached the file
+    submitBatch();
+    backend->flush();
+    string tail(offset - mark, '\0');
+    size_t filled = 0;
+    while (filled < tail.size())
+    {
+        ssize_t got = pread(fd, &tail[filled], tail.size() - filled, mark + filled);
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got <= 0)
+            return false;
+        filled += got;
+    }
+    // Renamed over the log once complete, so a crash leaves one or the other
+    string temporary = path + ".tmp";
+    int next = open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (next < 0)
+        return false;
+    size_t written = 0;
+    while (written < tail.size())
+    {
+        ssize_t put = write(next, tail.data() + written, tail.size() - written);
+        if (put < 0 && errno == EINTR)
+            continue;
+        if (put <= 0)
+            break;
+        written += put;
+    }
+    if (written < tail.size() || fdatasync(next) != 0 || rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        close(next);
+        unlink(temporary.c_str());
+        return false;
+    }
+    close(fd);
+    fd = next;
+    offset = tail.size();
+    return true;
+}
+
+Journal::~Journal()
+{
+    flush();
+    if (fd >= 0)
+        close(fd);
+}
+
+// The table index of an id ("F12" -> 12)
+static size_t indexOf(const string &id)
+{
+    return strtoull(id.c_str() + 1, nullptr, 10);
+}
+
+template <typename T>
+static T *inCut(const vector<T *> &table, const string &id)
+{
+    size_t index = indexOf(id);
+    return index < table.size() ? table[index] : nullptr;
+}
+
+static void snapshotFolder(const TreeCut &cut, IoBackend &backend, int fd, size_t folderIndex, const string &path,
+                           string &chunk, uint64_t &offset, size_t &records)
+{
+    const ChildList *children = folderIndex < cut.children.size() ? cut.children[folderIndex] : nullptr;
+    if (!children)
+        return;
+    // Folders first, then files, each in id order
+    for (const string &id : children->ids)
+    {
+        Folder *folder = id[0] == 'F' ? inCut(cut.folders, id) : nullptr;
+        if (!folder)
+            continue;
+        string childPath = path + "/" + folder->getName();
+        Journal::encode(chunk, Journal::CREATE_FOLDER, childPath);
+        records++;
+        snapshotFolder(cut, backend, fd, indexOf(id), childPath, chunk, offset, records);
+    }
+    for (const string &id : children->ids)
+    {
+        File *file = id[0] == 'f' ? inCut(cut.files, id) : nullptr;
+        if (!file)
+            continue;
+        string childPath = path + "/" + file->getFileName();
+        Journal::encode(chunk, Journal::CREATE_FILE, childPath);
+        records++;
+        BlobContent content = file->getContent();
+        if (!content->empty())
+        {
+            Journal::encode(chunk, Journal::WRITE, childPath, *content);
+            records++;
+        }
+    }
+    if (chunk.size() >= SNAPSHOT_CHUNK)
+    {
+        uint64_t at = offset;
+        offset += chunk.size();
+        backend.write(fd, at, move(chunk));
+        chunk.clear();
+    }
+}
+
+bool Journal::writeSnapshot(const TreeCut &cut, IoBackend &backend, const string &path, size_t &records)
+{
+    // Written beside the target and renamed over it once complete, so a
+    // crash mid-save leaves the previous snapshot intact
+    string temporary = path + ".tmp";
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return false;
+    string chunk;
+    uint64_t offset = 0;
+    records = 0;
+    snapshotFolder(cut, backend, fd, cut.root, "", chunk, offset, records);
+    if (!chunk.empty())
+        backend.write(fd, offset, move(chunk));
+    backend.flush();
+    bool saved = fdatasync(fd) == 0;
+    close(fd);
+    return saved && rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+bool Journal::replay(Storage &store, const string &path, size_t &records)
+{
+    records = 0;
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    string data;
+    readAll(fd, data);
+    close(fd);
+
+    ostream quiet(nullptr);
+    Session session = store.openSession(quiet);
+    string root = store.getRootFolderId();
+    size_t position = 0;
+    while (uint32_t length = recordLength(data, position))
+    {
+        string_view record(data.data() + position + 4, length);
+        position += 4 + length;
+        size_t end = record.find('\0', 1);
+        if (end == string_view::npos)
+            break;
+        string target(record.substr(1, end - 1));
+        switch (record[0])
+        {
+        case CREATE_FOLDER:
+            store.addFolder(session, target, root);
+            break;
+        case CREATE_FILE:
+            store.addFile(session, target, root);
+            break;
+        case WRITE:
+            store.addContent(session, target, string(record.substr(end + 1)));
+            break;
+        case REMOVE_FILE:
+            store.removeFile(session, target);
+            break;
+        case REMOVE_FOLDER:
+            store.removeFolder(session, target);
+            break;
+        case MOVE_FILE:
+        case MOVE_FOLDER:
+            store.renameItem(session, record[0] == MOVE_FILE ? 'f' : 'F', target, string(record.substr(end + 1)));
+            break;
+        case COPY_FILE:
+        case COPY_FOLDER:
+            store.duplicateItem(session, record[0] == COPY_FILE ? 'f' : 'F', target, string(record.substr(end + 1)));
+            break;
+        }
+        records++;
+    }
+    return true;
+}
@@ -0,0 +1,167 @@
+// src/storage/LzCodec.cpp
+
+#include "../../include/storage/LzCodec.h"
+#include <cstring>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+static const size_t MIN_MATCH = 4;
+static const size_t WINDOW = 1 << 16;
+static const int HASH_BITS = 16;
+static const int MAX_CHAIN = 32;
+
+static uint32_t read32(const char *p)
+{
+    uint32_t value;
+    memcpy(&value, p, 4);
+    return value;
+}
+
+static uint32_t hash4(const char *p)
+{
+    return (read32(p) * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static void putLength(string &out, size_t length)
+{
+    while (length >= 255)
+    {
+        out.push_back(char(255));
+        length -= 255;
+    }
+    out.push_back(char(length));
+}
+
+static void putSequence(string &out, const char *literals, size_t literalLength, size_t offset, size_t matchLength)
+{
+    size_t matchCode = matchLength ? matchLength - MIN_MATCH : 0;
+    out.push_back(char((min<size_t>(literalLength, 15) << 4) | min<size_t>(matchCode, 15)));
+    if (literalLength >= 15)
+        putLength(out, literalLength - 15);
+    out.append(literals, literalLength);
+    if (!matchLength)
+        return;
+    out.push_back(char(offset & 0xFF));
+    out.push_back(char(offset >> 8));
+    if (matchCode >= 15)
+        putLength(out, matchCode - 15);
+}
+
+string LzCodec::compress(string_view input)
+{
+    // Chains link each position to the previous one with the same hash
+    static thread_local vector<int64_t> head, previous;
+    head.assign(size_t(1) << HASH_BITS, -1);
+    previous.assign(WINDOW, -1);
+
+    const char *data = input.data();
+    size_t size = input.size();
+    string out;
+    out.reserve(size / 2 + 16);
+    size_t anchor = 0, position = 0;
+    auto insert = [&](size_t at)
+    {
+        uint32_t h = hash4(data + at);
+        previous[at & (WINDOW - 1)] = head[h];
+        head[h] = at;
+    };
+
+    while (position + MIN_MATCH <= size)
+    {
+        size_t bestLength = 0, bestOffset = 0;
+        int64_t candidate = head[hash4(data + position)];
+        for (int depth = 0; depth < MAX_CHAIN && candidate >= 0 && position - candidate < WINDOW; depth++)
+        {
+            if (read32(data + candidate) == read32(data + position))
+            {
+                size_t length = MIN_MATCH;
+                while (position + length < size && data[candidate + length] == data[position + length])
+                    length++;
+                if (length > bestLength)
+                {
+                    bestLength = length;
+                    bestOffset = position - candidate;
+                }
+            }
+            int64_t next = previous[candidate & (WINDOW - 1)];
+            if (next >= candidate)
+                break;
+            candidate = next;
+        }
+        if (bestLength < MIN_MATCH)
+        {
+            insert(position++);
+            continue;
+        }
+        putSequence(out, data + anchor, position - anchor, bestOffset, bestLength);
+        size_t end = position + bestLength;
+        for (; position < end; position++)
+            if (position + MIN_MATCH <= size)
+                insert(position);
+        anchor = position = end;
+    }
+    putSequence(out, data + anchor, size - anchor, 0, 0);
+    return out;
+}
+
+bool LzCodec::decompress(string_view packed, size_t size, string &output)
+{
+    // Slack at the end lets matches copy in whole 8-byte words
+    output.resize(size + 8);
+    const unsigned char *in = reinterpret_cast<const unsigned char *>(packed.data());
+    const unsigned char *inEnd = in + packed.size();
+    char *out = &output[0];
+    size_t written = 0;
+    auto readLength = [&](size_t length, bool &ok)
+    {
+        if (length == 15)
+        {
+            unsigned char more;
+            do
+            {
+                if (in >= inEnd)
+                {
+                    ok = false;
+                    return length;
+                }
+                more = *in++;
+                length += more;
+            } while (more == 255);
+        }
+        return length;
+    };
+
+    while (in < inEnd)
+    {
+        bool ok = true;
+        unsigned token = *in++;
+        size_t literals = readLength(token >> 4, ok);
+        if (!ok || size_t(inEnd - in) < literals || size - written < literals)
+            return false;
+        memcpy(out + written, in, literals);
+        in += literals;
+        written += literals;
+        if (in == inEnd)
+            break;
+        if (inEnd - in < 2)
+            return false;
+        size_t offset = in[0] | (size_t(in[1]) << 8);
+        in += 2;
+        size_t length = readLength(token & 15, ok) + MIN_MATCH;
+        if (!ok || offset == 0 || offset > written || size - written < length)
+            return false;
+        const char *from = out + written - offset;
+        char *to = out + written;
+        if (offset >= 8)
+            for (size_t i = 0; i < length; i += 8)
+                memcpy(to + i, from + i, 8);
+        else
+            for (size_t i = 0; i < length; i++)
+                to[i] = from[i];
+        written += length;
+    }
+    output.resize(written);
+    return written == size;
+}
@@ -0,0 +1,368 @@
+// src/storage/NameIndex.cpp
+
+#include "../../include/storage/NameIndex.h"
+#include <algorithm>
+
+using namespace std;
+
+// Cleared slots are only compacted away, and empty postings dropped, once
+// there are this many
+static const size_t MIN_COMPACTION = 16;
+static const size_t MIN_REBUILD = 1024;
+
+NameIndex::NameIndex(EpochManager &epochs) : epochs(epochs) {}
+
+static bool keyLess(const NameIndex::Posting *a, string_view key)
+{
+    return a->key < key;
+}
+
+static bool keyAfter(string_view key, const NameIndex::Posting *a)
+{
+    return key < a->key;
+}
+
+static bool postingLess(const NameIndex::Posting *a, const NameIndex::Posting *b)
+{
+    return a->key < b->key;
+}
+
+// The child of an inner node whose range holds key
+static size_t childFor(const vector<const NameIndex::Posting *> &firsts, string_view key)
+{
+    size_t after = upper_bound(firsts.begin(), firsts.end(), key, keyAfter) - firsts.begin();
+    return after ? after - 1 : 0;
+}
+
+vector<const NameIndex::Node *> NameIndex::merge(const Node *node, const Posting *const *first,
+                                                 const Posting *const *last, vector<const Node *> &replaced)
+{
+    vector<const Node *> out;
+    if (first == last)
+    {
+        if (node)
+            out.push_back(node);
+        return out;
+    }
+    if (!node || node->leaf)
+    {
+        vector<const Posting *> postings;
+        postings.reserve((node ? node->postings.size() : 0) + (last - first));
+        if (node)
+            std::merge(node->postings.begin(), node->postings.end(), first, last, back_inserter(postings), postingLess);
+        else
+            postings.assign(first, last);
+        fill(true, postings, {}, out);
+    }
+    else
+    {
+        vector<const Node *> children;
+        for (size_t i = 0; i < node->children.size(); i++)
+        {
+            // Keys below the next child's first key belong to this one
+            const Posting *const *to = i + 1 < node->children.size()
+                                           ? lower_bound(first, last, node->postings[i + 1]->key, keyLess)
+                                           : last;
+            vector<const Node *> merged = merge(node->children[i], first, to, replaced);
+            children.insert(children.end(), merged.begin(), merged.end());
+            first = to;
+        }
+        vector<const Posting *> firsts;
+        for (const Node *child : children)
+            firsts.push_back(child->postings[0]);
+        fill(false, firsts, children, out);
+    }
+    if (node)
+        replaced.push_back(node);
+    return out;
+}
+
+void NameIndex::fill(bool leaf, const vector<const Posting *> &postings, const vector<const Node *> &children,
+                     vector<const Node *> &out)
+{
+    size_t size = postings.size();
+    size_t nodes = (size + NODE_CAPACITY - 1) / NODE_CAPACITY;
+    for (size_t i = 0; i < nodes; i++)
+    {
+        size_t begin = size * i / nodes, end = size * (i + 1) / nodes;
+        Node *node = new Node{leaf, {}, {}};
+        node->postings.assign(postings.begin() + begin, postings.begin() + end);
+        if (!leaf)
+            node->children.assign(children.begin() + begin, children.begin() + end);
+        out.push_back(node);
+    }
+}
+
+const NameIndex::Node *NameIndex::join(vector<const Node *> level)
+{
+    while (level.size() > 1)
+    {
+        vector<const Posting *> firsts;
+        for (const Node *node : level)
+            firsts.push_back(node->postings[0]);
+        vector<const Node *> parents;
+        fill(false, firsts, level, parents);
+        level.swap(parents);
+    }
+    return level.empty() ? nullptr : level[0];
+}
+
+void NameIndex::addPending(Tree &tree, const Posting *posting)
+{
+    Pending *pending = tree.pending.load(memory_order_relaxed);
+    if (!pending)
+    {
+        pending = new Pending();
+        tree.pending.store(pending, memory_order_release);
+    }
+    // The posting is written before the size that makes it visible
+    size_t size = pending->size.load(memory_order_relaxed);
+    pending->postings[size] = posting;
+    pending->size.store(size + 1, memory_order_release);
+    if (size + 1 == PENDING_CAPACITY)
+        mergePending(tree, pending);
+}
+
+void NameIndex::mergePending(Tree &tree, Pending *pending)
+{
+    vector<const Posting *> batch(pending->postings, pending->postings + PENDING_CAPACITY);
+    sort(batch.begin(), batch.end(), postingLess);
+    vector<const Node *> replaced;
+    const Node *root = join(merge(tree.root.load(memory_order_relaxed), batch.data(), batch.data() + batch.size(), replaced));
+    // The tree holds the batch before the pending one goes, so a reader
+    // never misses a name; one that sees both skips the pending copy
+    tree.root.store(root, memory_order_release);
+    tree.pending.store(nullptr, memory_order_release);
+    // Retired only once they are unreachable: a reader that starts after
+    // the retirement must not be able to reach them
+    epochs.retire(pending);
+    for (const Node *node : replaced)
+        epochs.retire(node);
+}
+
+void NameIndex::rebuild(Tree &tree)
+{
+    vector<const Posting *> kept, dropped;
+    scan(tree, "", [&](const Posting &posting)
+         {
+             (posting.live ? kept : dropped).push_back(&posting);
+             return true; });
+    vector<const Node *> old, unused;
+    collectNodes(tree.root.load(memory_order_relaxed), old);
+    Pending *pending = tree.pending.load(memory_order_relaxed);
+    tree.root.store(join(merge(nullptr, kept.data(), kept.data() + kept.size(), unused)), memory_order_release);
+    tree.pending.store(nullptr, memory_order_release);
+    if (pending)
+        epochs.retire(pending);
+    for (const Node *node : old)
+        epochs.retire(node);
+    for (const Posting *posting : dropped)
+    {
+        tree.byKey.erase(posting->key);
+        epochs.retire(posting);
+    }
+    tree.empty = 0;
+}
+
+// Replaces the posting list with one holding only its live slots, with
+// room to grow
+void NameIndex::compact(Tree &tree, Posting &posting)
+{
+    const Slots *slots = posting.slots.load(memory_order_relaxed);
+    size_t size = slots->size.load(memory_order_relaxed);
+    Slots *copy = new Slots(max<size_t>(4, (posting.live + 1) * 2));
+    size_t kept = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        uint64_t node = slots->keys[i].load(memory_order_relaxed);
+        if (node == Slots::CLEARED)
+            continue;
+        tree.positions[node] = kept;
+        copy->keys[kept++].store(node, memory_order_relaxed);
+    }
+    copy->size.store(kept, memory_order_relaxed);
+    posting.cleared = 0;
+    posting.slots.store(copy, memory_order_release);
+    epochs.retire(slots);
+}
+
+void NameIndex::addTo(Tree &tree, const string &key, uint64_t node)
+{
+    auto found = tree.byKey.find(key);
+    Posting *posting;
+    if (found != tree.byKey.end())
+    {
+        posting = found->second;
+        if (posting->live == 0)
+            tree.empty--;
+    }
+    else
+    {
+        posting = new Posting(key);
+        tree.byKey.emplace(posting->key, posting);
+        addPending(tree, posting);
+    }
+    posting->live++;
+    Slots *slots = posting->slots.load(memory_order_relaxed);
+    if (slots->size.load(memory_order_relaxed) == slots->capacity)
+    {
+        compact(tree, *posting);
+        slots = posting->slots.load(memory_order_relaxed);
+    }
+    size_t size = slots->size.load(memory_order_relaxed);
+    if (tree.positions.size() <= node)
+        tree.positions.resize(max<size_t>(node + 1, tree.positions.size() * 2));
+    tree.positions[node] = size;
+    // The slot is written before the size that makes it visible
+    slots->keys[size].store(node, memory_order_relaxed);
+    slots->size.store(size + 1, memory_order_release);
+}
+
+void NameIndex::removeFrom(Tree &tree, const string &key, uint64_t node)
+{
+    auto found = tree.byKey.find(key);
+    if (found == tree.byKey.end())
+        return;
+    Posting *posting = found->second;
+    posting->slots.load(memory_order_relaxed)->keys[tree.positions[node]].store(Slots::CLEARED, memory_order_relaxed);
+    posting->cleared++;
+    posting->live--;
+    if (posting->cleared >= MIN_COMPACTION && posting->cleared > posting->live)
+        compact(tree, *posting);
+    if (posting->live == 0 && ++tree.empty >= MIN_REBUILD && tree.empty * 2 > tree.byKey.size())
+        rebuild(tree);
+}
+
+bool NameIndex::scan(const Tree &tree, string_view from, const PostingVisitor &visit)
+{
+    // The pending batch is read first: if the writer moves it into the tree
+    // in between, its postings are seen twice rather than not at all
+    const Pending *pending = tree.pending.load(memory_order_acquire);
+    const Node *root = tree.root.load(memory_order_acquire);
+    vector<const Posting *> recent;
+    if (pending)
+    {
+        size_t size = pending->size.load(memory_order_acquire);
+        for (size_t i = 0; i < size; i++)
+            if (pending->postings[i]->key >= from)
+                recent.push_back(pending->postings[i]);
+        sort(recent.begin(), recent.end(), postingLess);
+    }
+    size_t next = 0;
+    auto merged = [&](const Posting &posting)
+    {
+        while (next < recent.size() && recent[next]->key < posting.key)
+            if (!visit(*recent[next++]))
+                return false;
+        if (next < recent.size() && recent[next] == &posting)
+            next++;
+        return visit(posting);
+    };
+    if (root && !scan(root, from, merged))
+        return false;
+    while (next < recent.size())
+        if (!visit(*recent[next++]))
+            return false;
+    return true;
+}
+
+bool NameIndex::scan(const Node *node, string_view from, const PostingVisitor &visit)
+{
+    if (node->leaf)
+    {
+        for (auto it = lower_bound(node->postings.begin(), node->postings.end(), from, keyLess); it != node->postings.end(); ++it)
+            if (!visit(**it))
+                return false;
+        return true;
+    }
+    for (size_t i = childFor(node->postings, from); i < node->children.size(); i++)
+        if (!scan(node->children[i], from, visit))
+            return false;
+    return true;
+}
+
+void NameIndex::collectNodes(const Node *node, vector<const Node *> &out)
+{
+    if (!node)
+        return;
+    for (const Node *child : node->children)
+        collectNodes(child, out);
+    out.push_back(node);
+}
+
+string NameIndex::extensionOf(const string &name)
+{
+    size_t dot = name.find('.');
+    return dot == string::npos || dot + 1 == name.size() ? "" : name.substr(dot + 1);
+}
+
+bool NameIndex::extensionMatches(const string &extension, string_view suffix)
+{
+    size_t size = extension.size();
+    return size >= suffix.size() && extension.compare(size - suffix.size(), suffix.size(), suffix) == 0 &&
+           (size == suffix.size() || extension[size - suffix.size() - 1] == '.');
+}
+
+static uint64_t packNode(char kind, size_t index)
+{
+    return uint64_t(index) * 2 + (kind == 'f' ? 1 : 0);
+}
+
+void NameIndex::add(const string &name, char kind, size_t index, const string &extension)
+{
+    uint64_t node = packNode(kind, index);
+    addTo(names, name, node);
+    if (!extension.empty())
+        addTo(extensions, extension, node);
+    count.fetch_add(1, memory_order_relaxed);
+}
+
+void NameIndex::remove(const string &name, char kind, size_t index, const string &extension)
+{
+    uint64_t node = packNode(kind, index);
+    removeFrom(names, name, node);
+    if (!extension.empty())
+        removeFrom(extensions, extension, node);
+    count.fetch_sub(1, memory_order_relaxed);
+}
+
+void NameIndex::forEachName(string_view prefix, const PostingVisitor &visit) const
+{
+    scan(names, prefix, [&](const Posting &posting)
+         { return posting.key.compare(0, prefix.size(), prefix) == 0 && visit(posting); });
+}
+
+void NameIndex::forEachExtension(string_view suffix, const PostingVisitor &visit) const
+{
+    // Extensions ending in suffix are not contiguous in key order, but there
+    // are few distinct ones, so all of them are checked
+    scan(extensions, "", [&](const Posting &posting)
+         { return !extensionMatches(posting.key, suffix) || visit(posting); });
+}
+
+bool NameIndex::forEachNode(const Posting &posting, const NodeVisitor &visit)
+{
+    const Slots *slots = posting.slots.load(memory_order_acquire);
+    size_t size = slots->size.load(memory_order_acquire);
+    for (size_t i = 0; i < size; i++)
+    {
+        uint64_t node = slots->keys[i].load(memory_order_relaxed);
+        if (node != Slots::CLEARED && !visit(node & 1 ? 'f' : 'F', node / 2))
+            return false;
+    }
+    return true;
+}
+
+NameIndex::~NameIndex()
+{
+    for (Tree *tree : {&names, &extensions})
+    {
+        vector<const Node *> nodes;
+        collectNodes(tree->root.load(memory_order_relaxed), nodes);
+        for (const Node *node : nodes)
+            delete node;
+        delete tree->pending.load(memory_order_relaxed);
+        for (auto &entry : tree->byKey)
+            delete entry.second;
+    }
+}
@@ -0,0 +1,289 @@
+// src/storage/OperationStats.cpp
+
+#include "../../include/storage/OperationStats.h"
+#include <iomanip>
+#include <algorithm>
+
+using namespace std;
+
+static const char *OPERATION_NAMES[OperationStats::OPERATION_COUNT] = {
+    "CREATE_FILE", "WRITE_FILE", "READ_FILE", "REMOVE_FILE", "CREATE_FOLDER", "REMOVE_FOLDER",
+    "CHANGE_DIR", "LIST_ITEMS", "SHOW_TREE", "GREP", "GREP_FILE", "GREP_RECURSIVE", "GREP_OPTIONS",
+    "GREP_HELP", "FIND", "LOCATE", "MOVE", "COPY", "SAVE_SNAPSHOT", "LOAD_SNAPSHOT", "IMPORT", "EXPORT", "DISK_USAGE", "FREE_SPACE"};
+
+// Percentiles reported by writeTable and writeJson
+static const double PERCENTILES[] = {0.5, 0.9, 0.99, 0.999};
+static const char *PERCENTILE_NAMES[] = {"p50", "p90", "p99", "p999"};
+
+LatencyHistogram::LatencyHistogram()
+{
+    for (auto &bucket : counts)
+        bucket.store(0, memory_order_relaxed);
+}
+
+int LatencyHistogram::bucketOf(uint64_t nanos)
+{
+    nanos = min(nanos, MAX_NANOS);
+    if (nanos < uint64_t(SUB_BUCKETS))
+        return int(nanos);
+    // The top SUB_BUCKET_BITS + 1 bits pick the bucket; the lower ones are dropped
+    int shift = 63 - __builtin_clzll(nanos) - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKETS + int(nanos >> shift) - SUB_BUCKETS;
+}
+
+uint64_t LatencyHistogram::bucketLimit(int bucket)
+{
+    int group = bucket / SUB_BUCKETS;
+    uint64_t sub = bucket % SUB_BUCKETS;
+    if (group == 0)
+        return sub;
+    int shift = group - 1;
+    return ((SUB_BUCKETS + sub) << shift) + (uint64_t(1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t nanos)
+{
+    counts[bucketOf(nanos)].fetch_add(1, memory_order_relaxed);
+    count.fetch_add(1, memory_order_relaxed);
+    sum.fetch_add(nanos, memory_order_relaxed);
+    uint64_t seen = maximum.load(memory_order_relaxed);
+    while (nanos > seen && !maximum.compare_exchange_weak(seen, nanos, memory_order_relaxed))
+    {
+    }
+}
+
+uint64_t LatencyHistogram::getCount() const { return count.load(memory_order_relaxed); }
+
+uint64_t LatencyHistogram::getSum() const { return sum.load(memory_order_relaxed); }
+
+uint64_t LatencyHistogram::getMax() const { return maximum.load(memory_order_relaxed); }
+
+uint64_t LatencyHistogram::getBucketCount(int bucket) const { return counts[bucket].load(memory_order_relaxed); }
+
+uint64_t LatencyHistogram::percentile(double q) const
+{
+    uint64_t total = 0;
+    for (const auto &bucket : counts)
+        total += bucket.load(memory_order_relaxed);
+    if (total == 0)
+        return 0;
+    uint64_t rank = max<uint64_t>(1, uint64_t(q * total + 0.5));
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < BUCKETS; bucket++)
+    {
+        seen += counts[bucket].load(memory_order_relaxed);
+        if (seen >= rank)
+            return min(bucketLimit(bucket), getMax());
+    }
+    return getMax();
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto &bucket : counts)
+        bucket.store(0, memory_order_relaxed);
+    count.store(0, memory_order_relaxed);
+    sum.store(0, memory_order_relaxed);
+    maximum.store(0, memory_order_relaxed);
+}
+
+// Counters are read outside the timed span so their syscalls stay out of
+// the latencies
+OperationStats::Timer::Timer(OperationStats &stats, Operation operation)
+    : stats(stats), operation(operation),
+      counting(PerfCounters::isEnabled() && PerfCounters::read(counters)),
+      started(chrono::steady_clock::now()) {}
+
+OperationStats::Timer::~Timer()
+{
+    auto elapsed = chrono::steady_clock::now() - started;
+    stats.record(operation, chrono::duration_cast<chrono::nanoseconds>(elapsed).count());
+    PerfCounters::Sample end;
+    if (counting && PerfCounters::read(end))
+        stats.recordCounters(operation, counters, end);
+}
+
+OperationStats::CounterSums::CounterSums()
+{
+    for (auto &value : values)
+        value.store(0, memory_order_relaxed);
+}
+
+// Returns the slot's object, creating it first if need be; two threads may
+// race to create it, and the loser frees its copy
+template <typename T>
+static T *loadOrCreate(atomic<T *> &slot)
+{
+    T *existing = slot.load(memory_order_acquire);
+    if (existing)
+        return existing;
+    T *created = new T();
+    if (slot.compare_exchange_strong(existing, created, memory_order_acq_rel))
+        return created;
+    delete created;
+    return existing;
+}
+
+OperationStats::OperationStats()
+{
+    for (auto &histogram : histograms)
+        histogram.store(nullptr, memory_order_relaxed);
+    for (auto &sums : counterSums)
+        sums.store(nullptr, memory_order_relaxed);
+}
+
+OperationStats::~OperationStats()
+{
+    for (auto &histogram : histograms)
+        delete histogram.load(memory_order_relaxed);
+    for (auto &sums : counterSums)
+        delete sums.load(memory_order_relaxed);
+}
+
+const char *OperationStats::getName(Operation operation) { return OPERATION_NAMES[operation]; }
+
+void OperationStats::record(Operation operation, uint64_t nanos)
+{
+    loadOrCreate(histograms[operation])->record(nanos);
+}
+
+void OperationStats::recordCounters(Operation operation, const PerfCounters::Sample &start, const PerfCounters::Sample &end)
+{
+    CounterSums *sums = loadOrCreate(counterSums[operation]);
+    sums->calls.fetch_add(1, memory_order_relaxed);
+    for (int counter = 0; counter < PerfCounters::COUNTER_COUNT; counter++)
+        // Scaling for multiplexing can make a delta come out slightly negative
+        if (end.values[counter] > start.values[counter])
+            sums->values[counter].fetch_add(end.values[counter] - start.values[counter], memory_order_relaxed);
+}
+
+const LatencyHistogram *OperationStats::getHistogram(Operation operation) const
+{
+    return histograms[operation].load(memory_order_acquire);
+}
+
+const OperationStats::CounterSums *OperationStats::getCounterSums(Operation operation) const
+{
+    return counterSums[operation].load(memory_order_acquire);
+}
+
+void OperationStats::reset()
+{
+    for (auto &histogram : histograms)
+        if (LatencyHistogram *existing = histogram.load(memory_order_acquire))
+            existing->reset();
+    for (auto &sums : counterSums)
+        if (CounterSums *existing = sums.load(memory_order_acquire))
+        {
+            existing->calls.store(0, memory_order_relaxed);
+            for (auto &value : existing->values)
+                value.store(0, memory_order_relaxed);
+        }
+}
+
+// Per-call averages and derived ratios; "-" where a counter is unavailable
+static void writeCounterTable(ostream &out, const OperationStats &stats)
+{
+    typedef PerfCounters P;
+    out << endl
+        << "     " << left << setw(16) << "Operation" << right << setw(10) << "Sampled" << setw(12) << "Cycles"
+        << setw(12) << "Instr" << setw(8) << "IPC" << setw(12) << "Cache MPKI" << setw(13) << "Branch MPKI"
+        << setw(10) << "CPU us" << setw(10) << "Faults" << "   (per call)" << endl;
+    auto cell = [&out](int width, bool known, double value, int precision)
+    {
+        if (known)
+            out << setw(width) << fixed << setprecision(precision) << value;
+        else
+            out << setw(width) << "-";
+    };
+    for (int op = 0; op < OperationStats::OPERATION_COUNT; op++)
+    {
+        const OperationStats::CounterSums *sums = stats.getCounterSums(OperationStats::Operation(op));
+        uint64_t calls = sums ? sums->calls.load(memory_order_relaxed) : 0;
+        if (!calls)
+            continue;
+        double value[P::COUNTER_COUNT];
+        for (int counter = 0; counter < P::COUNTER_COUNT; counter++)
+            value[counter] = double(sums->values[counter].load(memory_order_relaxed));
+        bool cycles = P::isAvailable(P::CYCLES);
+        bool instructions = P::isAvailable(P::INSTRUCTIONS) && value[P::INSTRUCTIONS] > 0;
+        out << "     " << left << setw(16) << OperationStats::getName(OperationStats::Operation(op)) << right << setw(10) << calls;
+        cell(12, cycles, value[P::CYCLES] / calls, 0);
+        cell(12, P::isAvailable(P::INSTRUCTIONS), value[P::INSTRUCTIONS] / calls, 0);
+        cell(8, cycles && instructions && value[P::CYCLES] > 0, value[P::INSTRUCTIONS] / value[P::CYCLES], 2);
+        cell(12, instructions && P::isAvailable(P::CACHE_MISSES), value[P::CACHE_MISSES] * 1000 / value[P::INSTRUCTIONS], 2);
+        cell(13, instructions && P::isAvailable(P::BRANCH_MISSES), value[P::BRANCH_MISSES] * 1000 / value[P::INSTRUCTIONS], 2);
+        cell(10, P::isAvailable(P::TASK_CLOCK), value[P::TASK_CLOCK] / 1000.0 / calls, 1);
+        cell(10, P::isAvailable(P::PAGE_FAULTS), value[P::PAGE_FAULTS] / calls, 1);
+        out << endl;
+    }
+    out << defaultfloat << setprecision(6);
+}
+
+void OperationStats::writeTable(ostream &out) const
+{
+    out << "     " << left << setw(16) << "Operation" << right << setw(10) << "Calls" << setw(10) << "Mean";
+    for (const char *name : PERCENTILE_NAMES)
+        out << setw(10) << name;
+    out << setw(10) << "Max" << "   (us)" << endl;
+    out << fixed << setprecision(1);
+    bool any = false;
+    for (int op = 0; op < OPERATION_COUNT; op++)
+    {
+        const LatencyHistogram *histogram = getHistogram(Operation(op));
+        if (!histogram || histogram->getCount() == 0)
+            continue;
+        any = true;
+        uint64_t calls = histogram->getCount();
+        out << "     " << left << setw(16) << OPERATION_NAMES[op] << right << setw(10) << calls
+            << setw(10) << histogram->getSum() / 1000.0 / calls;
+        for (double q : PERCENTILES)
+            out << setw(10) << histogram->percentile(q) / 1000.0;
+        out << setw(10) << histogram->getMax() / 1000.0 << endl;
+    }
+    out << defaultfloat << setprecision(6);
+    if (!any)
+        out << "     No operations recorded yet." << endl;
+    if (PerfCounters::isEnabled())
+        writeCounterTable(out, *this);
+}
+
+void OperationStats::writeJson(ostream &out) const
+{
+    out << "{\"unit\": \"ns\", \"sub_buckets\": " << LatencyHistogram::SUB_BUCKETS << ", \"operations\": [";
+    bool first = true;
+    for (int op = 0; op < OPERATION_COUNT; op++)
+    {
+        const LatencyHistogram *histogram = getHistogram(Operation(op));
+        if (!histogram || histogram->getCount() == 0)
+            continue;
+        out << (first ? "" : ",") << "\n  {\"name\": \"" << OPERATION_NAMES[op] << "\", \"count\": " << histogram->getCount()
+            << ", \"sum\": " << histogram->getSum() << ", \"max\": " << histogram->getMax();
+        first = false;
+        for (size_t i = 0; i < sizeof(PERCENTILES) / sizeof(PERCENTILES[0]); i++)
+            out << ", \"" << PERCENTILE_NAMES[i] << "\": " << histogram->percentile(PERCENTILES[i]);
+        // [largest value in the bucket, count] for every non-empty bucket
+        out << ", \"buckets\": [";
+        bool firstBucket = true;
+        for (int bucket = 0; bucket < LatencyHistogram::BUCKETS; bucket++)
+            if (uint64_t count = histogram->getBucketCount(bucket))
+            {
+                out << (firstBucket ? "" : ", ") << "[" << LatencyHistogram::bucketLimit(bucket) << ", " << count << "]";
+                firstBucket = false;
+            }
+        out << "]";
+        // Counter totals over the sampled calls, for the counters this machine has
+        const CounterSums *sums = getCounterSums(Operation(op));
+        if (sums && sums->calls.load(memory_order_relaxed))
+        {
+            out << ", \"counters\": {\"calls\": " << sums->calls.load(memory_order_relaxed);
+            for (int counter = 0; counter < PerfCounters::COUNTER_COUNT; counter++)
+                if (PerfCounters::isAvailable(PerfCounters::Counter(counter)))
+                    out << ", \"" << PerfCounters::getName(PerfCounters::Counter(counter))
+                        << "\": " << sums->values[counter].load(memory_order_relaxed);
+            out << "}";
+        }
+        out << "}";
+    }
+    out << "\n]}" << endl;
+}
@@ -0,0 +1,166 @@
+// src/storage/PerfCounters.cpp
+
+#include "../../include/storage/PerfCounters.h"
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace
+{
+    struct CounterSpec
+    {
+        const char *name;
+        uint32_t type;
+        uint64_t config;
+    };
+
+    const CounterSpec COUNTERS[PerfCounters::COUNTER_COUNT] = {
+        {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {"cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        {"task-clock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+        {"page-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS}};
+
+    int openCounter(const CounterSpec &spec, int group)
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = spec.type;
+        attr.config = spec.config;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        // Only the leader starts disabled; members follow it
+        attr.disabled = group < 0;
+        // Unprivileged users may only count their own user-space work
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return int(syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+    }
+
+    // The calling thread's counter group, closed when the thread exits
+    struct ThreadCounters
+    {
+        bool opened = false;
+        int leader = -1;
+        int fds[PerfCounters::COUNTER_COUNT];
+        // Which counter each value of a group read belongs to, in order
+        int order[PerfCounters::COUNTER_COUNT];
+        int members = 0;
+
+        // Opens every counter in the mask that works; returns the ones that did
+        uint32_t open(uint32_t mask, int &failure)
+        {
+            opened = true;
+            uint32_t working = 0;
+            for (int counter = 0; counter < PerfCounters::COUNTER_COUNT; counter++)
+            {
+                fds[counter] = -1;
+                if (!(mask & (1u << counter)))
+                    continue;
+                int fd = openCounter(COUNTERS[counter], leader);
+                if (fd < 0)
+                {
+                    failure = errno;
+                    continue;
+                }
+                if (leader < 0)
+                    leader = fd;
+                fds[counter] = fd;
+                order[members++] = counter;
+                working |= 1u << counter;
+            }
+            if (leader >= 0)
+            {
+                ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+                ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            }
+            return working;
+        }
+
+        void close()
+        {
+            for (int i = 0; i < members; i++)
+                ::close(fds[order[i]]);
+            members = 0;
+            leader = -1;
+            opened = false;
+        }
+
+        ~ThreadCounters()
+        {
+            close();
+        }
+    };
+
+    thread_local ThreadCounters local;
+}
+
+atomic<bool> PerfCounters::enabled{false};
+atomic<uint32_t> PerfCounters::available{0};
+
+bool PerfCounters::enable(string &error)
+{
+    local.close();
+    int failure = 0;
+    uint32_t working = local.open((1u << COUNTER_COUNT) - 1, failure);
+    available.store(working, memory_order_relaxed);
+    if (!working)
+    {
+        error = strerror(failure);
+        if (failure == EACCES || failure == EPERM)
+            error += " (see /proc/sys/kernel/perf_event_paranoid)";
+        local.close();
+        return false;
+    }
+    error.clear();
+    if (working != (1u << COUNTER_COUNT) - 1)
+    {
+        error = "unavailable:";
+        for (int counter = 0; counter < COUNTER_COUNT; counter++)
+            if (!(working & (1u << counter)))
+                error += string(" ") + COUNTERS[counter].name;
+        error += string(" (") + strerror(failure) + ")";
+    }
+    enabled.store(true, memory_order_relaxed);
+    return true;
+}
+
+void PerfCounters::disable()
+{
+    enabled.store(false, memory_order_relaxed);
+}
+
+const char *PerfCounters::getName(Counter counter) { return COUNTERS[counter].name; }
+
+bool PerfCounters::read(Sample &sample)
+{
+    if (!local.opened)
+    {
+        int failure = 0;
+        local.open(available.load(memory_order_relaxed), failure);
+    }
+    if (local.leader < 0)
+        return false;
+    // nr, time enabled, time running, then one value per member
+    uint64_t buffer[3 + COUNTER_COUNT];
+    ssize_t length = ::read(local.leader, buffer, sizeof(buffer));
+    if (length < ssize_t(3 * sizeof(uint64_t)) || buffer[0] != uint64_t(local.members))
+        return false;
+    uint64_t timeEnabled = buffer[1];
+    uint64_t timeRunning = buffer[2];
+    for (int i = 0; i < local.members; i++)
+    {
+        uint64_t value = buffer[3 + i];
+        // The group only ran for part of the time if the PMU was shared
+        if (timeRunning && timeRunning < timeEnabled)
+            value = uint64_t(double(value) * timeEnabled / timeRunning);
+        sample.values[local.order[i]] = value;
+    }
+    return true;
+}
@@ -0,0 +1,139 @@
+// src/storage/SlowCommandLog.cpp
+
+#include "../../include/storage/SlowCommandLog.h"
+#include <iomanip>
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+static const char *PHASE_NAMES[SlowCommandLog::PHASE_COUNT] = {"parse", "resolve", "lock wait", "history"};
+static const char *PHASE_KEYS[SlowCommandLog::PHASE_COUNT] = {"parse_ns", "resolve_ns", "lock_wait_ns", "history_ns"};
+
+// JSON string body: quotes, backslashes and control characters escaped
+static void writeEscaped(ostream &out, const string &text)
+{
+    for (unsigned char c : text)
+    {
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if (c < 0x20)
+            out << "\\u" << hex << setw(4) << setfill('0') << int(c) << dec << setfill(' ');
+        else
+            out << c;
+    }
+}
+
+static string formatTime(time_t time)
+{
+    char buffer[32];
+    struct tm local;
+    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", localtime_r(&time, &local));
+    return buffer;
+}
+
+const char *SlowCommandLog::getName(Phase phase) { return PHASE_NAMES[phase]; }
+
+bool SlowCommandLog::setFile(const string &hostPath)
+{
+    lock_guard<mutex> held(lock);
+    if (file.is_open())
+        file.close();
+    filePath.clear();
+    if (hostPath.empty())
+        return true;
+    file.open(hostPath, ios::app);
+    if (!file)
+        return false;
+    filePath = hostPath;
+    return true;
+}
+
+uint64_t SlowCommandLog::begin()
+{
+    if (!getThreshold())
+    {
+        probe.active = false;
+        return 0;
+    }
+    probe = Probe{};
+    probe.active = true;
+    return now();
+}
+
+uint64_t SlowCommandLog::end(uint64_t started)
+{
+    probe.active = false;
+    uint64_t elapsed = now() - started;
+    uint64_t threshold = getThreshold();
+    return threshold && elapsed >= threshold ? elapsed : 0;
+}
+
+void SlowCommandLog::record(string_view command, const string &currentPath, uint64_t nanos)
+{
+    Entry entry;
+    entry.time = time(nullptr);
+    entry.nanos = nanos;
+    entry.command.assign(command);
+    entry.currentPath = currentPath;
+    entry.nodes = probe.nodes;
+    memcpy(entry.phases, probe.phases, sizeof(entry.phases));
+
+    lock_guard<mutex> held(lock);
+    if (file.is_open())
+    {
+        file << "{\"time\": \"" << formatTime(entry.time) << "\", \"ns\": " << entry.nanos << ", \"command\": \"";
+        writeEscaped(file, entry.command);
+        file << "\", \"cwd\": \"";
+        writeEscaped(file, entry.currentPath);
+        file << "\", \"nodes\": " << entry.nodes;
+        for (int phase = 0; phase < PHASE_COUNT; phase++)
+            file << ", \"" << PHASE_KEYS[phase] << "\": " << entry.phases[phase];
+        file << "}" << endl;
+    }
+    if (entries.size() < CAPACITY)
+        entries.push_back(move(entry));
+    else
+        entries[written % CAPACITY] = move(entry);
+    written++;
+}
+
+void SlowCommandLog::clear()
+{
+    lock_guard<mutex> held(lock);
+    entries.clear();
+    written = 0;
+}
+
+void SlowCommandLog::write(ostream &out) const
+{
+    lock_guard<mutex> held(lock);
+    uint64_t threshold = getThreshold();
+    if (threshold)
+        out << "     Threshold " << threshold / 1e6 << " ms";
+    else
+        out << "     Slow command log is off";
+    out << ", " << written << " slow command" << (written == 1 ? "" : "s") << " recorded";
+    if (written > entries.size())
+        out << " (showing the last " << entries.size() << ")";
+    if (!filePath.empty())
+        out << ", appending to " << filePath;
+    out << endl;
+    out << fixed << setprecision(3);
+    uint64_t first = written - entries.size();
+    for (uint64_t i = first; i < written; i++)
+    {
+        const Entry &entry = entries[i % CAPACITY];
+        uint64_t other = entry.nanos;
+        out << "     " << formatTime(entry.time) << "  " << setw(10) << entry.nanos / 1e6 << " ms  "
+            << entry.command << "   (in " << entry.currentPath << ")" << endl;
+        out << "         nodes " << entry.nodes;
+        for (int phase = 0; phase < PHASE_COUNT; phase++)
+        {
+            out << ", " << PHASE_NAMES[phase] << " " << entry.phases[phase] / 1e6;
+            other -= min(other, entry.phases[phase]);
+        }
+        out << ", other " << other / 1e6 << " ms" << endl;
+    }
+    out << defaultfloat << setprecision(6);
+}
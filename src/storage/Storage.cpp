@@ -2,8 +2,10 @@
 
 #include "../../include/storage/Storage.h"
 #include "../../include/models/File.h"
-#include "../../include/models/FileSystem.h"
+#include "../../include/models/Session.h"
 #include "../../include/models/Folder.h"
+#include "../../include/storage/Trace.h"
+#include "../../include/storage/SlowCommandLog.h"
 
 #include <vector>
 #include <string>
@@ -11,275 +13,1178 @@
 #include <iostream>
 #include <stack>
 #include <queue>
+#include <mutex>
+#include <algorithm>
+#include <unordered_map>
 using namespace std;
 
-Storage *Storage::instance = nullptr;
+// Storages whose writer mutex the current thread holds
+static thread_local vector<const Storage *> heldWriteLocks;
 
-Storage *Storage::getInstance()
+Storage::ReadGuard::ReadGuard(const Storage &store) : epoch(store.epochs) {}
+
+Storage::WriteGuard::WriteGuard(const Storage &store) : locked(nullptr)
 {
-    if (instance == nullptr)
+    if (find(heldWriteLocks.begin(), heldWriteLocks.end(), &store) != heldWriteLocks.end())
+        return;
+    // Only a contended lock is timed
+    if (!store.writeMutex.try_lock())
     {
-        return instance = new Storage();
+        SlowCommandLog::PhaseTimer waiting(SlowCommandLog::LOCK_WAIT);
+        store.writeMutex.lock();
     }
-    return instance;
+    heldWriteLocks.push_back(&store);
+    locked = &store;
+}
+
+Storage::WriteGuard::~WriteGuard()
+{
+    if (!locked)
+        return;
+    locked->blobs.drainRetired(locked->epochs);
+    locked->epochs.collect();
+    heldWriteLocks.erase(find(heldWriteLocks.begin(), heldWriteLocks.end(), locked));
+    locked->writeMutex.unlock();
 }
 
-Storage::Storage()
+Storage::Storage() : nextFolderIndex(0), nextFileIndex(0), nextVersion(0), names(epochs), pathGeneration(0), ioBackend(new SyncIoBackend()), journal(nullptr), compactorStopping(false)
 {
-    fileSystem = new FileSystem();
-    fileSystem->addFolderId("F0");
-    folders["F0"] = nullptr;
-    map<string, int> temp;
-    tree["F0"] = temp;
-    Folder *f = new Folder("F" + to_string(folders.size()), "BaseFolder", "FX");
-    fileSystem->addFolderId("F0");
-    fileSystem->addFolderId("F1");
-    folders[f->getId()] = f;
+    // Index 0 is the unused sentinel "F0"; the root folder is F1
+    tree.set(0, new ChildList());
+    nextFolderIndex = 1;
+    Folder *f = new Folder(getNewFolderId(), "BaseFolder", "FX");
+    usage.set(nextFolderIndex, new FolderUsage());
+    folders.set(nextFolderIndex++, f);
 }
 
-void Storage::addContent(string fileName, string content)
+Storage::~Storage()
 {
-    string currentFolderId = getCurrentFolderId();
-    if (validateFile(fileName))
+    if (compactor.joinable())
     {
-        for (auto i : tree[currentFolderId])
         {
-            if (i.first[0] == 'f' && files[i.first]->getFileName() == fileName)
-            {
-                files[i.first]->setContent(content);
-            }
+            lock_guard<mutex> held(compactorMutex);
+            compactorStopping = true;
         }
+        compactorWake.notify_all();
+        compactor.join();
+    }
+    delete journal;
+    delete ioBackend;
+    for (size_t i = 0; i < folders.size(); i++)
+        delete folders.get(i);
+    for (size_t i = 0; i < usage.size(); i++)
+        delete usage.get(i);
+    for (size_t i = 0; i < files.size(); i++)
+        delete files.get(i);
+    for (size_t i = 0; i < tree.size(); i++)
+        delete tree.get(i);
+}
+
+string Storage::getRootFolderId() { return "F1"; }
+
+Session Storage::openSession(ostream &out)
+{
+    return Session(getRootFolderId(), getPath(getRootFolderId()), out);
+}
+
+bool Storage::parseId(const string &id, char kind, size_t &index)
+{
+    if (id.size() < 2 || id[0] != kind)
+        return false;
+    index = 0;
+    for (size_t i = 1; i < id.size(); i++)
+    {
+        if (id[i] < '0' || id[i] > '9')
+            return false;
+        index = index * 10 + (id[i] - '0');
+    }
+    return true;
+}
+
+Folder *Storage::findFolder(const string &id) const
+{
+    size_t index;
+    return parseId(id, 'F', index) ? folders.get(index) : nullptr;
+}
+
+File *Storage::findFile(const string &id) const
+{
+    size_t index;
+    return parseId(id, 'f', index) ? files.get(index) : nullptr;
+}
+
+const ChildList *Storage::findChildren(const string &folderId) const
+{
+    size_t index;
+    return parseId(folderId, 'F', index) ? tree.get(index) : nullptr;
+}
+
+void Storage::publishChildren(const string &folderId, ChildList *children)
+{
+    size_t index;
+    if (!parseId(folderId, 'F', index))
+    {
+        delete children;
+        return;
     }
+    children->version = ++nextVersion;
+    const ChildList *old = tree.get(index);
+    tree.set(index, children);
+    epochs.retire(old);
 }
 
-string Storage::getNewFileId() { return "f" + to_string(files.size()); }
+size_t Storage::currentFolderIndex(Session &session) const
+{
+    // Falls back to the root if another session removed the current folder
+    size_t index;
+    if (parseId(session.getCurrentFolderId(), 'F', index) && folders.get(index))
+        return index;
+    return ROOT_INDEX;
+}
 
-void Storage::addFile(string name, string folderId)
+bool Storage::lookupChild(Session &session, size_t folderIndex, string_view name, char kind, size_t &child) const
 {
-    for (auto i : tree[folderId])
+    const ChildList *children = tree.get(folderIndex);
+    if (!children)
+        return false;
+    SlowCommandLog::touch(1);
+    DentryCache &cache = session.getDentries();
+    DentryCache::Entry &entry = cache.slotFor(folderIndex, name);
+    if (DentryCache::matches(entry, folderIndex, children->version, name))
+    {
+        cache.recordHit();
+    }
+    else
     {
-        if (i.first[0] == 'f' && files[i.first]->getFileName() == name)
+        // One search of the name index fills in both the folder and the
+        // file with this name
+        cache.recordMiss();
+        entry.parent = folderIndex;
+        entry.version = children->version;
+        entry.name.assign(name);
+        entry.folder = DentryCache::NONE;
+        entry.file = DentryCache::NONE;
+        auto named = children->named(name);
+        for (; named != children->byName.end() && named->name == name; ++named)
         {
-            cout << "     " << "File name already exist! change the name of the file." << endl;
-            return;
+            SlowCommandLog::touch(1);
+            size_t index;
+            if (parseId(named->id, 'F', index) && folders.get(index))
+                entry.folder = index;
+            else if (parseId(named->id, 'f', index) && files.get(index))
+                entry.file = index;
         }
     }
-    string newFileId = getNewFileId();
-    File *f = new File(newFileId, name, folderId);
-    files[newFileId] = f;
-    tree[folderId][newFileId] = 1;
-    cout << "     " << "File created! File name = " + name + ", id =" + f->getId() + ", in folder id - " << folderId << endl;
+    child = kind == 'F' ? entry.folder : entry.file;
+    return child != DentryCache::NONE;
 }
 
-string Storage::getNewFolderId() { return "F" + to_string(folders.size()); }
+bool Storage::resolveFolderIndex(Session &session, size_t baseIndex, string_view path, size_t &folderIndex) const
+{
+    SlowCommandLog::PhaseTimer resolving(SlowCommandLog::RESOLVE);
+    size_t current = (!path.empty() && path[0] == '/') ? ROOT_INDEX : baseIndex;
+    size_t start = 0;
+    while (start <= path.size())
+    {
+        size_t end = path.find('/', start);
+        if (end == string_view::npos)
+            end = path.size();
+        string_view part = path.substr(start, end - start);
+        if (part == "..")
+        {
+            // The root is its own parent
+            Folder *folder = folders.get(current);
+            size_t parent;
+            if (folder && current != ROOT_INDEX && parseId(folder->getParentId(), 'F', parent))
+                current = parent;
+        }
+        else if (!part.empty() && part != ".")
+        {
+            if (!lookupChild(session, current, part, 'F', current))
+                return false;
+        }
+        start = end + 1;
+    }
+    if (!folders.get(current))
+        return false;
+    folderIndex = current;
+    return true;
+}
+
+bool Storage::resolveParentIndex(Session &session, size_t baseIndex, string_view path, size_t &folderIndex, string &leaf) const
+{
+    size_t slash = path.rfind('/');
+    string_view directory = slash == string_view::npos ? string_view() : path.substr(0, slash == 0 ? 1 : slash);
+    string_view name = slash == string_view::npos ? path : path.substr(slash + 1);
+    if (name.empty() || name == "." || name == "..")
+        return false;
+    if (!resolveFolderIndex(session, baseIndex, directory, folderIndex))
+        return false;
+    leaf.assign(name);
+    return true;
+}
 
-void Storage::addFolder(string name, string parentFolderId)
+string Storage::absolutePath(size_t folderIndex, const string &leaf) const
 {
-    for (auto i : tree[parentFolderId])
+    string path = "/" + leaf;
+    size_t index = folderIndex;
+    while (index != ROOT_INDEX)
     {
-        if (i.first[0] == 'F' && folders[i.first]->getName() == name)
+        Folder *folder = folders.get(index);
+        if (!folder || !parseId(folder->getParentId(), 'F', index))
+            break;
+        path = "/" + folder->getName() + path;
+    }
+    return path;
+}
+
+void Storage::addUsage(size_t folderIndex, int64_t bytes, int64_t files, int64_t subfolders)
+{
+    size_t index = folderIndex;
+    while (true)
+    {
+        // Unsigned wrap-around makes adding a negative delta a subtraction
+        if (FolderUsage *totals = usage.get(index))
         {
-            cout << "     " << "Folder name already exist! change the name of the folder." << endl;
-            return;
+            totals->bytes.fetch_add(uint64_t(bytes), memory_order_relaxed);
+            totals->files.fetch_add(uint64_t(files), memory_order_relaxed);
+            totals->folders.fetch_add(uint64_t(subfolders), memory_order_relaxed);
         }
+        Folder *folder = folders.get(index);
+        if (index == ROOT_INDEX || !folder || !parseId(folder->getParentId(), 'F', index))
+            break;
+    }
+}
+
+uint64_t Storage::contentSize(const File *file)
+{
+    // The blob records the size, so cold contents are not decompressed
+    const Blob *blob = file ? file->getBlob() : nullptr;
+    return blob ? blob->size : 0;
+}
+
+bool Storage::getUsage(const string &folderId, UsageTotals &totals)
+{
+    ReadGuard guard(*this);
+    size_t index;
+    FolderUsage *found = parseId(folderId, 'F', index) && folders.get(index) ? usage.get(index) : nullptr;
+    if (!found)
+        return false;
+    totals.bytes = found->bytes.load(memory_order_relaxed);
+    totals.files = found->files.load(memory_order_relaxed);
+    totals.folders = found->folders.load(memory_order_relaxed);
+    return true;
+}
+
+string Storage::resolveFolder(Session &session, string path)
+{
+    ReadGuard guard(*this);
+    size_t index;
+    if (!resolveFolderIndex(session, currentFolderIndex(session), path, index))
+        return "";
+    return "F" + to_string(index);
+}
+
+string Storage::resolveFile(Session &session, string path)
+{
+    ReadGuard guard(*this);
+    size_t parent, index;
+    string leaf;
+    if (!resolveParentIndex(session, currentFolderIndex(session), path, parent, leaf) ||
+        !lookupChild(session, parent, leaf, 'f', index))
+        return "";
+    return "f" + to_string(index);
+}
+
+void Storage::addContent(Session &session, string fileName, string content)
+{
+    // Hashing and deduplication happen before the writer lock is taken
+    const Blob *blob = blobs.intern(move(content));
+    WriteGuard guard(*this);
+    size_t index;
+    if (!parseId(resolveFile(session, fileName), 'f', index))
+    {
+        blobs.release(blob);
+        return;
+    }
+    // Readers may be scanning the old content, so publish a copy
+    File *file = files.get(index);
+    File *updated = new File(*file);
+    updated->setContent(blob);
+    files.set(index, updated);
+    epochs.retire(file);
+    size_t parent;
+    if (!parseId(file->getFolderId(), 'F', parent))
+        return;
+    addUsage(parent, int64_t(contentSize(updated)) - int64_t(contentSize(file)), 0, 0);
+    if (journal)
+        journal->append(Journal::WRITE, absolutePath(parent, file->getFileName()), *updated->getContent());
+}
+
+string Storage::getNewFileId() { return "f" + to_string(nextFileIndex); }
+
+void Storage::addFile(Session &session, string name, string folderId)
+{
+    WriteGuard guard(*this);
+    ostream &out = session.getOutput();
+    size_t base, parent, existing;
+    string leaf;
+    if (!parseId(folderId, 'F', base) || !resolveParentIndex(session, base, name, parent, leaf))
+    {
+        out << "     " << "No such folder for file " << name << endl;
+        return;
+    }
+    if (lookupChild(session, parent, leaf, 'f', existing))
+    {
+        out << "     " << "File name already exist! change the name of the file." << endl;
+        return;
+    }
+    string parentId = "F" + to_string(parent);
+    string newFileId = getNewFileId();
+    File *f = new File(newFileId, leaf, parentId);
+    names.add(leaf, 'f', nextFileIndex, f->getExtension());
+    files.set(nextFileIndex++, f);
+    const ChildList *children = tree.get(parent);
+    publishChildren(parentId, children ? children->with(newFileId, leaf) : ChildList().with(newFileId, leaf));
+    addUsage(parent, 0, 1, 0);
+    if (journal)
+        journal->append(Journal::CREATE_FILE, absolutePath(parent, leaf));
+    out << "     " << "File created! File name = " + leaf + ", id =" + f->getId() + ", in folder id - " << parentId << endl;
+}
+
+string Storage::getNewFolderId() { return "F" + to_string(nextFolderIndex); }
+
+void Storage::addFolder(Session &session, string name, string parentFolderId)
+{
+    WriteGuard guard(*this);
+    ostream &out = session.getOutput();
+    size_t base, parent, existing;
+    string leaf;
+    if (!parseId(parentFolderId, 'F', base) || !resolveParentIndex(session, base, name, parent, leaf))
+    {
+        out << "     " << "No such folder for folder " << name << endl;
+        return;
     }
+    if (lookupChild(session, parent, leaf, 'F', existing))
+    {
+        out << "     " << "Folder name already exist! change the name of the folder." << endl;
+        return;
+    }
+    string parentId = "F" + to_string(parent);
     string newFolderId = getNewFolderId();
-    Folder *f = new Folder(newFolderId, name, parentFolderId);
-    folders[newFolderId] = f;
-    tree[parentFolderId][newFolderId] = 1;
-    cout << "     " << "New folder created! Name = " << name << " id = " << f->getId() << endl;
+    Folder *f = new Folder(newFolderId, leaf, parentId);
+    usage.set(nextFolderIndex, new FolderUsage());
+    names.add(leaf, 'F', nextFolderIndex, NameIndex::extensionOf(leaf));
+    folders.set(nextFolderIndex++, f);
+    const ChildList *children = tree.get(parent);
+    publishChildren(parentId, children ? children->with(newFolderId, leaf) : ChildList().with(newFolderId, leaf));
+    addUsage(parent, 0, 0, 1);
+    if (journal)
+        journal->append(Journal::CREATE_FOLDER, absolutePath(parent, leaf));
+    out << "     " << "New folder created! Name = " << leaf << " id = " << f->getId() << endl;
 }
 
 Folder *Storage::getFolder(string id)
 {
-    return folders[id];
+    ReadGuard guard(*this);
+    return findFolder(id);
 }
 
 File *Storage::getFile(string id)
 {
-    return files[id];
+    ReadGuard guard(*this);
+    return findFile(id);
+}
+
+const ChildList *Storage::getChildren(const string &folderId)
+{
+    ReadGuard guard(*this);
+    return findChildren(folderId);
 }
 
 string Storage::getPath(string id)
 {
-    Folder *f = folders[id];
+    TraceSpan span("storage", "getPath");
+    ReadGuard guard(*this);
+    Folder *f = findFolder(id);
     string path = "";
     while (f && f->getParentId() != "F0")
     {
         path = "/" + path;
         path = f->getName() + path;
-        f = folders[f->getParentId()];
+        f = findFolder(f->getParentId());
+        SlowCommandLog::touch(1);
     }
     return path;
 }
 
-void Storage::showFolderPath(string id)
+void Storage::showFolderPath(Session &session, string id)
 {
+    ostream &out = session.getOutput();
     string path = getPath(id);
-    cout << path << endl;
+    out << path << endl;
 }
 
-void Storage::showFilePath(string id)
+void Storage::showFilePath(Session &session, string id)
 {
+    ostream &out = session.getOutput();
     string path = getPath(id);
-    cout << path << endl;
+    out << path << endl;
 }
 
-string Storage::getCurrentFolderId() { return fileSystem->getCurrentFolder(); }
-
-void Storage::showItemsInFolder(string folderId)
+void Storage::showItemsInFolder(Session &session, string folderId)
 {
-    if (folders.count(folderId) && folders[folderId])
+    ReadGuard guard(*this);
+    ostream &out = session.getOutput();
+    if (findFolder(folderId))
     {
-        for (auto i : tree[folderId])
+        const ChildList *children = findChildren(folderId);
+        if (!children)
+            return;
+        SlowCommandLog::touch(children->ids.size());
+        // A concurrent remove may already have cleared an entry we still list
+        for (const string &id : children->ids)
         {
-            if (i.first[0] == 'f')
-                cout << "     " << files[i.first]->getFileName() << endl;
-            else
-                cout << "     " << folders[i.first]->getName() << endl;
+            if (File *file = id[0] == 'f' ? findFile(id) : nullptr)
+                out << "     " << file->getFileName() << endl;
+            else if (Folder *folder = id[0] == 'F' ? findFolder(id) : nullptr)
+                out << "     " << folder->getName() << endl;
         }
     }
     else
-        cout << "     " << "Folder does not exist." << endl;
+        out << "     " << "Folder does not exist." << endl;
+}
+
+vector<ChildList::Named> Storage::matchChildren(size_t folderIndex, const GlobPattern &glob, char kind) const
+{
+    vector<ChildList::Named> matches;
+    const ChildList *children = tree.get(folderIndex);
+    if (!children)
+        return matches;
+    // Only names that start with the literal prefix can match
+    auto range = children->withPrefix(glob.literalPrefix());
+    for (auto child = range.first; child != range.second; ++child)
+    {
+        SlowCommandLog::touch(1);
+        size_t index;
+        if (kind && child->id[0] != kind)
+            continue;
+        if (!glob.matches(child->name))
+            continue;
+        // A concurrent remove may already have cleared an entry we still see
+        if (parseId(child->id, 'F', index) ? folders.get(index) != nullptr : parseId(child->id, 'f', index) && files.get(index))
+            matches.push_back(*child);
+    }
+    return matches;
+}
+
+size_t Storage::showMatchingItems(Session &session, string pattern)
+{
+    ReadGuard guard(*this);
+    ostream &out = session.getOutput();
+    size_t parent;
+    string leaf;
+    if (!resolveParentIndex(session, currentFolderIndex(session), pattern, parent, leaf))
+    {
+        out << "     " << "Folder does not exist." << endl;
+        return 0;
+    }
+    vector<ChildList::Named> matches = matchChildren(parent, GlobPattern(leaf), 0);
+    for (const ChildList::Named &child : matches)
+        out << "     " << child.name << endl;
+    return matches.size();
 }
 
-void Storage::getIntoFolder(string name)
+size_t Storage::locate(Session &session, string query)
 {
-    string currentFolderId = fileSystem->getCurrentFolder();
-    if (name != "..")
+    TraceSpan span("storage", "locate");
+    ReadGuard guard(*this);
+    ostream &out = session.getOutput();
+    size_t examined = 0, found = 0;
+    bool isGlob = GlobPattern::isGlob(query);
+    GlobPattern glob(query);
+    // Posting lists keep removed and renamed nodes until they are compacted,
+    // so a node is only printed if it still has the name it was listed under
+    auto print = [&](char kind, size_t index, const string &name)
     {
-        for (auto i : tree[currentFolderId])
+        size_t parent;
+        examined++;
+        Folder *folder = kind == 'F' ? folders.get(index) : nullptr;
+        File *file = kind == 'f' ? files.get(index) : nullptr;
+        if (folder ? folder->getName() != name : !file || file->getFileName() != name)
+            return true;
+        if (parseId(folder ? folder->getParentId() : file->getFolderId(), 'F', parent))
         {
-            if (i.first[0] == 'F' && folders[i.first]->getName() == name)
-            {
-                fileSystem->addFolderId(i.first);
-                return;
-            }
+            out << "     " << absolutePath(parent, name) << '\n';
+            found++;
         }
+        return true;
+    };
+    // A glob is tested once per distinct name, not once per node
+    NameIndex::PostingVisitor byName = [&](const NameIndex::Posting &posting)
+    {
+        if (isGlob && !glob.matches(posting.key))
+            return true;
+        return NameIndex::forEachNode(posting, [&](char kind, size_t index)
+                                      { return print(kind, index, posting.key); });
+    };
+    const string &suffix = glob.literalSuffix();
+    size_t dot = suffix.rfind('.');
+    if (!isGlob || !glob.literalPrefix().empty())
+        names.forEachName(isGlob ? glob.literalPrefix() : query, byName);
+    else if (dot != string::npos && dot + 1 < suffix.size())
+    {
+        // A literal suffix with a dot ("*.tar.gz") pins down the extension,
+        // whose posting list (files and folders) is read instead of every name
+        names.forEachExtension(string_view(suffix).substr(dot + 1), [&](const NameIndex::Posting &posting)
+                               {
+                                   return NameIndex::forEachNode(posting, [&](char kind, size_t index)
+                                                                 {
+                                                                     Folder *folder = kind == 'F' ? folders.get(index) : nullptr;
+                                                                     File *file = kind == 'f' ? files.get(index) : nullptr;
+                                                                     if (!folder && !file)
+                                                                         return true;
+                                                                     string name = folder ? folder->getName() : file->getFileName();
+                                                                     if (NameIndex::extensionOf(name) != posting.key)
+                                                                         return true;
+                                                                     return !glob.matches(name) || print(kind, index, name);
+                                                                 }); });
     }
-    else if (!fileSystem->checkEmpty())
+    else
+        names.forEachName("", byName);
+    SlowCommandLog::touch(examined);
+    if (found == 0)
+        out << "     " << "No matches found." << endl;
+    out << flush;
+    return found;
+}
+
+size_t Storage::removeMatchingFiles(Session &session, string pattern)
+{
+    WriteGuard guard(*this);
+    ostream &out = session.getOutput();
+    size_t parent;
+    string leaf;
+    vector<ChildList::Named> matches;
+    if (resolveParentIndex(session, currentFolderIndex(session), pattern, parent, leaf))
+        matches = matchChildren(parent, GlobPattern(leaf), 'f');
+    if (matches.empty())
     {
-        fileSystem->removeCurrentFolder();
-        return;
+        out << "     " << "No files match " << pattern << endl;
+        return 0;
     }
-    cout << "     " << "Wrong file name, no file exists with name " << name << endl;
+    // Unlink them all before clearing the slots so new readers never see the ids
+    publishChildren("F" + to_string(parent), tree.get(parent)->without(matches));
+    int64_t bytes = 0;
+    for (const ChildList::Named &child : matches)
+    {
+        size_t index = 0;
+        if (!parseId(child.id, 'f', index))
+            continue;
+        File *file = files.get(index);
+        bytes += contentSize(file);
+        files.set(index, nullptr);
+        names.remove(child.name, 'f', index, file->getExtension());
+        epochs.retire(file);
+        if (journal)
+            journal->append(Journal::REMOVE_FILE, absolutePath(parent, child.name));
+    }
+    addUsage(parent, -bytes, -int64_t(matches.size()), 0);
+    out << "     " << matches.size() << (matches.size() == 1 ? " file" : " files") << " removed." << endl;
+    return matches.size();
 }
 
-bool Storage::validateFolder(string folderName)
+size_t Storage::removeMatchingFolders(Session &session, string pattern)
 {
-    string currentFolderId = fileSystem->getCurrentFolder();
-    for (auto i : tree[currentFolderId])
+    WriteGuard guard(*this);
+    ostream &out = session.getOutput();
+    size_t base = currentFolderIndex(session);
+    size_t parent;
+    string leaf;
+    vector<ChildList::Named> matches;
+    if (resolveParentIndex(session, base, pattern, parent, leaf))
+        matches = matchChildren(parent, GlobPattern(leaf), 'F');
+    if (matches.empty())
     {
-        if (i.first[0] == 'F' && folders[i.first]->getName() == folderName)
+        out << "     " << "No folders match " << pattern << endl;
+        return 0;
+    }
+    for (const ChildList::Named &child : matches)
+    {
+        size_t index;
+        if (parseId(child.id, 'F', index) && isWithin(base, index))
         {
-            return true;
+            out << "     " << "The current folder or a folder above it cannot be removed." << endl;
+            return 0;
         }
     }
-    return false;
+    publishChildren("F" + to_string(parent), tree.get(parent)->without(matches));
+    // As in removeFolder: the subtrees leave the ancestors' totals at once,
+    // then removeDFS frees the nodes
+    int64_t bytes = 0, fileCount = 0, folderCount = 0;
+    for (const ChildList::Named &child : matches)
+    {
+        size_t index = 0;
+        if (!parseId(child.id, 'F', index))
+            continue;
+        FolderUsage *subtree = usage.get(index);
+        bytes += subtree->bytes.load(memory_order_relaxed);
+        fileCount += subtree->files.load(memory_order_relaxed);
+        folderCount += subtree->folders.load(memory_order_relaxed) + 1;
+        if (journal)
+            journal->append(Journal::REMOVE_FOLDER, absolutePath(parent, child.name));
+    }
+    addUsage(parent, -bytes, -fileCount, -folderCount);
+    for (const ChildList::Named &child : matches)
+        removeDFS(session, child.id);
+    pathGeneration.fetch_add(1);
+    out << "     " << matches.size() << (matches.size() == 1 ? " folder" : " folders") << " removed." << endl;
+    return matches.size();
 }
 
-void Storage::removeFile(string fileName)
+void Storage::getIntoFolder(Session &session, string name)
 {
-    if (validateFile(fileName))
+    // Only the session changes, so this is a read of the shared tree
+    ReadGuard guard(*this);
+    ostream &out = session.getOutput();
+    size_t index;
+    if (resolveFolderIndex(session, currentFolderIndex(session), name, index))
     {
-        string currentFolderId = fileSystem->getCurrentFolder();
-        for (auto i : tree[currentFolderId])
+        // Taken before the path so a move in between makes it stale
+        uint64_t generation = pathGeneration.load();
+        string id = "F" + to_string(index);
+        session.setCurrentFolder(id, getPath(id), generation);
+        return;
+    }
+    out << "     " << "Wrong file name, no file exists with name " << name << endl;
+}
+
+bool Storage::validateFolder(Session &session, string folderName)
+{
+    return !resolveFolder(session, folderName).empty();
+}
+
+void Storage::removeFile(Session &session, string fileName)
+{
+    WriteGuard guard(*this);
+    ostream &out = session.getOutput();
+    size_t parent, index;
+    string leaf;
+    if (!resolveParentIndex(session, currentFolderIndex(session), fileName, parent, leaf) ||
+        !lookupChild(session, parent, leaf, 'f', index))
+        return;
+    // Unlink before clearing the slot so new readers never see the id
+    File *file = files.get(index);
+    publishChildren("F" + to_string(parent), tree.get(parent)->without({leaf, file->getId()}));
+    files.set(index, nullptr);
+    names.remove(leaf, 'f', index, file->getExtension());
+    epochs.retire(file);
+    addUsage(parent, -int64_t(contentSize(file)), -1, 0);
+    if (journal)
+        journal->append(Journal::REMOVE_FILE, absolutePath(parent, leaf));
+    out << "File removed successfully!" << endl;
+}
+
+void Storage::removeDFS(Session &session, string node)
+{
+    TraceSpan span("storage", "removeDFS");
+    WriteGuard guard(*this);
+    ostream &out = session.getOutput();
+    SlowCommandLog::touch(1);
+    if (const ChildList *children = findChildren(node))
+    {
+        for (const string &id : children->ids)
         {
-            if (i.first[0] == 'f' && files[i.first]->getFileName() == fileName)
+            if (id[0] == 'F')
             {
-                string fileId = files[i.first]->getId();
-                files.erase(fileId);
-                tree[currentFolderId].erase(fileId);
-                if (tree[currentFolderId].size() == 0)
-                    tree.erase(currentFolderId);
-                cout << "File removed successfully!" << endl;
-                return;
+                removeDFS(session, id);
+            }
+            else
+            {
+                SlowCommandLog::touch(1);
+                File *file = findFile(id);
+                out << "     " << "File id - " << file->getId() << " and name - " << file->getFileName() << " removed successfully!" << endl;
+                size_t index = 0;
+                if (!parseId(id, 'f', index))
+                    continue;
+                files.set(index, nullptr);
+                names.remove(file->getFileName(), 'f', index, file->getExtension());
+                epochs.retire(file);
             }
         }
     }
+    size_t index = 0;
+    if (!parseId(node, 'F', index))
+        return;
+    Folder *folder = folders.get(index);
+    out << "     " << "Folder id - " << folder->getId() << " and name - " << folder->getName() << " removed successfully!" << endl;
+    folders.set(index, nullptr);
+    names.remove(folder->getName(), 'F', index, NameIndex::extensionOf(folder->getName()));
+    epochs.retire(folder);
+    epochs.retire(tree.get(index));
+    tree.set(index, nullptr);
+    epochs.retire(usage.get(index));
+    usage.set(index, nullptr);
 }
 
-void Storage::removeDFS(string node)
+void Storage::removeFolder(Session &session, string folderName)
 {
-    for (auto i : tree[node])
+    WriteGuard guard(*this);
+    ostream &out = session.getOutput();
+    size_t index, parent;
+    if (!resolveFolderIndex(session, currentFolderIndex(session), folderName, index))
+        return;
+    if (index == ROOT_INDEX)
     {
-        if (i.first[0] == 'F')
-        {
-            removeDFS(i.first);
-        }
+        out << "     " << "The root folder cannot be removed." << endl;
+        return;
+    }
+    if (isWithin(currentFolderIndex(session), index))
+    {
+        out << "     " << "The current folder or a folder above it cannot be removed." << endl;
+        return;
+    }
+    // Unlink first so readers stop reaching the subtree, then free it
+    Folder *folder = folders.get(index);
+    string folderId = folder->getId();
+    if (parseId(folder->getParentId(), 'F', parent))
+    {
+        if (journal)
+            journal->append(Journal::REMOVE_FOLDER, absolutePath(parent, folder->getName()));
+        publishChildren(folder->getParentId(), tree.get(parent)->without({folder->getName(), folderId}));
+        // The whole subtree leaves the ancestors' totals at once; removeDFS
+        // then only frees the per-folder entries
+        FolderUsage *removed = usage.get(index);
+        addUsage(parent, -int64_t(removed->bytes.load(memory_order_relaxed)),
+                 -int64_t(removed->files.load(memory_order_relaxed)),
+                 -int64_t(removed->folders.load(memory_order_relaxed)) - 1);
+    }
+    removeDFS(session, folderId);
+    // Another session standing in the subtree now falls back to the root
+    pathGeneration.fetch_add(1);
+    out << "     Folder removed successfully!" << endl;
+}
+
+bool Storage::isWithin(size_t folderIndex, size_t ancestor) const
+{
+    for (size_t above = folderIndex;;)
+    {
+        if (above == ancestor)
+            return true;
+        Folder *folder = folders.get(above);
+        if (above == ROOT_INDEX || !folder || !parseId(folder->getParentId(), 'F', above))
+            return false;
+    }
+}
+
+bool Storage::moveNode(Session &session, char kind, size_t index, size_t parent, size_t target, const string &name)
+{
+    ostream &out = session.getOutput();
+    Folder *folder = kind == 'F' ? folders.get(index) : nullptr;
+    File *file = kind == 'f' ? files.get(index) : nullptr;
+    string oldName = folder ? folder->getName() : file->getFileName();
+    if (parent == target && name == oldName)
+        return true;
+    size_t existing;
+    if (lookupChild(session, target, name, kind, existing))
+    {
+        out << "     " << (folder ? "Folder" : "File") << " name already exist in the destination folder." << endl;
+        return false;
+    }
+    if (folder && isWithin(target, index))
+    {
+        out << "     " << "A folder cannot be moved into itself." << endl;
+        return false;
+    }
+    string id = folder ? folder->getId() : file->getId();
+    string parentId = "F" + to_string(parent);
+    string targetId = "F" + to_string(target);
+    string from = journal ? absolutePath(parent, oldName) : "";
+
+    // The subtree's totals leave the old ancestors and join the new ones
+    int64_t bytes, fileCount, folderCount;
+    if (folder)
+    {
+        FolderUsage *subtree = usage.get(index);
+        bytes = subtree->bytes.load(memory_order_relaxed);
+        fileCount = subtree->files.load(memory_order_relaxed);
+        folderCount = subtree->folders.load(memory_order_relaxed) + 1;
+    }
+    else
+    {
+        bytes = contentSize(file);
+        fileCount = 1;
+        folderCount = 0;
+    }
+    addUsage(parent, -bytes, -fileCount, -folderCount);
+
+    // Only this node is replaced; its children keep pointing at its id
+    if (folder)
+    {
+        folders.set(index, new Folder(id, name, targetId));
+        epochs.retire(folder);
+        names.remove(oldName, 'F', index, NameIndex::extensionOf(oldName));
+        names.add(name, 'F', index, NameIndex::extensionOf(name));
+        pathGeneration.fetch_add(1);
+    }
+    else
+    {
+        File *moved = new File(id, name, targetId);
+        const Blob *blob = file->getBlob();
+        moved->setContent(blob ? blob->store->retain(blob) : nullptr);
+        files.set(index, moved);
+        epochs.retire(file);
+        names.remove(oldName, 'f', index, file->getExtension());
+        names.add(name, 'f', index, moved->getExtension());
+    }
+
+    // Linked under the new parent before it is unlinked from the old one, so
+    // a concurrent walk may briefly see it twice but never loses it
+    const ChildList *targetChildren = tree.get(target);
+    if (parent == target)
+    {
+        ChildList *unlinked = targetChildren->without({oldName, id});
+        publishChildren(targetId, unlinked->with(id, name));
+        delete unlinked;
+    }
+    else
+    {
+        publishChildren(targetId, targetChildren ? targetChildren->with(id, name) : ChildList().with(id, name));
+        publishChildren(parentId, tree.get(parent)->without({oldName, id}));
+    }
+    addUsage(target, bytes, fileCount, folderCount);
+    if (journal)
+        journal->append(folder ? Journal::MOVE_FOLDER : Journal::MOVE_FILE, from, absolutePath(target, name));
+    return true;
+}
+
+void Storage::moveItem(Session &session, string source, string destination)
+{
+    TraceSpan span("storage", "moveItem");
+    WriteGuard guard(*this);
+    ostream &out = session.getOutput();
+    size_t base = currentFolderIndex(session);
+    size_t parent, index, target;
+    string leaf, name;
+    char kind = 'F';
+    if (!resolveParentIndex(session, base, source, parent, leaf) ||
+        (!lookupChild(session, parent, leaf, 'F', index) && !lookupChild(session, parent, leaf, kind = 'f', index)))
+    {
+        out << "     " << "No such file or folder " << source << endl;
+        return;
+    }
+    // Into an existing folder under the same name, or to a new path
+    if (resolveFolderIndex(session, base, destination, target))
+        name = leaf;
+    else if (!resolveParentIndex(session, base, destination, target, name))
+    {
+        out << "     " << "No such folder for " << destination << endl;
+        return;
+    }
+    if (moveNode(session, kind, index, parent, target, name))
+        out << "     " << (kind == 'F' ? "Folder" : "File") << " moved to " << absolutePath(target, name) << endl;
+}
+
+void Storage::renameItem(Session &session, char kind, string source, string destination)
+{
+    WriteGuard guard(*this);
+    size_t base = currentFolderIndex(session);
+    size_t parent, index, target;
+    string leaf, name;
+    if (resolveParentIndex(session, base, source, parent, leaf) && lookupChild(session, parent, leaf, kind, index) &&
+        resolveParentIndex(session, base, destination, target, name))
+        moveNode(session, kind, index, parent, target, name);
+}
+
+File *Storage::cloneFile(const File *file, const string &name, const string &folderId)
+{
+    SlowCommandLog::touch(1);
+    File *copy = new File(getNewFileId(), name, folderId);
+    const Blob *blob = file->getBlob();
+    copy->setContent(blob ? blob->store->retain(blob) : nullptr);
+    names.add(name, 'f', nextFileIndex, copy->getExtension());
+    files.set(nextFileIndex++, copy);
+    return copy;
+}
+
+size_t Storage::cloneFolder(size_t source, const string &name, const string &parentId)
+{
+    SlowCommandLog::touch(1);
+    size_t index = nextFolderIndex++;
+    string id = "F" + to_string(index);
+    // The totals below the copy are the source's
+    FolderUsage *from = usage.get(source), *totals = new FolderUsage();
+    totals->bytes.store(from->bytes.load(memory_order_relaxed), memory_order_relaxed);
+    totals->files.store(from->files.load(memory_order_relaxed), memory_order_relaxed);
+    totals->folders.store(from->folders.load(memory_order_relaxed), memory_order_relaxed);
+    usage.set(index, totals);
+    folders.set(index, new Folder(id, name, parentId));
+    names.add(name, 'F', index, NameIndex::extensionOf(name));
+    const ChildList *children = tree.get(source);
+    if (!children)
+        return index;
+    // Built whole and published once; nobody can reach it before the copy
+    // is linked into its destination
+    vector<ChildList::Named> copied;
+    copied.reserve(children->byName.size());
+    for (const ChildList::Named &child : children->byName)
+    {
+        size_t childIndex;
+        string childId;
+        if (parseId(child.id, 'F', childIndex))
+            childId = "F" + to_string(cloneFolder(childIndex, child.name, id));
         else
-        {
-            cout << "     " << "File id - " << files[i.first]->getId() << " and name - " << files[i.first]->getFileName() << " removed successfully!" << endl;
-            files[i.first] = nullptr;
-        }
+            childId = cloneFile(findFile(child.id), child.name, id)->getId();
+        copied.push_back({child.name, childId});
     }
-    cout << "     " << "Folder id - " << folders[node]->getId() << " and name - " << folders[node]->getName() << " removed successfully!" << endl;
-    folders[node] = nullptr;
-    tree.erase(node);
+    publishChildren(id, new ChildList(move(copied)));
+    return index;
 }
 
-void Storage::removeFolder(string folderName)
+bool Storage::copyNode(Session &session, char kind, size_t index, size_t parent, size_t target, const string &name)
 {
-    if (validateFolder(folderName))
+    ostream &out = session.getOutput();
+    size_t existing;
+    if (lookupChild(session, target, name, kind, existing))
     {
-        string currentFolderId = fileSystem->getCurrentFolder();
-        for (auto i : tree[currentFolderId])
-        {
-            if (i.first[0] == 'F' && folders[i.first]->getName() == folderName)
-            {
-                string folderId = folders[i.first]->getId();
-                string parFolderId = folders[i.first]->getParentId();
-                tree[parFolderId].erase(folderId);
-                removeDFS(folderId);
-                cout << "     Folder removed successfully!" << endl;
-                return;
-            }
-        }
+        out << "     " << (kind == 'F' ? "Folder" : "File") << " name already exist in the destination folder." << endl;
+        return false;
+    }
+    if (kind == 'F' && isWithin(target, index))
+    {
+        out << "     " << "A folder cannot be copied into itself." << endl;
+        return false;
+    }
+    string targetId = "F" + to_string(target);
+    string id;
+    int64_t bytes, fileCount, folderCount;
+    if (kind == 'F')
+    {
+        size_t copy = cloneFolder(index, name, targetId);
+        id = "F" + to_string(copy);
+        FolderUsage *subtree = usage.get(copy);
+        bytes = subtree->bytes.load(memory_order_relaxed);
+        fileCount = subtree->files.load(memory_order_relaxed);
+        folderCount = subtree->folders.load(memory_order_relaxed) + 1;
     }
+    else
+    {
+        File *copy = cloneFile(files.get(index), name, targetId);
+        id = copy->getId();
+        bytes = contentSize(copy);
+        fileCount = 1;
+        folderCount = 0;
+    }
+    const ChildList *targetChildren = tree.get(target);
+    publishChildren(targetId, targetChildren ? targetChildren->with(id, name) : ChildList().with(id, name));
+    addUsage(target, bytes, fileCount, folderCount);
+    if (journal)
+    {
+        const string &oldName = kind == 'F' ? folders.get(index)->getName() : files.get(index)->getFileName();
+        journal->append(kind == 'F' ? Journal::COPY_FOLDER : Journal::COPY_FILE, absolutePath(parent, oldName),
+                        absolutePath(target, name));
+    }
+    return true;
 }
 
-void Storage::showDFS(string node, string symbols)
+void Storage::copyItem(Session &session, string source, string destination, bool recursive)
 {
-    cout << "     " << symbols + "- " << ((node[0] == 'F') ? folders[node]->getName() : files[node]->getFileName()) << endl;
+    TraceSpan span("storage", "copyItem");
+    WriteGuard guard(*this);
+    ostream &out = session.getOutput();
+    size_t base = currentFolderIndex(session);
+    size_t parent, index, target;
+    string leaf, name;
+    char kind = 'F';
+    if (!resolveParentIndex(session, base, source, parent, leaf) ||
+        (!lookupChild(session, parent, leaf, 'F', index) && !lookupChild(session, parent, leaf, kind = 'f', index)))
+    {
+        out << "     " << "No such file or folder " << source << endl;
+        return;
+    }
+    if (kind == 'F' && !recursive)
+    {
+        out << "     " << source << " is a folder; use cp -r to copy it." << endl;
+        return;
+    }
+    if (resolveFolderIndex(session, base, destination, target))
+        name = leaf;
+    else if (!resolveParentIndex(session, base, destination, target, name))
+    {
+        out << "     " << "No such folder for " << destination << endl;
+        return;
+    }
+    if (copyNode(session, kind, index, parent, target, name))
+        out << "     " << (kind == 'F' ? "Folder" : "File") << " copied to " << absolutePath(target, name) << endl;
+}
+
+void Storage::duplicateItem(Session &session, char kind, string source, string destination)
+{
+    WriteGuard guard(*this);
+    size_t base = currentFolderIndex(session);
+    size_t parent, index, target;
+    string leaf, name;
+    if (resolveParentIndex(session, base, source, parent, leaf) && lookupChild(session, parent, leaf, kind, index) &&
+        resolveParentIndex(session, base, destination, target, name))
+        copyNode(session, kind, index, parent, target, name);
+}
+
+string Storage::currentPath(Session &session)
+{
+    uint64_t generation = pathGeneration.load();
+    if (session.getPathGeneration() != generation)
+    {
+        ReadGuard guard(*this);
+        string id = "F" + to_string(currentFolderIndex(session));
+        session.setCurrentFolder(id, getPath(id), generation);
+    }
+    return session.getCurrentPath();
+}
+
+void Storage::showDFS(Session &session, string node, string symbols)
+{
+    TraceSpan span("storage", "showDFS");
+    ReadGuard guard(*this);
+    ostream &out = session.getOutput();
+    Folder *folder = node[0] == 'F' ? findFolder(node) : nullptr;
+    File *file = node[0] == 'f' ? findFile(node) : nullptr;
+    if (!folder && !file)
+        return;
+    SlowCommandLog::touch(1);
+    out << "     " << symbols + "- " << (folder ? folder->getName() : file->getFileName()) << endl;
 
     symbols += "  |";
-    for (auto i : tree[node])
+    if (const ChildList *children = findChildren(node))
     {
-        showDFS(i.first, symbols);
+        for (const string &id : children->ids)
+        {
+            showDFS(session, id, symbols);
+        }
     }
 }
 
-void Storage::showFolderTree()
+void Storage::showFolderTree(Session &session)
 {
-    string currentFolderId = fileSystem->getCurrentFolder();
+    ReadGuard guard(*this);
     string symbols = "";
-    showDFS(currentFolderId, symbols);
+    showDFS(session, "F" + to_string(currentFolderIndex(session)), symbols);
+}
+
+bool Storage::validateFile(Session &session, string fileName)
+{
+    return !resolveFile(session, fileName).empty();
 }
 
-bool Storage::validateFile(string fileName)
+vector<string> Storage::insertBatch(string folderId, const vector<string> &folderNames,
+                                    vector<pair<string, string>> &newFiles, size_t &skippedFiles)
 {
-    string currentFolderId = fileSystem->getCurrentFolder();
-    for (auto i : tree[currentFolderId])
+    vector<const Blob *> contents;
+    contents.reserve(newFiles.size());
+    for (auto &entry : newFiles)
+        contents.push_back(blobs.intern(move(entry.second)));
+
+    WriteGuard guard(*this);
+    SlowCommandLog::touch(folderNames.size() + newFiles.size());
+    vector<string> ids(folderNames.size());
+    skippedFiles = 0;
+    size_t parent;
+    if (!parseId(folderId, 'F', parent) || !folders.get(parent))
+    {
+        for (const Blob *blob : contents)
+            blobs.release(blob);
+        skippedFiles = newFiles.size();
+        return ids;
+    }
+
+    // Existing names, only needed when merging into a non-empty folder
+    const ChildList *children = tree.get(parent);
+    unordered_map<string, string> existingFolders, existingFiles;
+    if (children)
+        for (const string &id : children->ids)
+        {
+            if (Folder *folder = id[0] == 'F' ? findFolder(id) : nullptr)
+                existingFolders[folder->getName()] = id;
+            else if (File *file = id[0] == 'f' ? findFile(id) : nullptr)
+                existingFiles[file->getFileName()] = id;
+        }
+
+    vector<ChildList::Named> added;
+    string path = journal ? absolutePath(parent, "") : "";
+    int64_t addedFolders = 0, addedFiles = 0, addedBytes = 0;
+    for (size_t i = 0; i < folderNames.size(); i++)
     {
-        if (i.first[0] == 'f' && files[i.first]->getFileName() == fileName)
+        auto existing = existingFolders.find(folderNames[i]);
+        if (existing != existingFolders.end())
         {
-            return true;
+            ids[i] = existing->second;
+            continue;
         }
+        ids[i] = getNewFolderId();
+        usage.set(nextFolderIndex, new FolderUsage());
+        names.add(folderNames[i], 'F', nextFolderIndex, NameIndex::extensionOf(folderNames[i]));
+        folders.set(nextFolderIndex++, new Folder(ids[i], folderNames[i], folderId));
+        addedFolders++;
+        added.push_back({folderNames[i], ids[i]});
+        if (journal)
+            journal->append(Journal::CREATE_FOLDER, path + folderNames[i]);
     }
-    return false;
+    for (size_t i = 0; i < newFiles.size(); i++)
+    {
+        const string &name = newFiles[i].first;
+        if (children && !existingFiles.emplace(name, "").second)
+        {
+            blobs.release(contents[i]);
+            skippedFiles++;
+            continue;
+        }
+        File *file = new File(getNewFileId(), name, folderId);
+        file->setContent(contents[i]);
+        if (journal)
+        {
+            journal->append(Journal::CREATE_FILE, path + name);
+            if (contents[i])
+                journal->append(Journal::WRITE, path + name, *file->getContent());
+        }
+        names.add(name, 'f', nextFileIndex, file->getExtension());
+        files.set(nextFileIndex++, file);
+        added.push_back({name, file->getId()});
+        addedFiles++;
+        addedBytes += contentSize(file);
+    }
+    addUsage(parent, addedBytes, addedFiles, addedFolders);
+    if (children && added.empty())
+        return ids;
+    // A batch smaller than a chunk is inserted into the shared chunks; a
+    // larger one rebuilds the list once instead
+    if (children && added.size() <= ChunkedList<string>::MAX_CHUNK)
+    {
+        ChildList *updated = new ChildList(*children);
+        for (const ChildList::Named &child : added)
+        {
+            updated->ids = updated->ids.inserted(child.id);
+            updated->byName = updated->byName.inserted(child);
+        }
+        publishChildren(folderId, updated);
+        return ids;
+    }
+    if (children)
+        added.insert(added.end(), children->byName.begin(), children->byName.end());
+    publishChildren(folderId, new ChildList(move(added)));
+    return ids;
 }
 
 // Grep support methods
 vector<string> Storage::getFileIdsInFolder(string folderId)
 {
+    ReadGuard guard(*this);
     vector<string> fileIds;
-    if (tree.find(folderId) != tree.end())
+    if (const ChildList *children = findChildren(folderId))
     {
-        for (auto i : tree[folderId])
+        for (const string &id : children->ids)
         {
-            if (i.first[0] == 'f')
+            if (id[0] == 'f')
             {
-                fileIds.push_back(i.first);
+                fileIds.push_back(id);
             }
         }
     }
@@ -288,14 +1193,15 @@ vector<string> Storage::getFileIdsInFolder(string folderId)
 
 vector<string> Storage::getFolderIdsInFolder(string folderId)
 {
+    ReadGuard guard(*this);
     vector<string> folderIds;
-    if (tree.find(folderId) != tree.end())
+    if (const ChildList *children = findChildren(folderId))
     {
-        for (auto i : tree[folderId])
+        for (const string &id : children->ids)
         {
-            if (i.first[0] == 'F')
+            if (id[0] == 'F')
             {
-                folderIds.push_back(i.first);
+                folderIds.push_back(id);
             }
         }
     }
@@ -304,13 +1210,15 @@ vector<string> Storage::getFolderIdsInFolder(string folderId)
 
 string Storage::getFileIdByName(string fileName, string folderId)
 {
-    if (tree.find(folderId) != tree.end())
+    ReadGuard guard(*this);
+    if (const ChildList *children = findChildren(folderId))
     {
-        for (auto i : tree[folderId])
+        for (const string &id : children->ids)
         {
-            if (i.first[0] == 'f' && files[i.first] && files[i.first]->getFileName() == fileName)
+            File *file = id[0] == 'f' ? findFile(id) : nullptr;
+            if (file && file->getFileName() == fileName)
             {
-                return i.first;
+                return id;
             }
         }
     }
@@ -319,10 +1227,151 @@ string Storage::getFileIdByName(string fileName, string folderId)
 
 map<string, File*> Storage::getAllFiles()
 {
-    return files;
+    ReadGuard guard(*this);
+    map<string, File*> all;
+    for (size_t i = 0; i < files.size(); i++)
+        if (File *file = files.get(i))
+            all[file->getId()] = file;
+    return all;
 }
 
 map<string, Folder*> Storage::getAllFolders()
 {
-    return folders;
+    ReadGuard guard(*this);
+    map<string, Folder*> all;
+    for (size_t i = 0; i < folders.size(); i++)
+        if (Folder *folder = folders.get(i))
+            all[folder->getId()] = folder;
+    return all;
+}
+
+void Storage::setIoBackend(IoBackend *backend)
+{
+    WriteGuard guard(*this);
+    ioBackend->flush();
+    if (journal)
+        journal->setBackend(*backend);
+    delete ioBackend;
+    ioBackend = backend;
+}
+
+IoBackend &Storage::getIoBackend()
+{
+    return *ioBackend;
+}
+
+bool Storage::openJournal(const string &path)
+{
+    WriteGuard guard(*this);
+    Journal *opened = new Journal(*ioBackend, path);
+    if (!opened->isOpen())
+    {
+        delete opened;
+        return false;
+    }
+    delete journal;
+    journal = opened;
+    return true;
+}
+
+void Storage::saveSnapshot(Session &session, const string &path)
+{
+    lock_guard<mutex> saving(snapshotMutex);
+    ostream &out = session.getOutput();
+    // Entered before the cut and held until the snapshot is written, so
+    // nothing in the cut is freed even if writers replace it meanwhile
+    ReadGuard pin(*this);
+    TreeCut cut;
+    uint64_t mark = 0;
+    {
+        // Writers wait only while the tables' pointers are copied, so the
+        // cut and the journal split cleanly
+        WriteGuard guard(*this);
+        cut.root = ROOT_INDEX;
+        cut.children.resize(tree.size());
+        for (size_t i = 0; i < cut.children.size(); i++)
+            cut.children[i] = tree.get(i);
+        cut.folders.resize(folders.size());
+        for (size_t i = 0; i < cut.folders.size(); i++)
+            cut.folders[i] = folders.get(i);
+        cut.files.resize(files.size());
+        for (size_t i = 0; i < cut.files.size(); i++)
+            cut.files[i] = files.get(i);
+        if (journal)
+            mark = journal->mark();
+    }
+    size_t records;
+    if (!Journal::writeSnapshot(cut, *ioBackend, path, records))
+    {
+        out << "     " << "Could not save snapshot to " << path << endl;
+        return;
+    }
+    if (journal && !journal->dropBefore(mark))
+        out << "     " << "Could not trim the journal; it still holds records the snapshot covers" << endl;
+    out << "     " << "Snapshot saved to " << path << " (" << records << " records)" << endl;
+}
+
+void Storage::restore(Session &session, const string &path)
+{
+    ostream &out = session.getOutput();
+    size_t records;
+    if (!Journal::replay(*this, path, records))
+    {
+        out << "     " << "Could not read " << path << endl;
+        return;
+    }
+    out << "     " << "Restored " << records << " records from " << path << endl;
+}
+
+void Storage::submitWrites()
+{
+    if (journal)
+        journal->submit();
+}
+
+void Storage::flushWrites()
+{
+    if (journal)
+        journal->flush();
+    ioBackend->flush();
+}
+
+SlowCommandLog &Storage::getSlowCommandLog()
+{
+    return slowCommandLog;
+}
+
+OperationStats &Storage::getOperationStats()
+{
+    return operationStats;
+}
+
+BlobStore &Storage::getBlobStore()
+{
+    return blobs;
+}
+
+size_t Storage::compactColdContent(size_t minBytes, uint64_t idlePasses)
+{
+    size_t compacted = blobs.compactCold(minBytes, idlePasses);
+    // Hands the replaced strings to the EpochManager on release
+    WriteGuard guard(*this);
+    return compacted;
+}
+
+void Storage::enableColdTier(size_t minBytes, unsigned idleSeconds, size_t cacheBytes)
+{
+    blobs.setCacheLimit(cacheBytes);
+    if (compactor.joinable())
+        return;
+    compactor = thread([this, minBytes, idleSeconds]
+                       {
+        unique_lock<mutex> held(compactorMutex);
+        while (!compactorWake.wait_for(held, chrono::seconds(1), [this]
+                                       { return compactorStopping; }))
+        {
+            held.unlock();
+            compactColdContent(minBytes, idleSeconds);
+            held.lock();
+        } });
 }
@@ -0,0 +1,143 @@
+// src/storage/Trace.cpp
+
+#include "../../include/storage/Trace.h"
+#include <mutex>
+#include <vector>
+#include <iomanip>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+using namespace std;
+
+namespace
+{
+    struct TraceEvent
+    {
+        const char *category;
+        const char *name;
+        uint64_t start;
+        uint64_t duration;
+        uint32_t thread;
+    };
+
+    // Written only by the thread that owns it; the lock is there so an
+    // export can read it at any time, and is otherwise never contended
+    struct TraceBuffer
+    {
+        mutex lock;
+        vector<TraceEvent> events;
+        uint64_t written = 0;
+    };
+
+    // Never destroyed, so threads that exit during shutdown can still
+    // return their buffers
+    struct Registry
+    {
+        mutex lock;
+        vector<TraceBuffer *> buffers;
+        vector<TraceBuffer *> idle;
+        uint64_t origin = 0;
+    };
+
+    Registry &registry()
+    {
+        static Registry *instance = new Registry();
+        return *instance;
+    }
+
+    // Hands the buffer back when its thread exits
+    struct ThreadBuffer
+    {
+        TraceBuffer *buffer = nullptr;
+        uint32_t thread = 0;
+
+        TraceBuffer *get()
+        {
+            if (buffer)
+                return buffer;
+            thread = uint32_t(syscall(SYS_gettid));
+            Registry &shared = registry();
+            lock_guard<mutex> held(shared.lock);
+            if (!shared.idle.empty())
+            {
+                buffer = shared.idle.back();
+                shared.idle.pop_back();
+            }
+            else
+            {
+                buffer = new TraceBuffer();
+                buffer->events.resize(Tracer::BUFFER_EVENTS);
+                shared.buffers.push_back(buffer);
+            }
+            return buffer;
+        }
+
+        ~ThreadBuffer()
+        {
+            if (!buffer)
+                return;
+            Registry &shared = registry();
+            lock_guard<mutex> held(shared.lock);
+            shared.idle.push_back(buffer);
+        }
+    };
+
+    thread_local ThreadBuffer local;
+}
+
+atomic<bool> Tracer::enabled{false};
+
+void Tracer::start()
+{
+    Registry &shared = registry();
+    lock_guard<mutex> held(shared.lock);
+    for (TraceBuffer *buffer : shared.buffers)
+    {
+        lock_guard<mutex> cleared(buffer->lock);
+        buffer->written = 0;
+    }
+    shared.origin = now();
+    enabled.store(true, memory_order_relaxed);
+}
+
+void Tracer::stop()
+{
+    enabled.store(false, memory_order_relaxed);
+}
+
+void Tracer::record(const char *category, const char *name, uint64_t start, uint64_t end)
+{
+    TraceBuffer *buffer = local.get();
+    lock_guard<mutex> held(buffer->lock);
+    buffer->events[buffer->written % BUFFER_EVENTS] = {category, name, start, end - start, local.thread};
+    buffer->written++;
+}
+
+size_t Tracer::writeChromeJson(ostream &out)
+{
+    Registry &shared = registry();
+    lock_guard<mutex> held(shared.lock);
+    size_t count = 0;
+    uint64_t dropped = 0;
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    out << fixed << setprecision(3);
+    for (TraceBuffer *buffer : shared.buffers)
+    {
+        lock_guard<mutex> reading(buffer->lock);
+        uint64_t first = buffer->written > BUFFER_EVENTS ? buffer->written - BUFFER_EVENTS : 0;
+        dropped += first;
+        for (uint64_t i = first; i < buffer->written; i++)
+        {
+            const TraceEvent &event = buffer->events[i % BUFFER_EVENTS];
+            // Spans that began before start() was called are clipped to 0
+            double ts = event.start > shared.origin ? (event.start - shared.origin) / 1000.0 : 0;
+            out << (count ? "," : "") << "\n{\"name\": \"" << event.name << "\", \"cat\": \"" << event.category
+                << "\", \"ph\": \"X\", \"ts\": " << ts << ", \"dur\": " << event.duration / 1000.0
+                << ", \"pid\": " << getpid() << ", \"tid\": " << event.thread << "}";
+            count++;
+        }
+    }
+    out << "\n], \"otherData\": {\"dropped_events\": " << dropped << "}}" << endl;
+    out << defaultfloat << setprecision(6);
+    return count;
+}